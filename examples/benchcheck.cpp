@@ -0,0 +1,616 @@
+/*
+   benchcheck.cpp : This file is part of pstoedit
+   Regression checks, run by "make bench" before the measurements.
+
+   usage: benchcheck lib
+            checks functions of the pstoedit library (TempFile, quantizeDecimal)
+          benchcheck laos text.lgc binary.lgb
+            decodes the output of "-f laos:-binary" (format in readme.laos)
+            and compares it with the text output of the same input
+          benchcheck gcode input.dump output.ngc tolerance
+            checks that the paths cut by "-f gcode:-compact -arcs" are within
+            tolerance (in points) of the paths of the input, and that the
+            radii of an arc to its start and end point are the same
+          benchcheck hpgl plain.hpgl pe.hpgl
+            decodes the PE commands of the output of "-f hpgl:-pe" and compares
+            the points with the PU/PD commands of the output without -pe
+
+   Prints one line per failed check and exits with 1 if a check failed.
+
+   Copyright (C) 1993 - 2012 Wolfgang Glunz, wglunz35_AT_pstoedit.net
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+#include "miscutil.h"
+
+#include I_stdio
+#include I_stdlib
+#include I_string_h
+#include I_fstream
+#include <math.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static unsigned int failures = 0;
+
+static void check(bool ok, const char * what, long got, long expected)
+{
+	if (!ok) {
+		printf("FAILED: %s: got %ld, expected %ld\n", what, got, expected);
+		failures++;
+	}
+}
+
+static void checkEqual(long got, long expected, const char * what)
+{
+	check(got == expected, what, got, expected);
+}
+
+// tellp of a TempFile is the number of bytes written so far - also before the
+// first write (drvpdf writes the /Length of a page stream from it)
+static void checkTempFilePosition(unsigned long memoryLimit)
+{
+	TempFile::setMemoryLimit(memoryLimit);
+	TempFile tempFile;
+	ostream & out = tempFile.asOutput();
+	checkEqual((long) out.tellp(), 0, "TempFile: tellp before the first write");
+	const unsigned long total = 200 * 1024;	// more than a few chunks
+	for (unsigned long i = 0; i < total; i++) {
+		out << (char) ('a' + i % 26);
+	}
+	checkEqual((long) out.tellp(), (long) total, "TempFile: tellp after writing");
+	istream & in = tempFile.asInput();
+	unsigned long n = 0;
+	bool sameData = true;
+	char c;
+	while (in.get(c)) {
+		sameData = sameData && (c == (char) ('a' + n % 26));
+		n++;
+	}
+	checkEqual((long) n, (long) total, "TempFile: bytes read back");
+	checkEqual(sameData, 1, "TempFile: data read back");
+	ostream & again = tempFile.asOutput();
+	checkEqual((long) again.tellp(), 0, "TempFile: tellp after reopening");
+}
+
+// quantizeDecimal rounds like printf - also at exact and nearly exact ties
+static void checkQuantizeDecimal()
+{
+	static const struct { double value; int digits; long expected; } cases[] = {
+		{ 2.5, 0, 2 }, { 3.5, 0, 4 }, { -2.5, 0, -2 }, { -3.5, 0, -4 },
+		{ 0.125, 2, 12 }, { 0.375, 2, 38 }, { -0.125, 2, -12 },
+		{ 1.005, 2, 100 },		// 1.00499999999999989...
+		{ 2.675, 2, 267 },		// 2.67499999999999982...
+		{ 0.0005, 3, 1 },		// 0.000500000000000000010...
+		{ 1234.5678, 3, 1234568 }, { -0.0004, 3, 0 }, { 0.0, 3, 0 }
+	};
+	for (unsigned int i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+		char what[100];
+		sprintf(what, "quantizeDecimal(%.17g, %d)", cases[i].value, cases[i].digits);
+		checkEqual((long) quantizeDecimal(cases[i].value, cases[i].digits), cases[i].expected, what);
+	}
+	// the same as the C library for many values with 3 or 4 decimals, which
+	// are all close to a tie for 2 resp. 3 digits
+	for (long k = -200000; k <= 200000; k++) {
+		const double value = k / 10000.0;
+		for (int digits = 2; digits <= 3; digits++) {
+			char text[100];
+			sprintf(text, "%.*f", digits, value);
+			const long expected = strtol(text, 0, 10) * (digits == 2 ? 100 : 1000) +
+				((value < 0) ? -1 : 1) * strtol(strchr(text, '.') + 1, 0, 10);
+			const long got = (long) quantizeDecimal(value, digits);
+			if (got != expected) {
+				char what[100];
+				sprintf(what, "quantizeDecimal(%.17g, %d)", value, digits);
+				checkEqual(got, expected, what);
+			}
+		}
+	}
+}
+
+static void checkLibrary()
+{
+	checkTempFilePosition(32UL * 1024UL * 1024UL);
+	checkTempFilePosition(64 * 1024);	// spilled to a file
+	checkQuantizeDecimal();
+}
+
+// a command of a laos job: the command number and its numbers - coordinates in
+// units of 10^-digits, other parameters rounded to whole numbers
+struct LaosCommand {
+	long long command;
+	std::vector<long long> values;
+	bool operator==(const LaosCommand & other) const { return (command == other.command) && (values == other.values); }
+};
+
+static long long roundToInteger(double value)
+{
+	return (value < 0.0) ? -(long long) (-value + 0.5) : (long long) (value + 0.5);
+}
+
+static bool readVarint(istream & in, unsigned long long & value)
+{
+	value = 0;
+	for (unsigned int shift = 0; shift < 64; shift += 7) {
+		const int c = in.get();
+		if (c == EOF) return false;
+		value |= (unsigned long long) (c & 0x7f) << shift;
+		if (!(c & 0x80)) return true;
+	}
+	return false;
+}
+
+static bool readSignedVarint(istream & in, long long & value)
+{
+	unsigned long long u;
+	if (!readVarint(in, u)) return false;
+	value = (long long) (u >> 1) ^ -(long long) (u & 1);
+	return true;
+}
+
+// the decoder of readme.laos
+static bool decodeLaosBinary(const char * filename, std::vector<LaosCommand> & commands, int & digits)
+{
+	ifstream in(filename, ios::in | ios::binary);
+	char magic[4];
+	if (!in.read(magic, 4) || (strncmp(magic, "LGCB", 4) != 0) || (in.get() != 1)) {
+		printf("FAILED: %s is not a laos binary job (version 1)\n", filename);
+		return false;
+	}
+	digits = in.get();
+	long long x = 0, y = 0;
+	unsigned long long command;
+	while (readVarint(in, command)) {
+		LaosCommand decoded;
+		decoded.command = (long long) command;
+		bool ok = true;
+		if ((command == 0) || (command == 1)) {
+			long long dx = 0, dy = 0;
+			ok = readSignedVarint(in, dx) && readSignedVarint(in, dy);
+			x += dx;
+			y += dy;
+			decoded.values.push_back(x);
+			decoded.values.push_back(y);
+		} else if (command == 9) {
+			unsigned long long bits = 0, columns = 0, n = 0;
+			ok = readVarint(in, bits) && readVarint(in, columns) && readVarint(in, n);
+			decoded.values.push_back((long long) bits);
+			decoded.values.push_back((long long) columns);
+			for (unsigned long long i = 0; ok && (i < n); i++) {
+				unsigned char le[4];
+				ok = (bool) in.read((char *) le, 4);
+				decoded.values.push_back((long long) (le[0] | (le[1] << 8) | (le[2] << 16) | ((unsigned long) le[3] << 24)));
+			}
+		} else {
+			unsigned long long n = 0;
+			ok = readVarint(in, n);
+			for (unsigned long long i = 0; ok && (i < n); i++) {
+				long long parameter = 0;
+				ok = readSignedVarint(in, parameter);
+				decoded.values.push_back(parameter);
+			}
+		}
+		if (!ok) {
+			printf("FAILED: %s: command %lu is truncated\n", filename, (unsigned long) commands.size() + 1);
+			return false;
+		}
+		commands.push_back(decoded);
+	}
+	return true;
+}
+
+static bool readLaosText(const char * filename, int digits, std::vector<LaosCommand> & commands)
+{
+	ifstream in(filename);
+	if (!in) {
+		printf("FAILED: cannot open %s\n", filename);
+		return false;
+	}
+	double scale = 1.0;
+	for (int i = 0; i < digits; i++) scale *= 10.0;
+	std::string line;
+	while (getline(in, line)) {
+		if (line.empty() || (line[0] == ';')) continue;
+		std::istringstream fields(line);
+		LaosCommand command;
+		double value;
+		if (!(fields >> command.command)) continue;
+		const bool coordinate = (command.command == 0) || (command.command == 1);
+		while (fields >> value) command.values.push_back(roundToInteger(coordinate ? value * scale : value));
+		commands.push_back(command);
+	}
+	return true;
+}
+
+static void checkLaosBinary(const char * textFile, const char * binaryFile)
+{
+	std::vector<LaosCommand> fromText, fromBinary;
+	int digits = 0;
+	if (!decodeLaosBinary(binaryFile, fromBinary, digits) || !readLaosText(textFile, digits, fromText)) {
+		failures++;
+		return;
+	}
+	const size_t n = (fromText.size() < fromBinary.size()) ? fromText.size() : fromBinary.size();
+	for (size_t i = 0; i < n; i++) {
+		if (!(fromText[i] == fromBinary[i])) {
+			printf("FAILED: laos: command %lu differs (%lld with %lu values in the text, %lld with %lu values in the binary job)\n",
+				   (unsigned long) i + 1, fromText[i].command, (unsigned long) fromText[i].values.size(),
+				   fromBinary[i].command, (unsigned long) fromBinary[i].values.size());
+			failures++;
+			return;
+		}
+	}
+	checkEqual((long) fromBinary.size(), (long) fromText.size(), "laos: number of commands in the binary job");
+}
+
+// a point of a path, in points
+struct PathPoint {
+	double x, y;
+	PathPoint(double x_p = 0.0, double y_p = 0.0) : x(x_p), y(y_p) {}
+};
+typedef std::vector<PathPoint> Polyline;
+
+static PathPoint bezierPoint(double t, const PathPoint & p0, const PathPoint & p1, const PathPoint & p2, const PathPoint & p3)
+{
+	const double s = 1.0 - t;
+	return PathPoint(s * s * s * p0.x + 3.0 * s * s * t * p1.x + 3.0 * s * t * t * p2.x + t * t * t * p3.x,
+					 s * s * s * p0.y + 3.0 * s * s * t * p1.y + 3.0 * s * t * t * p2.y + t * t * t * p3.y);
+}
+
+// the subpaths of a dump file (as written by benchgen), curves are flattened to
+// chords within precision of the curve
+static bool readDumpPaths(const char * filename, double precision, std::vector<Polyline> & paths)
+{
+	ifstream in(filename);
+	if (!in) {
+		printf("FAILED: cannot open %s\n", filename);
+		return false;
+	}
+	std::string line;
+	while (getline(in, line)) {
+		std::istringstream fields(line);
+		std::vector<double> numbers;
+		std::string word;
+		while (fields >> word) {
+			char * end = 0;
+			const double value = strtod(word.c_str(), &end);
+			if (*end != '\0') break;
+			numbers.push_back(value);
+		}
+		if ((word == "moveto") && (numbers.size() == 2)) {
+			paths.push_back(Polyline());
+			paths.back().push_back(PathPoint(numbers[0], numbers[1]));
+		} else if (paths.empty()) {
+			continue;
+		} else if ((word == "lineto") && (numbers.size() == 2)) {
+			paths.back().push_back(PathPoint(numbers[0], numbers[1]));
+		} else if ((word == "curveto") && (numbers.size() == 6)) {
+			const PathPoint p0 = paths.back().back();
+			const PathPoint p1(numbers[0], numbers[1]), p2(numbers[2], numbers[3]), p3(numbers[4], numbers[5]);
+			// n chords deviate at most max |B''| / (8 n^2) from the curve
+			const double d1 = hypot(p0.x - 2.0 * p1.x + p2.x, p0.y - 2.0 * p1.y + p2.y);
+			const double d2 = hypot(p1.x - 2.0 * p2.x + p3.x, p1.y - 2.0 * p2.y + p3.y);
+			const unsigned int n = 1 + (unsigned int) sqrt(6.0 * ((d1 > d2) ? d1 : d2) / (8.0 * precision));
+			for (unsigned int i = 1; i <= n; i++) {
+				paths.back().push_back(bezierPoint((double) i / n, p0, p1, p2, p3));
+			}
+		} else if (word == "closepath") {
+			paths.back().push_back(paths.back().front());
+		}
+	}
+	return true;
+}
+
+// the cut paths of the gcode output of -compact (absolute coordinates). Arcs are
+// flattened to chords within precision, a path starts with every plunge below
+// Z=0. unit is the resolution of the written coordinates (in points).
+static bool readGcodePaths(const char * filename, double precision, std::vector<Polyline> & paths, 
+						   double & unit, double & maxRadiusDifference)
+{
+	ifstream in(filename);
+	if (!in) {
+		printf("FAILED: cannot open %s\n", filename);
+		return false;
+	}
+	double scale = 72.0;		// points per unit, G20 (inch) or G21 (mm)
+	double x = 0.0, y = 0.0, z = 0.0;
+	int motion = 0;
+	unsigned int decimals = 0;
+	maxRadiusDifference = 0.0;
+	std::string line;
+	while (getline(in, line)) {
+		const std::string::size_type comment = line.find('(');
+		if (comment != std::string::npos) line.erase(comment);
+		std::istringstream fields(line);
+		std::string word;
+		double newX = x, newY = y, newZ = z, i = 0.0, j = 0.0;
+		bool move = false;
+		while (fields >> word) {
+			const double value = atof(word.c_str() + 1);
+			const std::string::size_type point = word.find('.');
+			if ((point != std::string::npos) && (word.length() - point - 1 > decimals)) decimals = word.length() - point - 1;
+			switch (word[0]) {
+			case 'G':
+				if ((value >= 0) && (value <= 3)) motion = (int) value;
+				if (value == 20) scale = 72.0;
+				if (value == 21) scale = 72.0 / 25.4;
+				break;
+			case 'X': newX = value * scale; move = true; break;
+			case 'Y': newY = value * scale; move = true; break;
+			case 'Z': newZ = value; move = true; break;
+			case 'I': i = value * scale; break;
+			case 'J': j = value * scale; break;
+			default: break;
+			}
+		}
+		if (!move) continue;
+		if ((newZ < 0.0) && (z >= 0.0)) {
+			paths.push_back(Polyline());
+			paths.back().push_back(PathPoint(newX, newY));
+		} else if ((newZ < 0.0) && ((motion == 2) || (motion == 3))) {
+			const double cx = x + i, cy = y + j;
+			const double startRadius = hypot(x - cx, y - cy);
+			const double endRadius = hypot(newX - cx, newY - cy);
+			if (fabs(endRadius - startRadius) > maxRadiusDifference) maxRadiusDifference = fabs(endRadius - startRadius);
+			const double startAngle = atan2(y - cy, x - cx);
+			double sweep = atan2(newY - cy, newX - cx) - startAngle;
+			if ((motion == 3) && (sweep <= 0.0)) sweep += 2.0 * M_PI;
+			if ((motion == 2) && (sweep >= 0.0)) sweep -= 2.0 * M_PI;
+			// chords of an angle a deviate r (1 - cos(a/2)) from the arc
+			const double radius = (startRadius > endRadius) ? startRadius : endRadius;
+			const double maxStep = (radius > precision) ? 2.0 * acos(1.0 - precision / radius) : M_PI;
+			const unsigned int n = 1 + (unsigned int) (fabs(sweep) / maxStep);
+			for (unsigned int k = 1; k <= n; k++) {
+				const double t = (double) k / n;
+				const double r = startRadius + t * (endRadius - startRadius);
+				paths.back().push_back(PathPoint(cx + r * cos(startAngle + t * sweep), cy + r * sin(startAngle + t * sweep)));
+			}
+		} else if ((newZ < 0.0) && !paths.empty()) {
+			paths.back().push_back(PathPoint(newX, newY));
+		}
+		x = newX;
+		y = newY;
+		z = newZ;
+	}
+	unit = scale;
+	for (unsigned int d = 0; d < decimals; d++) unit /= 10.0;
+	return true;
+}
+
+static double distanceToSegment(const PathPoint & p, const PathPoint & a, const PathPoint & b)
+{
+	const double dx = b.x - a.x, dy = b.y - a.y;
+	const double len2 = dx * dx + dy * dy;
+	double t = (len2 > 0.0) ? ((p.x - a.x) * dx + (p.y - a.y) * dy) / len2 : 0.0;
+	if (t < 0.0) t = 0.0;
+	if (t > 1.0) t = 1.0;
+	return hypot(a.x + t * dx - p.x, a.y + t * dy - p.y);
+}
+
+// the distance of p to the polyline if it is within limit, otherwise the distance
+// to the nearest segment. The points of a cut path follow the input path, so the
+// search starts at the segment found for the previous point (segment).
+static double distanceToPolyline(const PathPoint & p, const Polyline & polyline, double limit, size_t & segment)
+{
+	for (size_t k = segment; k + 1 < polyline.size(); k++) {
+		const double d = distanceToSegment(p, polyline[k], polyline[k + 1]);
+		if (d <= limit) {
+			segment = k;
+			return d;
+		}
+	}
+	double best = hypot(p.x - polyline[0].x, p.y - polyline[0].y);
+	for (size_t k = 0; k + 1 < polyline.size(); k++) {
+		const double d = distanceToSegment(p, polyline[k], polyline[k + 1]);
+		if (d < best) {
+			best = d;
+			segment = k;
+		}
+	}
+	return best;
+}
+
+static void checkGcodeArcs(const char * dumpFile, const char * gcodeFile, double tolerance)
+{
+	// the reference and the arcs are flattened with a small fraction of the tolerance
+	const double precision = tolerance / 20.0;
+	std::vector<Polyline> input, output;
+	double unit = 0.0, maxRadiusDifference = 0.0;
+	if (!readDumpPaths(dumpFile, precision, input) ||
+		!readGcodePaths(gcodeFile, precision, output, unit, maxRadiusDifference)) {
+		failures++;
+		return;
+	}
+	checkEqual((long) output.size(), (long) input.size(), "gcode: number of cut paths");
+	// the written points are at most rounding away from the exact ones, the radii
+	// to the start and end point of an arc differ at most by the rounding of these
+	// and of the center
+	const double rounding = unit * sqrt(2.0) / 2.0;
+	if (maxRadiusDifference > 4.0 * rounding) {
+		printf("FAILED: gcode: start and end radius of an arc differ by %g points, the resolution is %g points\n",
+			   maxRadiusDifference, unit);
+		failures++;
+	}
+	// the flattened input and arcs are within precision of the exact paths
+	const double limit = tolerance + 2.0 * precision + 2.0 * rounding;
+	double maxDeviation = 0.0;
+	const size_t n = (input.size() < output.size()) ? input.size() : output.size();
+	for (size_t p = 0; p < n; p++) {
+		const Polyline & cut = output[p];
+		size_t segment = 0;
+		for (size_t k = 0; k < cut.size(); k++) {
+			if (k > 0) {
+				const PathPoint mid((cut[k - 1].x + cut[k].x) / 2.0, (cut[k - 1].y + cut[k].y) / 2.0);
+				const double d = distanceToPolyline(mid, input[p], limit, segment);
+				if (d > maxDeviation) maxDeviation = d;
+			}
+			const double d = distanceToPolyline(cut[k], input[p], limit, segment);
+			if (d > maxDeviation) maxDeviation = d;
+		}
+		const PathPoint & end = cut.back();
+		const PathPoint & expectedEnd = input[p].back();
+		if (hypot(end.x - expectedEnd.x, end.y - expectedEnd.y) > rounding + precision) {
+			printf("FAILED: gcode: path %lu ends at %g %g instead of %g %g\n", (unsigned long) p + 1,
+				   end.x, end.y, expectedEnd.x, expectedEnd.y);
+			failures++;
+		}
+	}
+	if (maxDeviation > limit) {
+		printf("FAILED: gcode: the cut paths deviate up to %g points from the input, the tolerance is %g points\n",
+			   maxDeviation, tolerance);
+		failures++;
+	}
+}
+
+// a point of a plot, in plotter units; fractional for PE with fraction bits
+struct PlotPoint {
+	bool penDown;
+	double x, y;
+	PlotPoint(bool penDown_p, double x_p, double y_p) : penDown(penDown_p), x(x_p), y(y_p) {}
+};
+
+// the points of the PU and PD commands with coordinates
+static bool readPlainHPGL(const char * filename, std::vector<PlotPoint> & points)
+{
+	ifstream in(filename);
+	if (!in) {
+		printf("FAILED: cannot open %s\n", filename);
+		return false;
+	}
+	std::string command;
+	while (getline(in, command, ';')) {
+		const std::string::size_type start = command.find_first_not_of(" \r\n");
+		if ((start == std::string::npos) || (command.compare(start, 2, "PU") && command.compare(start, 2, "PD"))) continue;
+		long x = 0, y = 0;
+		if (sscanf(command.c_str() + start + 2, "%ld,%ld", &x, &y) == 2) {
+			points.push_back(PlotPoint(command[start + 1] == 'D', (double) x, (double) y));
+		}
+	}
+	return true;
+}
+
+// HP-GL/2 polyline encoded number: the last character of a number is in the
+// range of the terminators, which starts at 95 in 7 bit and at 191 in 8 bit mode
+static bool decodePENumber(const std::string & text, std::string::size_type & pos, bool sevenBit, long & value)
+{
+	const int terminators = sevenBit ? 95 : 191;
+	unsigned long n = 0;
+	for (unsigned int shift = 0; (pos < text.length()) && (shift < 8 * sizeof(long)); shift += sevenBit ? 5 : 6) {
+		const int c = (unsigned char) text[pos++];
+		if (c < 63) return false;
+		if (c >= terminators) {
+			n |= (unsigned long) (c - terminators) << shift;
+			value = (n & 1) ? -(long) (n >> 1) : (long) (n >> 1);
+			return true;
+		}
+		n |= (unsigned long) (c - 63) << shift;
+	}
+	return false;
+}
+
+// the points of the PE commands (the flags 7, >, < and = of print_coords_pe)
+static bool readPEHPGL(const char * filename, std::vector<PlotPoint> & points)
+{
+	ifstream in(filename, ios::in | ios::binary);
+	if (!in) {
+		printf("FAILED: cannot open %s\n", filename);
+		return false;
+	}
+	std::string command;
+	while (getline(in, command, ';')) {
+		const std::string::size_type start = command.find("PE");
+		if ((start == std::string::npos) || command.find_first_not_of(" \r\n") != start) continue;
+		bool sevenBit = false, penUp = false, absolute = false;
+		double scale = 1.0;
+		long x = 0, y = 0;
+		std::string::size_type pos = start + 2;
+		while (pos < command.length()) {
+			const char c = command[pos];
+			if (c == '7') {
+				sevenBit = true;
+				pos++;
+			} else if (c == '>') {
+				long fractionBits = 0;
+				pos++;
+				if (!decodePENumber(command, pos, sevenBit, fractionBits)) break;
+				scale = (double) (1L << fractionBits);
+			} else if (c == '<') {
+				penUp = true;
+				pos++;
+			} else if (c == '=') {
+				absolute = true;
+				pos++;
+			} else {
+				long dx = 0, dy = 0;
+				if (!decodePENumber(command, pos, sevenBit, dx) || !decodePENumber(command, pos, sevenBit, dy)) {
+					printf("FAILED: %s: PE command %s is truncated\n", filename, command.c_str() + start);
+					return false;
+				}
+				x = absolute ? dx : x + dx;
+				y = absolute ? dy : y + dy;
+				points.push_back(PlotPoint(!penUp, x / scale, y / scale));
+				penUp = false;
+				absolute = false;
+			}
+		}
+	}
+	return true;
+}
+
+static void checkHPGLPolylineEncoded(const char * plainFile, const char * peFile)
+{
+	std::vector<PlotPoint> plain, encoded;
+	if (!readPlainHPGL(plainFile, plain) || !readPEHPGL(peFile, encoded)) {
+		failures++;
+		return;
+	}
+	const size_t n = (plain.size() < encoded.size()) ? plain.size() : encoded.size();
+	for (size_t i = 0; i < n; i++) {
+		// the plain coordinates are truncated to whole plotter units
+		if ((plain[i].penDown != encoded[i].penDown) ||
+			(fabs(plain[i].x - encoded[i].x) >= 1.0) || (fabs(plain[i].y - encoded[i].y) >= 1.0)) {
+			printf("FAILED: hpgl: point %lu is %s %g,%g in the PE commands and %s %g,%g in the PU/PD commands\n",
+				   (unsigned long) i + 1, encoded[i].penDown ? "PD" : "PU", encoded[i].x, encoded[i].y,
+				   plain[i].penDown ? "PD" : "PU", plain[i].x, plain[i].y);
+			failures++;
+			return;
+		}
+	}
+	checkEqual((long) encoded.size(), (long) plain.size(), "hpgl: number of points in the PE commands");
+}
+
+int main(int argc, char **argv)
+{
+	if ((argc == 2) && (strcmp(argv[1], "lib") == 0)) {
+		checkLibrary();
+	} else if ((argc == 4) && (strcmp(argv[1], "laos") == 0)) {
+		checkLaosBinary(argv[2], argv[3]);
+	} else if ((argc == 5) && (strcmp(argv[1], "gcode") == 0)) {
+		checkGcodeArcs(argv[2], argv[3], atof(argv[4]));
+	} else if ((argc == 4) && (strcmp(argv[1], "hpgl") == 0)) {
+		checkHPGLPolylineEncoded(argv[2], argv[3]);
+	} else {
+		fprintf(stderr, "usage: %s lib | laos text.lgc binary.lgb | gcode input.dump output.ngc tolerance | hpgl plain.hpgl pe.hpgl\n", argv[0]);
+		return 2;
+	}
+	if (failures) {
+		printf("%u check(s) failed\n", failures);
+		return 1;
+	}
+	return 0;
+}
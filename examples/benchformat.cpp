@@ -0,0 +1,216 @@
+/*
+   benchformat.cpp : This file is part of pstoedit
+   Measures the cost per coordinate of the number formatting functions of
+   miscutil compared to the stream operators used by the backends before.
+
+   It is built and run by "make bench".
+   usage: benchformat [number of coordinates (default 2000000) [number of laos moves (default 10000000)]]
+
+   The result is printed as CSV:
+     method,coordinates,seconds,nanoseconds_per_coordinate,bytes
+   The "laos move" lines emit "0 x y" commands like drvlaos, once with the
+   Substitute functions it used before (for a tenth of the moves only, they
+   are slow) and once like drvLAOS::writeCoord. The texts of both are compared.
+
+   Copyright (C) 1993 - 2012 Wolfgang Glunz, wglunz35_AT_pstoedit.net
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+#include "miscutil.h"
+
+#include I_stdio
+#include I_stdlib
+#include <time.h>
+#include <sstream>
+#include <iomanip>
+#include <string>
+
+// the output goes to a stream without a file, so only the formatting is measured
+class CountingBuffer : public streambuf {
+public:
+	CountingBuffer() : count(0) { setp(area, area + sizeof(area)); }
+	unsigned long bytes() const { return count + (unsigned long) (pptr() - pbase()); }
+protected:
+	int_type overflow(int_type ch) {
+		count += (unsigned long) (pptr() - pbase());
+		setp(area, area + sizeof(area));
+		if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+			*pptr() = traits_type::to_char_type(ch);
+			pbump(1);
+		}
+		return traits_type::not_eof(ch);
+	}
+private:
+	char area[64 * 1024];
+	unsigned long count;
+};
+
+// coordinates like in a typical page: points with up to 3 decimals
+static float * makeCoordinates(unsigned long n)
+{
+	float * values = new float[n];
+	unsigned long seed = 12345;
+	for (unsigned long i = 0; i < n; i++) {
+		seed = seed * 1103515245UL + 12345UL;
+		values[i] = (float) ((seed >> 8) % 612000) / 1000.0f;
+	}
+	return values;
+}
+
+static void report(const char * method, unsigned long n, clock_t start, unsigned long bytes)
+{
+	const double seconds = (double) (clock() - start) / CLOCKS_PER_SEC;
+	printf("%s,%lu,%.3f,%.1f,%lu\n", method, n, seconds, seconds * 1e9 / n, bytes);
+}
+
+// defaults of drvlaos (*Scale: pt to micrometers, *Digits)
+static const double laosScale = 352.777777778;
+static const int laosDigits = 0;
+
+// drvLAOS::Substitute as it was before it got replaced by writeCoord
+static void laosSubstitute(std::string & src, const std::string & key, double value)
+{
+	std::stringstream ss;
+	ss << setiosflags(ios::fixed) << setprecision(laosDigits) << laosScale * value;
+	const size_t pos = src.find(key);
+	if (pos != std::string::npos) src.replace(pos, key.size(), ss.str());
+}
+
+static std::string laosMoveBySubstitute(float x, float y)
+{
+	std::string s = "0 _x_ _y_\n";
+	laosSubstitute(s, "_x_", x);
+	laosSubstitute(s, "_y_", y);
+	return s;
+}
+
+// like drvLAOS::emitCoord/writeCoord
+static unsigned int laosMove(char * line, float x, float y)
+{
+	unsigned int len = 0;
+	line[len++] = '0';
+	line[len++] = ' ';
+	len += formatQuantized(line + len, quantizeDecimal(laosScale * x, laosDigits), laosDigits, false);
+	line[len++] = ' ';
+	len += formatQuantized(line + len, quantizeDecimal(laosScale * y, laosDigits), laosDigits, false);
+	line[len++] = '\n';
+	return len;
+}
+
+static void benchLaosMoves(const float * values, unsigned long n, unsigned long moves)
+{
+	const unsigned long oldMoves = moves / 10 ? moves / 10 : 1;
+	{
+		CountingBuffer sink;
+		ostream out(&sink);
+		const clock_t start = clock();
+		for (unsigned long i = 0; i < oldMoves; i++) out << laosMoveBySubstitute(values[(2 * i) % n], values[(2 * i + 1) % n]);
+		report("laos move Substitute", 2 * oldMoves, start, sink.bytes());
+	}
+	{
+		CountingBuffer sink;
+		ostream out(&sink);
+		char line[64];
+		const clock_t start = clock();
+		for (unsigned long i = 0; i < moves; i++) out.write(line, laosMove(line, values[(2 * i) % n], values[(2 * i + 1) % n]));
+		report("laos move writeCoord", 2 * moves, start, sink.bytes());
+	}
+	unsigned long differences = 0;
+	for (unsigned long i = 0; i < oldMoves; i++) {
+		char line[64];
+		const float x = values[(2 * i) % n], y = values[(2 * i + 1) % n];
+		if (laosMoveBySubstitute(x, y) != std::string(line, laosMove(line, x, y))) differences++;
+	}
+	if (differences) {
+		fprintf(stderr, "laos move: %lu of %lu lines differ from the Substitute output\n", differences, oldMoves);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	const unsigned long n = (argc > 1) ? strtoul(argv[1], 0, 10) : 2000000UL;
+	const unsigned long moves = (argc > 2) ? strtoul(argv[2], 0, 10) : 10000000UL;
+	if ((n == 0) || (moves == 0)) {
+		fprintf(stderr, "usage: %s [number of coordinates [number of laos moves]]\n", argv[0]);
+		return 1;
+	}
+	const float * const values = makeCoordinates(n);
+	char buf[numberBufferSize];
+	printf("method,coordinates,seconds,nanoseconds_per_coordinate,bytes\n");
+
+	{
+		CountingBuffer sink;
+		ostream out(&sink);
+		const clock_t start = clock();
+		for (unsigned long i = 0; i < n; i++) out << values[i] << ' ';
+		report("ostream <<", n, start, sink.bytes());
+	}
+	{
+		CountingBuffer sink;
+		ostream out(&sink);
+		const clock_t start = clock();
+		for (unsigned long i = 0; i < n; i++) out << NumberText(values[i]) << ' ';
+		report("NumberText", n, start, sink.bytes());
+	}
+	{
+		unsigned long bytes = 0;
+		const clock_t start = clock();
+		for (unsigned long i = 0; i < n; i++) bytes += formatGeneral(buf, values[i]) + 1;
+		report("formatGeneral", n, start, bytes);
+	}
+	{
+		CountingBuffer sink;
+		ostream out(&sink);
+		out << setiosflags(ios::fixed) << setprecision(3);
+		const clock_t start = clock();
+		for (unsigned long i = 0; i < n; i++) out << values[i] << ' ';
+		report("ostream << fixed", n, start, sink.bytes());
+	}
+	{
+		unsigned long bytes = 0;
+		const clock_t start = clock();
+		for (unsigned long i = 0; i < n; i++) bytes += formatFixed(buf, values[i], 3) + 1;
+		report("formatFixed", n, start, bytes);
+	}
+	{
+		unsigned long bytes = 0;
+		const clock_t start = clock();
+		for (unsigned long i = 0; i < n; i++) bytes += formatQuantized(buf, quantizeDecimal(values[i], 3), 3, true) + 1;
+		report("formatQuantized", n, start, bytes);
+	}
+	{
+		unsigned long bytes = 0;
+		const clock_t start = clock();
+		for (unsigned long i = 0; i < n; i++) bytes += formatShortest(buf, values[i]) + 1;
+		report("formatShortest", n, start, bytes);
+	}
+	{
+		unsigned long bytes = 0;
+		const clock_t start = clock();
+		for (unsigned long i = 0; i < n; i++) bytes += (unsigned long) sprintf_s(TARGETWITHLEN(buf, sizeof(buf)), "%.9g", values[i]) + 1;
+		report("printf %.9g", n, start, bytes);
+	}
+	{
+		unsigned long bytes = 0;
+		const clock_t start = clock();
+		for (unsigned long i = 0; i < n; i++) bytes += formatInteger(buf, (long) (values[i] * 10.0f)) + 1;
+		report("formatInteger", n, start, bytes);
+	}
+	benchLaosMoves(values, n, moves);
+	delete[] values;
+	return 0;
+}
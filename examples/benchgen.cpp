@@ -0,0 +1,289 @@
+/*
+   benchgen.cpp : This file is part of pstoedit
+   Generates synthetic input for the benchmark suite (see benchsuite.sh) in the
+   intermediate format of pstoedit (-f dump), so that the backends can be
+   measured with -bo without running Ghostscript.
+
+   usage: benchgen kind n outputfile
+     paths    100 paths with n points each (lines and curves, stroked and filled)
+     subpaths n closed subpaths, 1000 per filled path
+     text     n text pieces, spread over pages of 100 pieces
+     image    a n x n RGB image with 8 bits per component
+     pages    n pages with 50 short paths each
+     colors   n stroked paths with 500 points each, every path in its own color
+     palette  n stroked lines, every line in its own color (n distinct colors)
+
+   Copyright (C) 1993 - 2012 Wolfgang Glunz, wglunz35_AT_pstoedit.net
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// fixed sequence, so that every run measures the same input
+static unsigned long seed = 12345;
+static unsigned long nextRandom()
+{
+	seed = seed * 1103515245UL + 12345UL;
+	return (seed >> 8) & 0xffffff;
+}
+
+// coordinate within the page (612 x 792 points) with up to 3 decimals
+static double coordinate(double limit)
+{
+	return (double) (nextRandom() % (unsigned long) (limit * 1000)) / 1000.0;
+}
+
+static void writeHeader(FILE * out)
+{
+	fputs("%!PS-Adobe-3.0\n"
+		  "%%Title: pstoedit benchmark\n"
+		  "%%Creator: benchgen\n"
+		  "%%BoundingBox: (atend)\n"
+		  "%%Pages: (atend)\n"
+		  "%%EndComments\n"
+		  "%%BeginProlog\n"
+		  "/setPageSize { pop pop } def\n"
+		  "/ntranslate { neg exch neg exch translate } def\n"
+		  "/p2esetcolorname { pop } def\n"
+		  "/setshowparams { pop pop pop} def\n"
+		  "/backendconstraints { pop pop } def\n"
+		  "%%EndProlog\n", out);
+}
+
+static void beginPage(FILE * out, unsigned long page)
+{
+	fprintf(out, "%%%%Page: %lu %lu\n0 0 backendconstraints\n", page, page);
+}
+
+static void endPage(FILE * out)
+{
+	fputs("showpage\n%%BoundingBox: 0 0 612 792\n", out);
+}
+
+static void writeTrailer(FILE * out, unsigned long pages)
+{
+	fprintf(out, "%%%%Trailer\n%%%%Pages: %lu\n%%%%EOF\n", pages);
+}
+
+// red and black thin lines are what the laser cutter backend (laos) cuts and marks
+static const char * const colors[] = { "1 0 0", "0 0 0", "0 0 1", "0 0.5 0", "0.8 0.6 0.2" };
+
+static void beginPath(FILE * out, unsigned long number, double linewidth)
+{
+	fprintf(out, "%% %lu pathnumber\n"
+			"0 setlinecap\n10 setmiterlimit\n0 setlinejoin\n[ ] 0 setdash\n"
+			"%g setlinewidth\n%s setrgbcolor\nnewpath\n",
+			number, linewidth, colors[nextRandom() % (sizeof(colors) / sizeof(colors[0]))]);
+}
+
+// every fourth segment is a curve
+static void writeSegments(FILE * out, unsigned long points)
+{
+	fprintf(out, "%g %g moveto\n", coordinate(612), coordinate(792));
+	for (unsigned long i = 1; i < points; i++) {
+		if ((i % 4) == 0) {
+			fprintf(out, "%g %g %g %g %g %g curveto\n",
+					coordinate(612), coordinate(792), coordinate(612), coordinate(792), coordinate(612), coordinate(792));
+		} else {
+			fprintf(out, "%g %g lineto\n", coordinate(612), coordinate(792));
+		}
+	}
+}
+
+static void generatePaths(FILE * out, unsigned long n)
+{
+	beginPage(out, 1);
+	for (unsigned long p = 1; p <= 100; p++) {
+		beginPath(out, p, 0.5);
+		writeSegments(out, n);
+		fputs((p % 2) ? "stroke\n" : "closepath\nfill\n", out);
+	}
+	endPage(out);
+	writeTrailer(out, 1);
+}
+
+static void generateSubpaths(FILE * out, unsigned long n)
+{
+	// the backends limit the number of elements per path (drvbase::maxElements)
+	const unsigned long perPath = 1000;
+	beginPage(out, 1);
+	for (unsigned long s = 0; s < n; s++) {
+		if ((s % perPath) == 0) {
+			if (s) fputs("eofill\n", out);
+			beginPath(out, s / perPath + 1, 0);
+		}
+		const double x = coordinate(600);
+		const double y = coordinate(780);
+		fprintf(out, "%g %g moveto\n%g %g lineto\n%g %g lineto\n%g %g lineto\nclosepath\n",
+				x, y, x + 10, y, x + 10, y + 10, x, y + 10);
+	}
+	fputs("eofill\n", out);
+	endPage(out);
+	writeTrailer(out, 1);
+}
+
+static void generateText(FILE * out, unsigned long n)
+{
+	static const char * const words[] = {
+		"pstoedit", "converts", "PostScript", "and", "PDF", "graphics", "into", "other", "vector", "formats"
+	};
+	static const char * const fonts[] = { "Helvetica", "Times-Roman", "Courier-Bold" };
+	unsigned long pages = 0;
+	for (unsigned long t = 0; t < n; t++) {
+		if ((t % 100) == 0) {
+			if (pages) endPage(out);
+			beginPage(out, ++pages);
+		}
+		const double size = (double) (6 + nextRandom() % 30);
+		const double x = coordinate(500);
+		const double y = coordinate(780);
+		const char * const word = words[nextRandom() % 10];
+		fprintf(out, "(%s) cvn findfont %g scalefont setfont\n", fonts[t % 3], size);
+		fprintf(out, "0 0 32 0 0 %g %g 1 setshowparams\n", x + size * 0.6 * strlen(word), y);
+		fprintf(out, "%g %g (%s %lu) awidthshow\n", x, y, word, t);
+	}
+	if (pages) endPage(out);
+	writeTrailer(out, pages);
+}
+
+static void generateImage(FILE * out, unsigned long n)
+{
+	beginPage(out, 1);
+	const double scale = 500.0 / (double) n;
+	fprintf(out, "%%colorimage:begin\n"
+			"%% DC %lu\n%%colorimage:width\n"
+			"%% DC %lu\n%%colorimage:height\n"
+			"%% DC 8\n%%colorimage:bits\n"
+			"%% DC 1 0 0 1 0 0\n%%colorimage:imagematrix\n"
+			"%% DC %g 0 0 %g 50 150\n%%colorimage:normalized image currentmatrix\n"
+			"%% DC 0\n%%colorimage:multi\n"
+			"%% DC 3\n%%colorimage:ncomp\n", n, n, scale, scale);
+	// a smooth gradient with some noise - compresses like a photo, not like random data
+	static const char hex[] = "0123456789abcdef";
+	const unsigned long bytes = n * n * 3;
+	const unsigned long lineLength = 1024;
+	char line[2 * lineLength + 1];
+	unsigned long pos = 0;
+	for (unsigned long i = 0; i < bytes; i++) {
+		const unsigned long pixel = i / 3;
+		const unsigned long x = pixel % n;
+		const unsigned long y = pixel / n;
+		const unsigned int value = (unsigned int) ((((i % 3) == 0) ? x : (((i % 3) == 1) ? y : x + y)) * 255 / (2 * n) + nextRandom() % 16) & 0xff;
+		line[pos++] = hex[value >> 4];
+		line[pos++] = hex[value & 0xf];
+		if ((pos == 2 * lineLength) || (i + 1 == bytes)) {
+			line[pos] = 0;
+			fprintf(out, "%%colorimage:data %s\n", line);
+			pos = 0;
+		}
+	}
+	fputs("%colorimage:end\n", out);
+	endPage(out);
+	writeTrailer(out, 1);
+}
+
+static void generatePages(FILE * out, unsigned long n)
+{
+	for (unsigned long page = 1; page <= n; page++) {
+		beginPage(out, page);
+		for (unsigned long p = 1; p <= 50; p++) {
+			beginPath(out, p, 1);
+			writeSegments(out, 8);
+			fputs("stroke\n", out);
+		}
+		endPage(out);
+	}
+	writeTrailer(out, n);
+}
+
+// a color map: the color changes with every path, so drivers that map colors
+// (e.g. dxf to its palette and layers) do that for each path
+static void generateColors(FILE * out, unsigned long n)
+{
+	beginPage(out, 1);
+	for (unsigned long p = 0; p < n; p++) {
+		fprintf(out, "%% %lu pathnumber\n"
+				"0 setlinecap\n10 setmiterlimit\n0 setlinejoin\n[ ] 0 setdash\n"
+				"0.5 setlinewidth\n%g %g %g setrgbcolor\nnewpath\n",
+				p + 1, (p % 16) / 15.0, (p / 16 % 16) / 15.0, (p / 256 % 16) / 15.0);
+		fprintf(out, "%g %g moveto\n", coordinate(612), coordinate(792));
+		for (unsigned int i = 1; i < 500; i++) {
+			fprintf(out, "%g %g lineto\n", coordinate(612), coordinate(792));
+		}
+		fputs("stroke\n", out);
+	}
+	endPage(out);
+	writeTrailer(out, 1);
+}
+
+// many distinct colors with little geometry: the cost of mapping a color (nearest
+// palette entry, layer lookup) is not hidden behind the output of the points.
+// p * 2654435761 is a permutation of the 24 bit colors, so n <= 2^24 colors differ.
+static void generatePalette(FILE * out, unsigned long n)
+{
+	beginPage(out, 1);
+	for (unsigned long p = 0; p < n; p++) {
+		const unsigned long rgb = (p * 2654435761UL) & 0xFFFFFFUL;
+		fprintf(out, "%% %lu pathnumber\n"
+				"0 setlinecap\n10 setmiterlimit\n0 setlinejoin\n[ ] 0 setdash\n"
+				"0.5 setlinewidth\n%g %g %g setrgbcolor\nnewpath\n",
+				p + 1, (rgb >> 16) / 255.0, (rgb >> 8 & 0xFF) / 255.0, (rgb & 0xFF) / 255.0);
+		fprintf(out, "%g %g moveto\n", coordinate(612), coordinate(792));
+		fprintf(out, "%g %g lineto\n", coordinate(612), coordinate(792));
+		fputs("stroke\n", out);
+	}
+	endPage(out);
+	writeTrailer(out, 1);
+}
+
+int main(int argc, char **argv)
+{
+	const unsigned long n = (argc == 4) ? strtoul(argv[2], 0, 10) : 0;
+	if (n == 0) {
+		fprintf(stderr, "usage: %s paths|subpaths|text|image|pages|colors|palette n outputfile\n", argv[0]);
+		return 1;
+	}
+	FILE * out = fopen(argv[3], "w");
+	if (!out) {
+		fprintf(stderr, "%s: cannot open %s\n", argv[0], argv[3]);
+		return 1;
+	}
+	const char * const kind = argv[1];
+	writeHeader(out);
+	if (strcmp(kind, "paths") == 0) {
+		generatePaths(out, n);
+	} else if (strcmp(kind, "subpaths") == 0) {
+		generateSubpaths(out, n);
+	} else if (strcmp(kind, "text") == 0) {
+		generateText(out, n);
+	} else if (strcmp(kind, "image") == 0) {
+		generateImage(out, n);
+	} else if (strcmp(kind, "pages") == 0) {
+		generatePages(out, n);
+	} else if (strcmp(kind, "colors") == 0) {
+		generateColors(out, n);
+	} else if (strcmp(kind, "palette") == 0) {
+		generatePalette(out, n);
+	} else {
+		fprintf(stderr, "%s: unknown kind %s\n", argv[0], kind);
+		(void) fclose(out);
+		return 1;
+	}
+	return (fclose(out) == 0) ? 0 : 1;
+}
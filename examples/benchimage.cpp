@@ -0,0 +1,130 @@
+/*
+   benchimage.cpp : This file is part of pstoedit
+   Measures the cost per pixel of reading the samples of an image with
+   PSImage::getComponent (as the backends did before) compared to
+   PSImage::unpackRow, and of PSImage::resample into a device raster.
+
+   It is built and run by "make bench".
+   usage: benchimage [image width and height (default 3200, i.e. 10 megapixels)]
+
+   The result is printed as CSV:
+     method,bits,pixels,seconds,nanoseconds_per_pixel
+   The image is RGB with 8, 4 and 1 bit per component and pseudo random
+   samples. The rows of unpackRow are compared with getComponent.
+   The seconds are processor time (clock()), so for a resample done by
+   several OpenMP threads they are the sum over all threads.
+
+   Copyright (C) 1993 - 2012 Wolfgang Glunz, wglunz35_AT_pstoedit.net
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+#include "drvbase.h"
+
+#include I_stdio
+#include I_stdlib
+#include <time.h>
+#include <vector>
+
+// the sums of the samples go here, so that the compiler keeps the loops
+static volatile unsigned long sink;
+
+static void report(const char * method, int bits, unsigned long pixels, clock_t start)
+{
+	const double seconds = (double) (clock() - start) / CLOCKS_PER_SEC;
+	printf("%s,%d,%lu,%.3f,%.1f\n", method, bits, pixels, seconds, seconds * 1e9 / pixels);
+}
+
+// returns false if unpackRow and getComponent differ
+static bool benchImage(unsigned int size, int bits)
+{
+	PSImage image;
+	image.type = colorimage;
+	image.width = size;
+	image.height = size;
+	image.bits = (short int) bits;
+	image.ncomp = 3;
+	image.normalizedImageCurrentMatrix[0] = 1.0f;
+	image.normalizedImageCurrentMatrix[3] = 1.0f;
+	image.allocateData();
+	unsigned long seed = 12345;
+	for (unsigned int i = 0; i < image.dataSize(); i++) {
+		seed = seed * 1103515245UL + 12345UL;
+		image.data[i] = (unsigned char) (seed >> 16);
+	}
+	image.nextfreedataitem = image.dataSize();
+	image.calculateBoundingBox();
+	const unsigned long pixels = (unsigned long) size * size;
+
+	unsigned long sum = 0;
+	clock_t start = clock();
+	for (unsigned int y = 0; y < size; y++) {
+		for (unsigned int x = 0; x < size; x++) {
+			sum += image.getComponent(x, y, 0) + image.getComponent(x, y, 1) + image.getComponent(x, y, 2);
+		}
+	}
+	report("getComponent", bits, pixels, start);
+	sink = sum;
+
+	std::vector<unsigned char> row(3 * size);
+	std::vector<unsigned char> scratch(image.scratchSize());
+	sum = 0;
+	start = clock();
+	for (unsigned int y = 0; y < size; y++) {
+		image.unpackRow(y, &row[0], &scratch[0]);
+		sum += row[y % (3 * size)];
+	}
+	report("unpackRow", bits, pixels, start);
+	sink = sum;
+
+	// the same device raster as drvcairo and drvsvm use, at scale 1
+	const long scanlineLen = (3L * size + 3) & ~3L;
+	std::vector<unsigned char> raster(scanlineLen * size, 255);
+	Point lowerLeft, upperRight;
+	image.getBoundingBox(lowerLeft, upperRight);
+	start = clock();
+	image.resample(&raster[0], scanlineLen, size, size, lowerLeft, 1.0f);
+	report("resample", bits, pixels, start);
+
+	bool same = true;
+	for (unsigned int y = 0; same && (y < size); y += 61) {
+		image.unpackRow(y, &row[0], &scratch[0]);
+		for (unsigned int x = 0; same && (x < size); x++) {
+			for (char c = 0; c < 3; c++) {
+				same = same && (row[3 * x + c] == image.getComponent(x, y, c));
+			}
+		}
+	}
+	if (!same) {
+		fprintf(stderr, "unpackRow differs from getComponent for %d bit samples\n", bits);
+	}
+	return same;
+}
+
+int main(int argc, char **argv)
+{
+	const unsigned int size = (argc > 1) ? (unsigned int) strtoul(argv[1], 0, 10) : 3200;
+	if ((argc > 2) || (size == 0)) {
+		fprintf(stderr, "usage: %s [image width and height]\n", argv[0]);
+		return 1;
+	}
+	printf("method,bits,pixels,seconds,nanoseconds_per_pixel\n");
+	bool ok = true;
+	ok = benchImage(size, 8) && ok;
+	ok = benchImage(size, 4) && ok;
+	ok = benchImage(size, 1) && ok;
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,93 @@
+#!/bin/sh
+# Measures the output side of pstoedit backends: number of write system calls,
+# bytes written and wall clock time per input file and output format.
+#
+# usage: benchoutput.sh [-p pstoedit] [-f "format ..."] [-r repeats] [file.ps|file.dump ...]
+#
+# Each PostScript file (default: all examples in this directory) is converted
+# to a dump (-f dump) once, so Ghostscript is not part of the measurement.
+# Files ending in .dump are used as they are.
+# The dump is then converted with -bo to each format. The number of write
+# calls is taken from strace if it is available, otherwise "-" is reported.
+# The result is printed as CSV:
+#   input,format,seconds,writecalls,outputbytes
+#
+# To compare two builds run the script once with each pstoedit binary.
+
+PSTOEDIT=pstoedit
+FORMATS="pdf tk dxf fig hpgl gcode laos mpost java2 sk pic"
+REPEATS=1
+
+while getopts "p:f:r:" opt; do
+	case $opt in
+	p) PSTOEDIT=$OPTARG ;;
+	f) FORMATS=$OPTARG ;;
+	r) REPEATS=$OPTARG ;;
+	*) echo "usage: $0 [-p pstoedit] [-f \"format ...\"] [-r repeats] [file.ps|file.dump ...]" >&2; exit 1 ;;
+	esac
+done
+shift `expr $OPTIND - 1`
+
+if [ $# -eq 0 ]; then
+	set -- `dirname $0`/*.ps
+fi
+
+if strace -V >/dev/null 2>&1; then
+	HAVE_STRACE=1
+else
+	HAVE_STRACE=0
+fi
+
+TMPDIR=${TMPDIR:-/tmp}
+WORK=$TMPDIR/benchoutput.$$
+mkdir -p $WORK || exit 1
+trap 'rm -rf $WORK' 0 1 2 15
+
+now() {
+	# seconds with fractional part (falls back to whole seconds)
+	d=`date +%s.%N 2>/dev/null`
+	case $d in
+	*N) date +%s ;;
+	*) echo $d ;;
+	esac
+}
+
+echo "input,format,seconds,writecalls,outputbytes"
+for input in "$@"; do
+	case $input in
+	*.dump)
+		name=`basename $input .dump`
+		dump=$input
+		;;
+	*)
+		name=`basename $input .ps`
+		dump=$WORK/$name.dump
+		if ! $PSTOEDIT -q -f dump "$input" $dump >/dev/null 2>&1; then
+			echo "$name: conversion to dump failed" >&2
+			continue
+		fi
+		;;
+	esac
+	for format in $FORMATS; do
+		out=$WORK/$name.out
+		start=`now`
+		i=0
+		while [ $i -lt $REPEATS ]; do
+			$PSTOEDIT -q -f $format -bo $dump $out >/dev/null 2>&1
+			i=`expr $i + 1`
+		done
+		end=`now`
+		seconds=`echo "$start $end $REPEATS" | awk '{ printf "%.3f", ($2 - $1) / $3 }'`
+		writes=-
+		if [ $HAVE_STRACE = 1 ]; then
+			# count only the writes to the output file, not to stderr
+			writes=`strace -f -e trace=write,writev -o $WORK/strace.log \
+				$PSTOEDIT -q -f $format -bo $dump $out >/dev/null 2>&1; \
+				grep 'write[v]*(' $WORK/strace.log | grep -v 'write[v]*(2,' | wc -l | tr -d ' '`
+		fi
+		bytes=`wc -c < $out 2>/dev/null | tr -d ' '`
+		echo "$name,$format,$seconds,$writes,${bytes:-0}"
+		rm -f $out
+	done
+	[ $dump = $input ] || rm -f $dump
+done
@@ -0,0 +1,203 @@
+/*
+   benchreplay.cpp : This file is part of pstoedit
+   Replays a dump (output of -f dump) through the backends without running
+   pstoedit as a whole: the dump is loaded into memory once and converted
+   repeatedly by each selected driver, the output goes to the null device.
+   This measures the backend side only (lexer, drvbase and driver), so it
+   can be used to detect performance regressions of the drivers.
+
+   usage: benchreplay [-r repeats] [-d plugindir] [-v] dumpfile [format[:options] ...]
+
+   Without a format all registered drivers are run. The result is printed as CSV:
+     driver,repeats,seconds,paths,paths_per_second,megabytes_per_second
+   where the rates are per second of conversion time and megabytes are those
+   of the dump. The drivers are loaded from the plugin directory (default: the
+   installation directory), in the build tree this is src/.libs.
+
+   Copyright (C) 1993 - 2012 Wolfgang Glunz, wglunz35_AT_pstoedit.net
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+#include "pstoeditoptions.h"
+#include "drvbase.h"
+#include "psfront.h"
+#include "dynload.h"
+#include "runstats.h"
+
+#include I_fstream
+#include I_stdio
+#include I_stdlib
+#include I_string_h
+#include <vector>
+
+extern FILE *yyin;				// used by lexer
+
+#if defined(_WIN32)
+static const char nullDevice[] = "NUL";
+#else
+static const char nullDevice[] = "/dev/null";
+#endif
+
+// a FILE on the dump in memory, fmemopen is not available everywhere,
+// then a temporary file is used (which stays in the file cache)
+static FILE * openDump(const std::vector<char> & dump)
+{
+#if defined(_WIN32)
+	FILE * f = tmpfile();
+	if (f) {
+		(void) fwrite(&dump[0], 1, dump.size(), f);
+		rewind(f);
+	}
+	return f;
+#else
+	return fmemopen((void *) &dump[0], dump.size(), "rb");
+#endif
+}
+
+enum ReplayResult { replayed, creationFailed, noBackend };
+
+// one conversion of the dump
+static ReplayResult replay(const DriverDescription & desc, const char * driverOptions, const char * dumpName,
+				   const std::vector<char> & dump, PsToEditOptions & options, ostream & errstream)
+{
+	ofstream outFile(nullDevice);
+	drvbase * backend = desc.CreateBackend(driverOptions, outFile, errstream, dumpName, nullDevice, options);
+	if (!backend || !backend->driverOK()) {
+		delete backend;
+		return creationFailed;
+	}
+	if (!backend->withbackend()) {
+		// ps, psf, debug, dump, ... just copy the output of Ghostscript
+		delete backend;
+		return noBackend;
+	}
+	// the front end deletes the backend at the end of run
+	PSFrontEnd fe(outFile, errstream, options, dumpName, nullDevice, &desc, driverOptions, false, backend);
+	yyin = openDump(dump);
+	drvbase::totalNumberOfPages() = fe.readBBoxes(drvbase::bboxes());
+	fclose(yyin);
+	yyin = openDump(dump);
+	fe.run(options.mergelines);
+	fclose(yyin);
+	yyin = 0;
+	return replayed;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int repeats = 3;
+	const char * pluginDir = 0;
+	bool verbose = false;
+	int arg = 1;
+	for (; arg < argc && argv[arg][0] == '-'; arg++) {
+		if (strcmp(argv[arg], "-r") == 0 && arg + 1 < argc) {
+			repeats = (unsigned int) atoi(argv[++arg]);
+		} else if (strcmp(argv[arg], "-d") == 0 && arg + 1 < argc) {
+			pluginDir = argv[++arg];
+		} else if (strcmp(argv[arg], "-v") == 0) {
+			verbose = true;
+		} else {
+			break;
+		}
+	}
+	if ((arg >= argc) || (repeats == 0)) {
+		cerr << "usage: " << argv[0] << " [-r repeats] [-d plugindir] [-v] dumpfile [format[:options] ...]" << endl;
+		return 1;
+	}
+	const char * const dumpName = argv[arg++];
+
+	std::vector<char> dump;
+	{
+		FILE * in = fopen(dumpName, "rb");
+		if (!in) {
+			cerr << "cannot open " << dumpName << endl;
+			return 1;
+		}
+		char buffer[64 * 1024];
+		size_t n;
+		while ((n = fread(buffer, 1, sizeof(buffer), in)) > 0) dump.insert(dump.end(), buffer, buffer + n);
+		fclose(in);
+	}
+	if (dump.empty()) {
+		cerr << dumpName << " is empty" << endl;
+		return 1;
+	}
+
+#ifdef PSTOEDITLIBDIR
+	if (!pluginDir) pluginDir = PSTOEDITLIBDIR;
+#endif
+	loadPlugInDrivers(pluginDir, cerr, verbose);
+	const DescriptionRegister & drivers = *getglobalRp();
+
+	// the names of the drivers, either given or all registered ones
+	std::vector<RSString> formats;
+	for (; arg < argc; arg++) formats.push_back(RSString(argv[arg]));
+	const bool allDrivers = formats.empty();
+	if (allDrivers) {
+		for (int i = 0; i < drivers.nrOfDescriptions(); i++) {
+			formats.push_back(RSString(drivers.rp[i]->symbolicname));
+		}
+	}
+
+	ofstream nullStream(nullDevice);
+	ostream & errstream = verbose ? cerr : nullStream;
+	// some drivers write messages to cout, which would end up in the CSV
+	streambuf * const coutBuffer = cout.rdbuf(verbose ? cerr.rdbuf() : nullStream.rdbuf());
+	drvbase::SetVerbose(false);
+	int result = 0;
+	printf("driver,repeats,seconds,paths,paths_per_second,megabytes_per_second\n");
+	for (size_t f = 0; f < formats.size(); f++) {
+		// format[:options] as for -f
+		char * const name = cppstrdup(formats[f].value());
+		char * const colon = strchr(name, ':');
+		const char * driverOptions = "";
+		if (colon) {
+			*colon = '\0';
+			driverOptions = colon + 1;
+		}
+		const DriverDescription * desc = drivers.getDriverDescForName(name);
+		if (!desc) {
+			cerr << "unknown format " << name << endl;
+			delete[] name;
+			result = 1;
+			continue;
+		}
+		PsToEditOptions options;
+		RunStatistics::enable(true);
+		ReplayResult status = replayed;
+		const unsigned long long start = RunStatistics::now();
+		for (unsigned int r = 0; (status == replayed) && r < repeats; r++) {
+			status = replay(*desc, driverOptions, dumpName, dump, options, errstream);
+		}
+		const double seconds = (double) (RunStatistics::now() - start) / 1e9;
+		const unsigned long long paths = RunStatistics::value(RunStatistics::paths);
+		RunStatistics::enable(false);
+		if (status == replayed) {
+			const double megabytes = (double) dump.size() * repeats / 1e6;
+			printf("%s,%u,%.3f,%llu,%.0f,%.2f\n", name, repeats, seconds, paths / repeats,
+				   seconds > 0 ? paths / seconds : 0.0, seconds > 0 ? megabytes / seconds : 0.0);
+			fflush(stdout);
+		} else if (!allDrivers) {
+			// when running all drivers, those that cannot be used here are just skipped
+			cerr << ((status == noBackend) ? "no backend for format " : "creation of driver failed for format ") << name << endl;
+			result = 1;
+		}
+		delete[] name;
+	}
+	(void) cout.rdbuf(coutBuffer);
+	return result;
+}
@@ -0,0 +1,83 @@
+/*
+   benchrun.cpp : This file is part of pstoedit
+   Runs a command for the benchmark suite (see benchsuite.sh) and prints its
+   wall clock time and peak resident set size as
+     seconds,peak_rss_kb
+   The output of the command is discarded. The exit code is that of the command.
+
+   usage: benchrun command [arguments ...]
+
+   Copyright (C) 1993 - 2012 Wolfgang Glunz, wglunz35_AT_pstoedit.net
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+static double now()
+{
+	struct timeval tv;
+	(void) gettimeofday(&tv, 0);
+	return (double) tv.tv_sec + (double) tv.tv_usec / 1e6;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 2) {
+		fprintf(stderr, "usage: %s command [arguments ...]\n", argv[0]);
+		return 1;
+	}
+	const double start = now();
+	const pid_t pid = fork();
+	if (pid < 0) {
+		perror("fork");
+		return 1;
+	}
+	if (pid == 0) {
+		const int devnull = open("/dev/null", O_WRONLY);
+		if (devnull >= 0) {
+			(void) dup2(devnull, 1);
+			(void) dup2(devnull, 2);
+			(void) close(devnull);
+		}
+		(void) execvp(argv[1], argv + 1);
+		_exit(127);
+	}
+	int status = 0;
+	struct rusage usage;
+	if (wait4(pid, &status, 0, &usage) != pid) {
+		perror("wait4");
+		return 1;
+	}
+	const double seconds = now() - start;
+#if defined(__APPLE__)
+	const long peakKB = (long) (usage.ru_maxrss / 1024);	// bytes on Mac OS X
+#else
+	const long peakKB = (long) usage.ru_maxrss;
+#endif
+	printf("%.3f,%ld\n", seconds, peakKB);
+	if (WIFEXITED(status)) {
+		return WEXITSTATUS(status);
+	}
+	return 1;
+}
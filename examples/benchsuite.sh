@@ -0,0 +1,113 @@
+#!/bin/sh
+# End-to-end benchmark of pstoedit backends on synthetic input, used by "make bench".
+#
+# usage: benchsuite.sh [-p pstoedit] [-g benchgen] [-r benchrun] [-f "driver ..."]
+#                      [-s scale] [-i "input ..."] [-c laoscfg.ps] [-m "input:kb ..."]
+#
+# The inputs are generated by benchgen in the intermediate format (-f dump), so
+# Ghostscript is not part of the measurement. At scale 1 they are:
+#   paths     100 paths with 2000 points each
+#   subpaths  50000 subpaths in paths of 1000
+#   text      20000 text pieces on 200 pages
+#   image     an 800 x 800 RGB image
+#   pages     200 pages with 50 paths each
+#   colors    2000 paths with 500 points (1M vertices), each in its own color
+#   palette   200000 lines, each in its own color
+#             (colors and palette are not in the default inputs, "make bench"
+#             runs them with dxf only)
+# Everything is multiplied by the scale (the image size in both directions).
+# Each input is converted with -bo to each driver by benchrun, which measures
+# the wall clock time and the peak resident set size. The output file name
+# contains %d, so drivers without multi page support write one file per page;
+# the output size is the sum over all files. The laos driver needs its
+# configuration file, given by -c. The peak heap is the one pstoedit reports
+# in its statistics (-statsjson), 0 where it cannot count the heap. The result
+# is printed as CSV:
+#   input,driver,seconds,peak_rss_kb,peak_heap_kb,dump_bytes,output_bytes,exitcode
+#
+# -m sets memory ceilings: the peak heap of every driver on an input must not
+# exceed the kB given for it, e.g. -m "paths:8000 image:4000". The ceilings
+# hold for one scale only. If one is exceeded, this is reported and the
+# script fails after all conversions.
+#
+# To compare two builds run the script once with each pstoedit binary.
+
+PSTOEDIT=pstoedit
+BENCHGEN=./benchgen
+BENCHRUN=./benchrun
+DRIVERS="laos gcode dxf hpgl pdf fig svm cairo"
+INPUTS="paths subpaths text image pages"
+SCALE=1
+LAOSCONFIG=
+CEILINGS=
+FAILED=0
+
+while getopts "p:g:r:f:s:i:c:m:" opt; do
+	case $opt in
+	p) PSTOEDIT=$OPTARG ;;
+	g) BENCHGEN=$OPTARG ;;
+	r) BENCHRUN=$OPTARG ;;
+	f) DRIVERS=$OPTARG ;;
+	s) SCALE=$OPTARG ;;
+	i) INPUTS=$OPTARG ;;
+	c) LAOSCONFIG=$OPTARG ;;
+	m) CEILINGS=$OPTARG ;;
+	*) echo "usage: $0 [-p pstoedit] [-g benchgen] [-r benchrun] [-f \"driver ...\"] [-s scale] [-i \"input ...\"] [-c laoscfg.ps] [-m \"input:kb ...\"]" >&2; exit 1 ;;
+	esac
+done
+
+TMPDIR=${TMPDIR:-/tmp}
+WORK=$TMPDIR/benchsuite.$$
+mkdir -p $WORK || exit 1
+trap 'rm -rf $WORK' 0 1 2 15
+# temporary files of the drivers end up in the work directory as well
+TMPDIR=$WORK
+export TMPDIR
+
+echo "input,driver,seconds,peak_rss_kb,peak_heap_kb,dump_bytes,output_bytes,exitcode"
+for input in $INPUTS; do
+	case $input in
+	paths)		n=`expr 2000 \* $SCALE` ;;
+	subpaths)	n=`expr 50000 \* $SCALE` ;;
+	text)		n=`expr 20000 \* $SCALE` ;;
+	image)		n=`expr 800 \* $SCALE` ;;
+	pages)		n=`expr 200 \* $SCALE` ;;
+	colors)		n=`expr 2000 \* $SCALE` ;;
+	palette)	n=`expr 200000 \* $SCALE` ;;
+	*)		echo "unknown input $input" >&2; continue ;;
+	esac
+	dump=$WORK/$input.dump
+	if ! $BENCHGEN $input $n $dump; then
+		echo "$input: generation failed" >&2
+		continue
+	fi
+	dumpbytes=`wc -c < $dump | tr -d ' '`
+	ceiling=
+	for c in $CEILINGS; do
+		case $c in
+		$input:*) ceiling=`echo $c | sed 's/.*://'` ;;
+		esac
+	done
+	for driver in $DRIVERS; do
+		format=$driver
+		if [ "$driver" = laos ] && [ -n "$LAOSCONFIG" ]; then
+			format="laos:-configfile $LAOSCONFIG"
+		fi
+		stats=$WORK/$input-$driver.json
+		measurement=`$BENCHRUN $PSTOEDIT -q -statsjson $stats -f "$format" -bo $dump $WORK/$input.$driver.%d`
+		status=$?
+		bytes=`cat $WORK/$input.$driver.* 2>/dev/null | wc -c | tr -d ' '`
+		# the first "heap" of the JSON is the peak of the whole run
+		heap=`sed -n 's/.*"heap": *\([0-9]*\).*/\1/p' $stats 2>/dev/null | head -1`
+		heapkb=`expr ${heap:-0} / 1024`
+		rm -f $stats
+		echo "$input,$driver,${measurement:-0,0},$heapkb,$dumpbytes,${bytes:-0},$status"
+		if [ -n "$ceiling" ] && [ $heapkb -gt $ceiling ]; then
+			echo "$input,$driver: peak heap $heapkb kB exceeds the ceiling of $ceiling kB" >&2
+			FAILED=1
+		fi
+		rm -f $WORK/$input.$driver.*
+	done
+	rm -f $dump
+done
+exit $FAILED
@@ -38,6 +38,22 @@ The GNU C++ Iostream Library
 #include "cbstream.h"
 #include I_string_h
 
+callbackBuffer::callbackBuffer(void * cb_data_p, write_callback_type* wcb, unsigned int chunksize_p) :
+	cb_data(cb_data_p), write_callback(wcb), get_buffer(0),
+	own_buffer(0), chunksize(chunksize_p ? chunksize_p : 1)
+{
+	own_buffer = new char[chunksize];
+	setp(own_buffer, own_buffer + chunksize);
+}
+
+// no sync here - the buffer is a static object in pstoedit.cpp and the callbacks
+// and their cb_data may be gone at program exit. pstoedit() flushes cerr at its end.
+callbackBuffer::~callbackBuffer()
+{
+	delete[] own_buffer;
+	own_buffer = 0;
+}
+
 int callbackBuffer::underflow(void)
 {
 	const char message[] = "unexpected call to callbackbuf::underflow()\n";
@@ -47,45 +63,120 @@ int callbackBuffer::underflow(void)
 
 write_callback_type *callbackBuffer::set_callback(void *cb_data_p, write_callback_type * new_cb)
 {
+	(void) sync();
+	return_lent_buffer();
 	write_callback_type *old_cb = write_callback;
 	write_callback = new_cb;
 	cb_data = cb_data_p;
+	get_buffer = 0;
+	setp(own_buffer, own_buffer + chunksize);
 	return old_cb;
 }
 
+void callbackBuffer::set_lending_callbacks(void *cb_data_p, get_buffer_callback_type * get_buffer_p, write_callback_type * filled_cb)
+{
+	(void) set_callback(cb_data_p, filled_cb);
+	if (get_buffer_p) {
+		get_buffer = get_buffer_p;
+		setp(0, 0);				// the first buffer is requested on the first write
+	}
+}
+
+void callbackBuffer::set_chunksize(unsigned int chunksize_p)
+{
+	(void) sync();
+	delete[] own_buffer;
+	chunksize = chunksize_p ? chunksize_p : 1;
+	own_buffer = new char[chunksize];
+	if (!get_buffer) {
+		setp(own_buffer, own_buffer + chunksize);
+	}
+}
+
 int callbackBuffer::write_to_callback(const char *text, int length)
 {
 	if (write_callback) {
 		return (*write_callback) (cb_data, text, length);
 	} else {
-		return 0;
+		return length; // no callback - discard 
+	}
+}
+
+bool callbackBuffer::flush_buffer()
+{
+	const streamsize n = pptr() - pbase();
+	if (n == 0) {
+		return true;			// an empty lent buffer is kept for the next data
+	}
+	const bool ok = (write_to_callback(pbase(), (int) n) == n);
+	if (get_buffer) {
+		setp(0, 0);				// the buffer belongs to the caller again
+	} else {
+		setp(own_buffer, own_buffer + chunksize);
+	}
+	return ok;
+}
+
+bool callbackBuffer::new_put_area()
+{
+	if (!get_buffer) {
+		setp(own_buffer, own_buffer + chunksize);
+		return true;
+	}
+	int length = 0;
+	char * const buffer = (*get_buffer) (cb_data, &length);
+	if (!buffer || (length <= 0)) {
+		return false;
+	}
+	setp(buffer, buffer + length);
+	return true;
+}
+
+void callbackBuffer::return_lent_buffer()
+{
+	if (get_buffer && pbase()) {
+		(void) write_to_callback(pbase(), (int) (pptr() - pbase()));
+		setp(0, 0);
 	}
 }
 
 int callbackBuffer::sync()
 {
-	streamsize n = pptr() - pbase();
-	return (n && write_to_callback(pbase(), (unsigned int) n) != n) ? EOF : 0;
+	return flush_buffer() ? 0 : EOF;
 }
 
 int callbackBuffer::overflow(int ch)
 {
-	streamsize n = pptr() - pbase();
-	if (n && sync())
+	if (!flush_buffer())
+		return EOF;
+	if ((pptr() == epptr()) && !new_put_area())
 		return EOF;
 	if (ch != EOF) {
-		char cbuf[1];
-		cbuf[0] = (char) ch;
-		if (write_to_callback(cbuf, 1) != 1)
-			return EOF;
+		*pptr() = (char) ch;
+		pbump(1);
 	}
-	pbump(-n);					// Reset pptr().
 	return 0;
 }
 
 streamsize callbackBuffer::xsputn(const char *text, streamsize n)
 {
-	return sync() == EOF ? 0 : write_to_callback(text, (unsigned int) n);
+	if (n <= epptr() - pptr()) {
+		memcpy(pptr(), text, (size_t) n);
+		pbump((int) n);
+		return n;
+	}
+	if (get_buffer) {
+		// fill the lent buffers one after the other
+		return streambuf::xsputn(text, n);
+	}
+	if (!flush_buffer())
+		return 0;
+	if (n < (streamsize) chunksize) {
+		memcpy(pptr(), text, (size_t) n);
+		pbump((int) n);
+		return n;
+	}
+	return write_to_callback(text, (int) n);
 }
 
 
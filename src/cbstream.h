@@ -48,15 +48,27 @@ typedef int streamsize; // oder long ?? MSVC likes int
 #if defined(_WIN32) || defined(__OS2__)
 typedef int (__stdcall write_callback_type) (void * cb_data, const char* text, int length);
 // length is int and not unsigned long because of gs-api
+typedef char * (__stdcall get_buffer_callback_type) (void * cb_data, int * length);
 #else
 typedef int ( write_callback_type) (void * cb_data, const char* text, int length);
+typedef char * ( get_buffer_callback_type) (void * cb_data, int * length);
 #endif
+// The data are collected in a buffer of chunksize bytes and passed to the write callback
+// when the buffer is full or the stream is flushed. Blocks larger than the buffer are
+// passed on directly. The destructor does not call the callbacks - what is not
+// flushed before is lost.
+// Alternatively (set_lending_callbacks) the caller lends the buffers: get_buffer returns
+// a buffer and its size, the data are written directly into it and the buffer is
+// handed back to the caller via the write callback - the caller may reuse it after that.
 //lint !e1712 // no default ctor
 class callbackBuffer : public streambuf {
 public:
-	callbackBuffer(void * cb_data_p, write_callback_type* wcb) : 
-		cb_data(cb_data_p), write_callback(wcb) {}
+	enum { defaultChunkSize = 16 * 1024 };
+	callbackBuffer(void * cb_data_p, write_callback_type* wcb, unsigned int chunksize_p = defaultChunkSize);
+	~callbackBuffer();
 	write_callback_type * set_callback(void * cb_data_p,write_callback_type* new_cb);
+	void set_lending_callbacks(void * cb_data_p, get_buffer_callback_type* get_buffer_p, write_callback_type* filled_cb);
+	void set_chunksize(unsigned int chunksize_p);
 	int write_to_callback(const char* text, int length);
 
 protected:
@@ -69,9 +81,15 @@ protected:
     streamsize xsputn(const char* text, streamsize n);
 
 private:
+	bool flush_buffer();		// pass the put area to the callback
+	bool new_put_area();
+	void return_lent_buffer();	// hand back an unused lent buffer
 	
 	void * cb_data;
 	write_callback_type * write_callback;
+	get_buffer_callback_type * get_buffer;	// 0 if the own buffer is used
+	char * own_buffer;
+	unsigned int chunksize;
 	callbackBuffer(const callbackBuffer &); // not defined
 	const callbackBuffer & operator = (const callbackBuffer &); // not defined
 };
@@ -23,6 +23,109 @@
 #include "pstoedit.h"
 
 #include I_iostream
+#include "runstats.h"
+
+#include <new>
+#include <stdlib.h>
+
+// Counting of the heap for the memory statistics (-stats, -v). The size of a
+// block is taken from the allocator, so nothing is added to the blocks; where
+// the allocator cannot tell it, the heap is not counted. Define
+// NO_ALLOCATION_COUNTING to leave operator new alone.
+#if !defined(NO_ALLOCATION_COUNTING)
+#if defined(__GLIBC__)
+#include <malloc.h>
+#define blockSize(p) malloc_usable_size(p)
+#elif defined(_WIN32)
+#include <malloc.h>
+#define blockSize(p) _msize(p)
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#define blockSize(p) malloc_size(p)
+#endif
+#endif
+
+#ifdef blockSize
+// the exception specifications of the replaced operators changed with C++11
+#if __cplusplus >= 201103L
+#define THROWS_BAD_ALLOC
+#define THROWS_NOTHING noexcept
+#else
+#define THROWS_BAD_ALLOC throw (std::bad_alloc)
+#define THROWS_NOTHING throw ()
+#endif
+
+static void * countedAllocation(size_t size)
+{
+	void * p = malloc(size ? size : 1);
+	if (p) MemoryStatistics::allocate(MemoryStatistics::heap, blockSize(p));
+	return p;
+}
+
+static void countedRelease(void * p)
+{
+	if (!p) return;
+	MemoryStatistics::release(MemoryStatistics::heap, blockSize(p));
+	free(p);
+}
+
+void * operator new(size_t size) THROWS_BAD_ALLOC
+{
+	void * p = countedAllocation(size);
+	if (!p) throw std::bad_alloc();
+	return p;
+}
+
+void * operator new[](size_t size) THROWS_BAD_ALLOC
+{
+	void * p = countedAllocation(size);
+	if (!p) throw std::bad_alloc();
+	return p;
+}
+
+void * operator new(size_t size, const std::nothrow_t &) THROWS_NOTHING
+{
+	return countedAllocation(size);
+}
+
+void * operator new[](size_t size, const std::nothrow_t &) THROWS_NOTHING
+{
+	return countedAllocation(size);
+}
+
+void operator delete(void * p) THROWS_NOTHING
+{
+	countedRelease(p);
+}
+
+void operator delete[](void * p) THROWS_NOTHING
+{
+	countedRelease(p);
+}
+
+void operator delete(void * p, const std::nothrow_t &) THROWS_NOTHING
+{
+	countedRelease(p);
+}
+
+void operator delete[](void * p, const std::nothrow_t &) THROWS_NOTHING
+{
+	countedRelease(p);
+}
+
+#if __cplusplus >= 201402L
+// sized deallocation (C++14) - the size is not needed, blockSize gives it
+void operator delete(void * p, size_t) THROWS_NOTHING
+{
+	countedRelease(p);
+}
+
+void operator delete[](void * p, size_t) THROWS_NOTHING
+{
+	countedRelease(p);
+}
+#endif
+#endif
 
 int main(int argc, const char *const argv[])
 {
@@ -0,0 +1,276 @@
+/*
+
+   compressedoutput.cpp : This file is part of pstoedit
+   streambuf that compresses the data (gzip or zstd) before passing them on
+
+   Copyright (C) 1993 - 2012 Wolfgang Glunz, wglunz35_AT_pstoedit.net
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+#include "compressedoutput.h"
+
+#include I_string_h
+
+#define strequal(s1,s2) (strcmp(s1,s2) == 0)
+
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
+#ifdef HAVE_LIBZSTD
+#include <zstd.h>
+#endif
+
+static const size_t inputBufferSize = 128 * 1024;
+static const size_t outputBufferSize = 64 * 1024;
+
+class CompressionEncoder {
+public:
+	virtual ~CompressionEncoder() {}
+	virtual bool ok() const = 0;
+	// compresses length bytes - and completes the compressed stream if finish is set -
+	// and writes the result to target
+	virtual bool encode(const char * data, size_t length, bool finish, streambuf & target) = 0;
+};
+
+#ifdef HAVE_LIBZ
+class GzipEncoder : public CompressionEncoder {
+public:
+	explicit GzipEncoder(int level) : initialized(false) {
+		memset(&zs, 0, sizeof(zs));
+		if (level < 0 || level > 9) {
+			level = Z_DEFAULT_COMPRESSION;
+		}
+		// windowBits 15 + 16 gives a gzip header and trailer instead of the zlib ones
+		initialized = (deflateInit2(&zs, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) == Z_OK);
+	}
+	~GzipEncoder() {
+		if (initialized) {
+			(void) deflateEnd(&zs);
+		}
+	}
+	bool ok() const { return initialized; }
+	bool encode(const char * data, size_t length, bool finish, streambuf & target) {
+		zs.next_in = const_cast<Bytef *>(reinterpret_cast<const Bytef *>(data));	// zlib does not modify the input
+		zs.avail_in = (uInt) length;
+		int status;
+		do {
+			zs.next_out = (Bytef *) out;
+			zs.avail_out = (uInt) outputBufferSize;
+			status = deflate(&zs, finish ? Z_FINISH : Z_NO_FLUSH);
+			if (status == Z_STREAM_ERROR) {
+				return false;
+			}
+			const streamsize n = (streamsize) (outputBufferSize - zs.avail_out);
+			if (n && (target.sputn(out, n) != n)) {
+				return false;
+			}
+		} while ((zs.avail_out == 0) || (finish && (status != Z_STREAM_END)));
+		return true;
+	}
+private:
+	z_stream zs;
+	bool initialized;
+	char out[outputBufferSize];
+
+	GzipEncoder(const GzipEncoder &); // not defined
+	const GzipEncoder & operator = (const GzipEncoder &); // not defined
+};
+#endif
+
+#ifdef HAVE_LIBZSTD
+class ZstdEncoder : public CompressionEncoder {
+public:
+	explicit ZstdEncoder(int level) : cctx(ZSTD_createCCtx()) {
+		if (cctx) {
+			(void) ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, (level < 0) ? ZSTD_CLEVEL_DEFAULT : level);
+		}
+	}
+	~ZstdEncoder() {
+		(void) ZSTD_freeCCtx(cctx);
+	}
+	bool ok() const { return cctx != 0; }
+	bool encode(const char * data, size_t length, bool finish, streambuf & target) {
+		ZSTD_inBuffer in = { data, length, 0 };
+		for (;;) {
+			ZSTD_outBuffer outbuf = { out, outputBufferSize, 0 };
+			const size_t remaining = ZSTD_compressStream2(cctx, &outbuf, &in, finish ? ZSTD_e_end : ZSTD_e_continue);
+			if (ZSTD_isError(remaining)) {
+				return false;
+			}
+			const streamsize n = (streamsize) outbuf.pos;
+			if (n && (target.sputn(out, n) != n)) {
+				return false;
+			}
+			if (finish ? (remaining == 0) : (in.pos == in.size)) {
+				return true;
+			}
+		}
+	}
+private:
+	ZSTD_CCtx * cctx;
+	char out[outputBufferSize];
+
+	ZstdEncoder(const ZstdEncoder &); // not defined
+	const ZstdEncoder & operator = (const ZstdEncoder &); // not defined
+};
+#endif
+
+static bool hasSuffix(const char * name, const char * suffix)
+{
+	const size_t namelen = strlen(name);
+	const size_t suffixlen = strlen(suffix);
+	return (namelen > suffixlen) && strequal(name + namelen - suffixlen, suffix);
+}
+
+CompressedOutput::Method CompressedOutput::selectMethod(const char * option, const char * filename, ostream & errf)
+{
+	Method method = none;
+	if (option && *option) {
+		if (strequal(option, "gzip") || strequal(option, "gz")) {
+			method = gzip;
+		} else if (strequal(option, "zstd") || strequal(option, "zst")) {
+			method = zstd;
+		} else if (!strequal(option, "none")) {
+			errf << "unknown compression method " << option << " - use gzip, zstd or none" << endl;
+		}
+	} else if (filename) {
+		if (hasSuffix(filename, ".gz")) {
+			method = gzip;
+		} else if (hasSuffix(filename, ".zst")) {
+			method = zstd;
+		}
+	}
+#ifndef HAVE_LIBZ
+	if (method == gzip) {
+		errf << "gzip compression is not available in this version of pstoedit (built without zlib) - output is not compressed" << endl;
+		method = none;
+	}
+#endif
+#ifndef HAVE_LIBZSTD
+	if (method == zstd) {
+		errf << "zstd compression is not available in this version of pstoedit (built without libzstd) - output is not compressed" << endl;
+		method = none;
+	}
+#endif
+	return method;
+}
+
+bool CompressedOutput::requested(const char * option, const char * filename)
+{
+	if (option && *option) {
+		return !strequal(option, "none");
+	}
+	return filename && (hasSuffix(filename, ".gz") || hasSuffix(filename, ".zst"));
+}
+
+CompressedOutput::CompressedOutput(ostream & stream_p, Method method, int level, ostream & errf_p) :
+	stream(stream_p),
+	errf(errf_p),
+	target(stream_p.rdbuf()),
+	encoder(0),
+	buffer(0),
+	consumed(0),
+	failed(false),
+	seekReported(false)
+{
+	switch (method) {
+#ifdef HAVE_LIBZ
+	case gzip:
+		encoder = new GzipEncoder(level);
+		break;
+#endif
+#ifdef HAVE_LIBZSTD
+	case zstd:
+		encoder = new ZstdEncoder(level);
+		break;
+#endif
+	default:
+		break;
+	}
+	if (encoder && !encoder->ok()) {
+		errf << "could not initialize the compression of the output - output is not compressed" << endl;
+		delete encoder;
+		encoder = 0;
+	}
+	if (encoder && target) {
+		buffer = new char[inputBufferSize];
+		setp(buffer, buffer + inputBufferSize);
+		(void) stream.rdbuf(this);
+	}
+}
+
+CompressedOutput::~CompressedOutput()
+{
+	if (buffer) {
+		(void) compressBuffer(true);
+		(void) target->pubsync();
+		(void) stream.rdbuf(target);
+	}
+	delete encoder;
+	encoder = 0;
+	delete[] buffer;
+	buffer = 0;
+	target = 0;
+}
+
+bool CompressedOutput::compressBuffer(bool finish)
+{
+	const size_t n = pptr() - pbase();
+	if (!failed && !encoder->encode(pbase(), n, finish, *target)) {
+		errf << "compression of the output failed" << endl;
+		failed = true;
+	}
+	consumed += n;
+	setp(buffer, buffer + inputBufferSize);
+	return !failed;
+}
+
+CompressedOutput::int_type CompressedOutput::overflow(int_type ch)
+{
+	if (!compressBuffer(false)) {
+		return traits_type::eof();
+	}
+	if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+		*pptr() = traits_type::to_char_type(ch);
+		pbump(1);
+	}
+	return traits_type::not_eof(ch);
+}
+
+// flushing the encoder would make the result larger, so only the target is synced
+int CompressedOutput::sync()
+{
+	return target->pubsync();
+}
+
+CompressedOutput::pos_type CompressedOutput::seekoff(off_type off, ios_base::seekdir dir, ios_base::openmode which)
+{
+	if ((off == 0) && (dir == ios_base::cur) && (which & ios_base::out)) {
+		return pos_type(off_type(consumed + (pptr() - pbase())));
+	}
+	if (!seekReported) {
+		// drivers that seek are known before (ProgramOptions::repositionsOutput)
+		errf << "the selected output format needs to reposition in its output file - this is not possible with compressed output" << endl;
+		seekReported = true;
+	}
+	return pos_type(off_type(-1));
+}
+
+CompressedOutput::pos_type CompressedOutput::seekpos(pos_type pos, ios_base::openmode which)
+{
+	return seekoff(off_type(pos), ios_base::beg, which);
+}
@@ -0,0 +1,78 @@
+#ifndef COMPRESSEDOUTPUT_H
+#define COMPRESSEDOUTPUT_H
+/*
+
+   compressedoutput.h : This file is part of pstoedit
+   streambuf that compresses the data (gzip or zstd) before passing them on
+
+   Copyright (C) 1993 - 2012 Wolfgang Glunz, wglunz35_AT_pstoedit.net
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+#ifndef cppcomp_h
+#include "cppcomp.h"
+#endif
+
+#include I_iostream
+#include I_streamb
+USESTD
+
+class CompressionEncoder;
+
+// Is put in front of the streambuf of an existing ostream (like BufferedOutput) and
+// passes the data on as a gzip or zstd stream. Flushing the stream does not flush the
+// encoder, the compressed stream is completed in the destructor, which also restores
+// the original streambuf. tellp returns the uncompressed position, other seeks fail -
+// drivers that need them declare this in their options (repositionsOutput).
+class CompressedOutput : public streambuf {
+public:
+	enum Method { none, gzip, zstd };
+
+	// method given by the -compress option or, if that is empty, by the suffix
+	// (.gz, .zst) of the output file name. Prints a message to errf and returns none
+	// if the method is unknown or was not available when pstoedit was built.
+	static Method selectMethod(const char * option, const char * filename, ostream & errf);
+	// whether compression is requested at all - the file has to be opened in binary mode then
+	static bool requested(const char * option, const char * filename);
+
+	// level < 0 selects the default level of the method
+	CompressedOutput(ostream & stream_p, Method method, int level, ostream & errf_p);
+	~CompressedOutput();
+
+protected:
+	int_type overflow(int_type ch);
+	int sync();
+	pos_type seekoff(off_type off, ios_base::seekdir dir, ios_base::openmode which);
+	pos_type seekpos(pos_type pos, ios_base::openmode which);
+
+private:
+	bool compressBuffer(bool finish);
+
+	ostream & stream;
+	ostream & errf;
+	streambuf * target;
+	CompressionEncoder * encoder;
+	char * buffer;
+	unsigned long consumed;		// uncompressed bytes passed to the encoder
+	bool failed;
+	bool seekReported;
+
+	CompressedOutput(const CompressedOutput &); // not defined
+	const CompressedOutput & operator = (const CompressedOutput &); // not defined
+};
+
+#endif
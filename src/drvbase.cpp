@@ -35,6 +35,8 @@
 #ifndef miscutil_h
 #include "miscutil.h"
 #endif
+#include "compressedoutput.h"
+#include "runstats.h"
 
 static void splitFullFileName(const char *const fullName, 
 							  RSString& pathName, 
@@ -77,6 +79,26 @@ static void splitFullFileName(const char *const fullName,
 
 
 
+static CompressedOutput * createCompressor(ostream & outs, ostream & errs, const char * nameOfOutputFile,
+										  const PsToEditOptions & options, const DriverDescription * driverdesc,
+										  const ProgramOptions * driverOptions)
+{
+	const CompressedOutput::Method method =
+		CompressedOutput::selectMethod(options.compressOutput.value.value(), nameOfOutputFile, errs);
+	if (method == CompressedOutput::none) {
+		return 0;
+	}
+	if (driverdesc->backendFileOpenType == DriverDescription::noopen) {
+		errs << "the selected backend writes its output file itself - it cannot be compressed" << endl;
+		return 0;
+	}
+	if (driverOptions && driverOptions->repositionsOutput()) {
+		errs << "the selected backend seeks back in its output file (with the given driver options) - it cannot be compressed, the output is written uncompressed" << endl;
+		return 0;
+	}
+	return new CompressedOutput(outs, method, options.compressionLevel, errs);
+}
+
 drvbase::drvbase(const char *driveroptions_p, ostream & theoutStream,
 				 ostream & theerrStream,
 				 const char *nameOfInputFile_p,
@@ -89,6 +111,8 @@ DOptions_ptr(Pdriverdesc_p->createDriverOptions()),
 //  totalNumberOfPages(0),
 //  bboxes(0),
 	outf(theoutStream),
+compressor(0),	// both are set up once the driver options are known
+outputBuffer(0),
 errf(theerrStream),
 inFileName(nameOfInputFile_p),
 outFileName(nameOfOutputFile_p), 
@@ -192,6 +216,10 @@ saveRestoreInfo(NIL), currentSaveLevel(&saveRestoreInfo), page_empty(true), driv
 		}
 	}
 
+	// the driver options decide whether the output can be compressed
+	compressor = createCompressor(outf, errf, nameOfOutputFile_p, globaloptions_p, Pdriverdesc_p, DOptions_ptr);
+	outputBuffer = new BufferedOutput(outf);
+
 //  bboxes = new BBox[maxPages];
 
 	// init segment info for first segment
@@ -253,6 +281,11 @@ drvbase::~drvbase()
 		}
 	}
 	currentSaveLevel = 0;
+
+	delete outputBuffer;	// writes what is left and restores the streambuf of outf
+	outputBuffer = 0;
+	delete compressor;		// completes the compressed stream
+	compressor = 0;
 }
 
 const RSString & drvbase::getPageSize() const { return globaloptions.outputPageSize(); }
@@ -296,7 +329,12 @@ void drvbase::showpage()
 {
 	flushOutStanding();					// dump last path 
 	if (!page_empty) {
-		close_page();
+		{
+			const StatisticsSpan span(RunStatistics::close_page);
+			close_page();
+		}
+		outputBuffer->flush();
+		MemoryStatistics::endPage(currentPageNumber);
 	}
 	page_empty = true;
 }
@@ -354,6 +392,19 @@ const basedrawingelement & drvbase::pathElement(unsigned int index) const
 	return *(outputPath->path[index + outputPath->subpathoffset]);
 }
 
+void * basedrawingelement::operator new(size_t size)
+{
+	MemoryStatistics::allocate(MemoryStatistics::pathElements, size);
+	return ::operator new(size);
+}
+
+void basedrawingelement::operator delete(void * p, size_t size)
+{
+	if (!p) return;
+	MemoryStatistics::release(MemoryStatistics::pathElements, size);
+	::operator delete(p);
+}
+
 bool basedrawingelement::operator == (const basedrawingelement & bd2) const
 {
 	if (this->getType() != bd2.getType()) {
@@ -469,7 +520,11 @@ void drvbase::flushTextBuffer(bool useMergeBuffer)
 								// this is needed.
 	const TextInfo* textToBeFlushed = useMergeBuffer ? &mergedTextInfo : &textInfo_;
 	add_to_page();
-	show_text(*textToBeFlushed);	
+	{
+		const StatisticsSpan span(RunStatistics::show_text);
+		show_text(*textToBeFlushed);	
+	}
+	RunStatistics::count(RunStatistics::textPieces);
 	lastTextInfo_ = *textToBeFlushed;	// save for font and color comparison
 }
 
@@ -661,6 +716,9 @@ void drvbase::add_to_page()
 	if (page_empty) {
 		page_empty = false;
 		currentPageNumber++;
+		RunStatistics::count(RunStatistics::pages);
+		MemoryStatistics::beginPage();
+		const StatisticsSpan span(RunStatistics::open_page);
 		open_page();
 	}
 }
@@ -801,10 +859,13 @@ void drvbase::dumpImage()
 	flushOutStanding();					// dump last path to avoid wrong sequence of text and graphics
 	add_to_page();
 	imageInfo.calculateBoundingBox();
-	show_image(imageInfo);
-	delete[]imageInfo.data;
-	imageInfo.nextfreedataitem = 0;
-	imageInfo.data = 0;
+	RunStatistics::count(RunStatistics::images);
+	RunStatistics::count(RunStatistics::imageBytes, imageInfo.nextfreedataitem);
+	{
+		const StatisticsSpan span(RunStatistics::show_image);
+		show_image(imageInfo);
+	}
+	imageInfo.freeData();
 }
 
 unsigned int drvbase::nrOfSubpaths() const
@@ -853,6 +914,7 @@ void drvbase::dumpRearrangedPathes()
 				errf << "dumping subpath from " << starti << " to " << end << endl;
 			outputPath->subpathoffset = starti;
 			outputPath->numberOfElementsInPath = end - starti;
+			const StatisticsSpan span(RunStatistics::show_path);
 			show_path();		// from start to end
 		}
 		starti = end;
@@ -873,6 +935,7 @@ bool drvbase::close_output_file_and_reopen_in_binary_mode()
 
 		//dbg cerr << "outputfileptr = " << (void*) outputFilePtr << " outf " << (void*) (&outf)<< endl;
 
+		outputBuffer->flush();
 		outputFilePtr->close();
 		if (Verbose()) cerr << "after close " << endl;
 #if (defined(unix) || defined(__unix__) || defined(_unix) || defined(__unix) || defined(__EMX__) || defined (NetBSD)  ) && !defined(DJGPP)
@@ -908,7 +971,10 @@ void drvbase::beginClipPath()
 void drvbase::endClipPath(cliptype clipmode)
 {
 	add_to_page();
-	ClipPath(clipmode);
+	{
+		const StatisticsSpan span(RunStatistics::clip_save_restore);
+		ClipPath(clipmode);
+	}
 	clippath.clear();
 	currentPath = last_currentPath;
 	outputPath = currentPath;
@@ -956,6 +1022,7 @@ void drvbase::dumpPath(bool doFlushText)
 {
 	if (doFlushText) flushOutStanding(flushtext); // flush text, so merge is not supported in case of
 								 // text path text sequence
+	const StatisticsSpan dumpPathSpan(RunStatistics::dumpPath);
 
 	guess_linetype();			 // needs to be done here, because we must write to currentpath
 
@@ -1017,6 +1084,7 @@ void drvbase::dumpPath(bool doFlushText)
 		}
 		outputPath = &PI1;
 		PI1.pathWasMerged = true;
+		RunStatistics::count(RunStatistics::mergedPaths);
 		PI2.clear();
 	} else {
 		outputPath = lastPath;
@@ -1048,6 +1116,8 @@ void drvbase::dumpPath(bool doFlushText)
 		if (numberOfElementsInPath() > 1) {
 			// cannot draw single points 
 			add_to_page();
+			RunStatistics::count(RunStatistics::paths);
+			RunStatistics::count(RunStatistics::elements, numberOfElementsInPath());
 			if (isPolygon()) {	/* PolyGon */
 				if (is_a_rectangle()) {
 					const float llx =
@@ -1071,18 +1141,23 @@ void drvbase::dumpPath(bool doFlushText)
 							 pathElement(1).getPoint(0).y_),
 							max(pathElement(2).getPoint(0).y_, pathElement(3).getPoint(0).y_));
 
+					const StatisticsSpan span(RunStatistics::show_path);
 					show_rectangle(llx, lly, urx, ury);
 				} else {
-					if (globaloptions.simulateSubPaths)
+					if (globaloptions.simulateSubPaths) {
 						dumpRearrangedPathes();
-					else
+					} else {
+						const StatisticsSpan span(RunStatistics::show_path);
 						show_path();
+					}
 				}
 			} else {			/* PolyLine */
-				if (globaloptions.simulateSubPaths)
+				if (globaloptions.simulateSubPaths) {
 					dumpRearrangedPathes();
-				else
+				} else {
+					const StatisticsSpan span(RunStatistics::show_path);
 					show_path();
+				}
 			}
 		}
 		// cleanup
@@ -1126,6 +1201,16 @@ void drvbase::addtopath(basedrawingelement * newelement)
 	}
 }
 
+void drvbase::PathInfo::accountPathArray(bool allocated)
+{
+	const size_t bytes = maxElements * sizeof(basedrawingelement *);
+	if (allocated) {
+		MemoryStatistics::allocate(MemoryStatistics::pathArrays, bytes);
+	} else {
+		MemoryStatistics::release(MemoryStatistics::pathArrays, bytes);
+	}
+}
+
 void drvbase::PathInfo::clear()
 {
 	for (unsigned int i = 0; i < numberOfElementsInPath; i++) {
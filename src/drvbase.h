@@ -56,7 +56,7 @@ USESTD
 
 
 // for compatibility checking
-static const unsigned int drvbaseVersion = 108;
+static const unsigned int drvbaseVersion = 109;
 // 101 introduced the driverOK function
 // 102 introduced the font optimization (lasttextinfo_)
 // 103 introduced the -ssp support and the virtual pathscanbemerged
@@ -65,6 +65,7 @@ static const unsigned int drvbaseVersion = 108;
 // 106 introduced some new utility functions for transformation (*_trans*)
 // 107 new driver descriptions -- added info about clipping
 // 108 new driver descriptions -- added info about driver options
+// 109 outf is written through a BufferedOutput and optionally a CompressedOutput
 
 const unsigned int	maxFontNamesLength = 1000;
 const unsigned int	maxPoints    = 80000;	// twice the maximal number of points in a path
@@ -124,6 +125,7 @@ static const char emptyDashPattern[] =  "[ ] 0.0";
 
 class basedrawingelement ; // forward
 class DriverDescription ;  // forward
+class CompressedOutput ;  // forward
 
 class       DLLEXPORT    drvbase 
     // = TITLE
@@ -271,12 +273,14 @@ protected:
 			dashPattern(emptyDashPattern)
 			{
 			    path = new basedrawingelement *[maxElements];
+			    accountPathArray(true);
 			}
 
 		virtual ~PathInfo() { // added virtual because of windows memory handling
 			// the path content is deleted by clear
 			clear();
 			delete [] path;
+			accountPathArray(false);
 		}
 		void clear();
 		void copyInfo(const PathInfo & p);
@@ -284,6 +288,7 @@ protected:
 		void rearrange();
             // rearrange subpaths for backends which don't support them 
 	private:
+		static void accountPathArray(bool allocated);
 		// Inhibitors (declared, but not defined)
 		const PathInfo& operator=(const PathInfo&);
 		PathInfo(const PathInfo &);
@@ -330,6 +335,8 @@ protected:
 	// = PROTECTED DATA
 
 	ostream &	outf;           // the output stream
+	CompressedOutput * compressor; // between outputBuffer and the file if the output shall be compressed
+	BufferedOutput * outputBuffer; // installed in front of outf, passed on at the end of each page
 	ostream &	errf;           // the error stream
 	const RSString	inFileName; // full name of input file
 	const RSString	outFileName; // full name of output file
@@ -725,6 +732,10 @@ public:
 	// this is not simply achieved if plugins are loaded as DLL.
 	virtual void deleteyourself() { delete this; } 
 	virtual ~basedrawingelement() {}
+	// the elements are allocated in large numbers by the lexer, these
+	// account them to MemoryStatistics::pathElements
+	static void * operator new(size_t size);
+	static void operator delete(void * p, size_t size);
 private:
 //	const unsigned int size;
 };
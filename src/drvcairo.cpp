@@ -590,108 +590,14 @@ void drvCAIRO::show_image(const PSImage & image)
 #endif
 
 
-  // calc long-padded size of scanline 
-  const long scanlineLen = ((width * 3) + 3) & ~3L;
-
-  // now lets get some mem
-  unsigned char *const output = new unsigned char[scanlineLen * height];
-
-  for (long i = 0; i < scanlineLen * height; i++)
-    output[i] = 255;		// default is background (white)    
-  
-  if (!output) {
-    errf << "ERROR: Cannot allocate memory for image" << endl;
-    return;
+  // The generated code has no image support yet (see the example above), so
+  // the image is not converted. Resampling it into a raster here would only
+  // cost time, the raster could not be written.
+  static bool warningwritten = false;
+  if (!warningwritten) {
+    errf << "Warning: images are not supported by the cairo driver and are left out" << endl;
+    warningwritten = true;
   }
-  // setup inverse transformation matrix (scaled, too!)
-  const float matrixScale(image.normalizedImageCurrentMatrix[0] *
-			  image.normalizedImageCurrentMatrix[3] -
-			  image.normalizedImageCurrentMatrix[2] *
-			  image.normalizedImageCurrentMatrix[1]);
-  const float inverseMatrix[] = {
-    image.normalizedImageCurrentMatrix[3] / matrixScale / getScale(),
-    -image.normalizedImageCurrentMatrix[1] / matrixScale / getScale(),
-    -image.normalizedImageCurrentMatrix[2] / matrixScale / getScale(),
-    image.normalizedImageCurrentMatrix[0] / matrixScale / getScale(),
-    (image.normalizedImageCurrentMatrix[2] *
-     image.normalizedImageCurrentMatrix[5] -
-     image.normalizedImageCurrentMatrix[4] *
-     image.normalizedImageCurrentMatrix[3]) / matrixScale,
-    (image.normalizedImageCurrentMatrix[4] *
-     image.normalizedImageCurrentMatrix[1] -
-     image.normalizedImageCurrentMatrix[0] *
-     image.normalizedImageCurrentMatrix[5]) / matrixScale
-  };
-
-  // now transform image
-  for (long ypos = 0; ypos < height; ypos++) {
-    // buffer current output scanline (saves us some multiplications)
-    unsigned char *const currOutput = &output[scanlineLen * ypos];
-    
-    for (long xpos = 0; xpos < width; xpos++) {
-      // now transform from device coordinate space to image space
-      
-      // apply transformation
-      const Point currPoint = Point(xpos + lowerLeft.x_,
-				    ypos + lowerLeft.y_).transform(inverseMatrix);
-      
-      // round to integers
-      const long sourceX = (long) (currPoint.x_ + .5);
-      const long sourceY = (long) (currPoint.y_ + .5);
-      
-      // is the pixel out of bounds? If yes, no further processing necessary
-      if (sourceX >= 0L && (unsigned long) sourceX < image.width &&
-	  sourceY >= 0L && (unsigned long) sourceY < image.height) {
-	// okay, fetch source pixel value into 
-	// RGB triplet
-	
-	unsigned char r(255), g(255), b(255), c, m, y, k;
-	
-	// how many components?
-	switch (image.ncomp) {
-	case 1:
-	  r = g = b = image.getComponent(sourceX, sourceY, 0);
-	  break;
-	  
-	case 3:
-	  r = image.getComponent(sourceX, sourceY, 0);
-	  g = image.getComponent(sourceX, sourceY, 1);
-	  b = image.getComponent(sourceX, sourceY, 2);
-	  break;
-	  
-	case 4:
-	  c = image.getComponent(sourceX, sourceY, 0);
-	  m = image.getComponent(sourceX, sourceY, 1);
-	  y = image.getComponent(sourceX, sourceY, 2);
-	  k = image.getComponent(sourceX, sourceY, 3);
-	  
-	  // account for key
-	  c += k;
-	  m += k;
-	  y += k;
-	  
-	  // convert color
-	  r = 255 - c;
-	  g = 255 - m;
-	  b = 255 - y;
-	  break;
-	  
-	default:
-	  errf << "\t\tFatal: unexpected case in drvcairo (line "
-	       << __LINE__ << ")" << endl;
-	  abort();
-	  return;
-	}
-	
-	// set color triple
-	currOutput[3 * xpos] = b;
-	currOutput[3 * xpos + 1] = g;
-	currOutput[3 * xpos + 2] = r;
-      }
-    }
-  }
-  
-  delete[]output;
 }
 
 static DriverDescriptionT < drvCAIRO > D_cairo("cairo",  // name
@@ -29,7 +29,9 @@
 #include "drvdxf.h"
 #include I_stdio
 #include I_string_h
+#include I_stdlib
 #include I_iostream
+#include <set>
 
 
 // not used - the acad header also works with icad. later we may introduce an option
@@ -211,16 +213,79 @@ public:
 
 private:
 	static const rgbcolor DXFColors[];
+	// the RGB cube is divided into cellsPerAxis^3 cells. For each cell the palette
+	// colors that can be the nearest one for some color in the cell are kept (built
+	// when the cell is first used), so only these need to be compared.
+	enum { cellsPerAxis = 16, firstColorsWithCells = 2 };
+	static const std::vector<unsigned char> & candidates(unsigned int cell, unsigned int firstcolor);
 public:
 	static const unsigned short numberOfColors;
 	static unsigned int getDXFColor(float r, float g, float b,unsigned int firstcolor = 0);
 };
 
+const std::vector<unsigned char> & DXFColor::candidates(unsigned int cell, unsigned int firstcolor)
+{
+	static std::vector<unsigned char> cells[firstColorsWithCells][cellsPerAxis * cellsPerAxis * cellsPerAxis];
+	static bool built[firstColorsWithCells][cellsPerAxis * cellsPerAxis * cellsPerAxis];
+	std::vector<unsigned char> & result = cells[firstcolor][cell];
+	if (built[firstcolor][cell]) return result;
+	built[firstcolor][cell] = true;
+
+	const double size = 1.0 / cellsPerAxis;
+	const double low[3] = { (cell / (cellsPerAxis * cellsPerAxis)) * size, (cell / cellsPerAxis % cellsPerAxis) * size, (cell % cellsPerAxis) * size };
+	std::vector<double> minDist(numberOfColors, 0.0);
+	double bound = 4.0;
+	for (unsigned int i = firstcolor; i < numberOfColors; i++) {
+		const double c[3] = { DXFColors[i].r / 255.0, DXFColors[i].g / 255.0, DXFColors[i].b / 255.0 };
+		double nearest = 0.0, farthest = 0.0;
+		for (unsigned int k = 0; k < 3; k++) {
+			const double dlow = c[k] - low[k];
+			const double dhigh = low[k] + size - c[k];
+			if (dlow < 0.0) nearest += dlow * dlow;
+			else if (dhigh < 0.0) nearest += dhigh * dhigh;
+			farthest += (dlow > dhigh) ? dlow * dlow : dhigh * dhigh;
+		}
+		minDist[i] = nearest;
+		if (farthest < bound) bound = farthest;
+	}
+	// the nearest color of any point in the cell is not farther away than "bound",
+	// so colors with a larger distance to the cell cannot be the nearest ones.
+	// The slack covers the float rounding in getDXFColor.
+	bound = bound * 1.001 + 1e-6;
+	for (unsigned int i = firstcolor; i < numberOfColors; i++) {
+		if (minDist[i] <= bound) result.push_back((unsigned char) i);
+	}
+	return result;
+}
 
 unsigned int DXFColor::getDXFColor(float r, float g, float b,unsigned int firstcolor)
 {
 	float mindist = 2.0f;  // theoretically the distance is max 1.0f - but to avoid rounding problems.
 	unsigned int best = firstcolor;
+	if ((firstcolor < firstColorsWithCells) &&
+		(r >= 0.0f) && (r <= 1.0f) && (g >= 0.0f) && (g <= 1.0f) && (b >= 0.0f) && (b <= 1.0f)) {
+		// same comparison as below, but only for the candidates of the cell,
+		// which are in ascending order - so the result is the same
+		const unsigned int maxIndex = cellsPerAxis - 1;
+		const unsigned int ri = (r < 1.0f) ? (unsigned int) (r * cellsPerAxis) : maxIndex;
+		const unsigned int gi = (g < 1.0f) ? (unsigned int) (g * cellsPerAxis) : maxIndex;
+		const unsigned int bi = (b < 1.0f) ? (unsigned int) (b * cellsPerAxis) : maxIndex;
+		const std::vector<unsigned char> & cellColors = candidates((ri * cellsPerAxis + gi) * cellsPerAxis + bi, firstcolor);
+		for (size_t k = 0; k < cellColors.size(); k++) {
+			const unsigned int i = cellColors[k];
+			const float dr = DXFColors[i].r / 255.0f - r;
+			const float dg = DXFColors[i].g / 255.0f - g;
+			const float db = DXFColors[i].b / 255.0f - b;
+			const float dist = dr * dr + dg * dg + db * db;
+			if (dist == 0.0) {
+				return i;
+			} else if (dist < mindist) {
+				best = i;
+				mindist = dist;
+			}
+		}
+		return best;
+	}
 	for (unsigned int i = firstcolor; i < numberOfColors; i++) {
 		const float dxfr = DXFColors[i].r / 255.0f;
 		const float dxfg = DXFColors[i].g / 255.0f;
@@ -551,11 +616,15 @@ public:
 
 	unsigned int numberOfLayers;
 
+	// index << 24 | R << 16 | G << 8 | B of all layers in LayerTable, for alreadyDefined.
+	// The lists of LayerTable get long with many colors near the same DXF color.
+	std::set<unsigned int> definedColors;
+
 	NamedLayer * namedLayers; // just a list of Layernames - these names from from PostScript Separation names
 	// and are used in the DXF without any color values (or better said - mapped to B&W color)
 
 
-	DXFLayers() : numberOfLayers(0), namedLayers(0) { 
+	DXFLayers() : numberOfLayers(0), definedColors(), namedLayers(0) { 
 		for (unsigned int i = 0; i < DXFColor::numberOfColors; i++) LayerTable[i]= 0; 
 	}
 
@@ -592,22 +661,7 @@ public:
 	bool alreadyDefined(float r, float g, float b, unsigned int index) const {
 		assert(index < DXFColor::numberOfColors);
 
-		const unsigned short R = floatColTointCol(r);
-		const unsigned short G = floatColTointCol(g);
-		const unsigned short B = floatColTointCol(b);
-
-		Layer * ptr = LayerTable[index];
-		while(ptr) {
-			if( (ptr->rgb.r == R) && 
-				(ptr->rgb.g == G) && 
-				(ptr->rgb.b == B) ) {
-					// cout << "already defined" << R << " " << G << " " << B << endl;
-					return true;
-				}
-			ptr = ptr->next;
-		}
-		// cout << "not yet defined" << R << " " << G << " " << B << endl;
-		return false;
+		return definedColors.find(packedColor(r, g, b, index)) != definedColors.end();
 	}
 
 	void defineLayer(float r, float g, float b, unsigned int index) {
@@ -618,9 +672,14 @@ public:
 		// prepend new layer to the linked list
 		Layer * newlayer = new Layer(r,g,b,headptr);
 		LayerTable[index] = newlayer;
+		(void) definedColors.insert(packedColor(r, g, b, index));
 		numberOfLayers++;
 	}
 
+	static unsigned int packedColor(float r, float g, float b, unsigned int index) {
+		return (index << 24) | (floatColTointCol(r) << 16) | (floatColTointCol(g) << 8) | floatColTointCol(b);
+	}
+
 	static const char * getLayerName(unsigned short r,unsigned short g,unsigned short b) {
 		static char stringbuffer[20]; // format: "Cxx-xx-xx" (10 chars)
 		sprintf_s(TARGETWITHLEN(stringbuffer,20),"C%02X-%02X-%02X",r,g,b);
@@ -636,6 +695,159 @@ public:
 };
 
 
+// All DXF output goes through a DXFGroupWriter as group code / value pairs, so the
+// same entity generation is used for ASCII and binary DXF. Fixed parts (headers,
+// constant groups) are passed as ASCII DXF text via writeText.
+class DXFGroupWriter {
+public:
+	explicit DXFGroupWriter(ostream & outs_p) : outs(outs_p) {}
+	virtual ~DXFGroupWriter() {}
+	// complete or partial lines of ASCII DXF - group code and value on separate lines
+	virtual void writeText(const char * dxftext) = 0;
+	virtual void writeString(unsigned int code, const char * value) = 0;
+	// text - ASCII form if it differs from the default formatting of value (e.g. "0.0")
+	virtual void writeReal(unsigned int code, double value, const char * text = 0) = 0;
+	// indented - the ASCII form is "     value" (as used for colors and flags)
+	virtual void writeInt(unsigned int code, long value, bool indented = false) = 0;
+protected:
+	ostream & outs;
+
+	NOCOPYANDASSIGN(DXFGroupWriter)
+};
+
+class DXFTextWriter : public DXFGroupWriter {
+public:
+	explicit DXFTextWriter(ostream & outs_p) : DXFGroupWriter(outs_p) {}
+	virtual void writeText(const char * dxftext) { outs << dxftext; }
+	virtual void writeString(unsigned int code, const char * value) {
+		writeCode(code); outs << value << '\n';
+	}
+	virtual void writeReal(unsigned int code, double value, const char * text) {
+		writeCode(code);
+		if (text) outs << text; else outs << NumberText(value);
+		outs << '\n';
+	}
+	virtual void writeInt(unsigned int code, long value, bool indented) {
+		writeCode(code);
+		if (indented) outs << "     ";
+		outs << NumberText(value) << '\n';
+	}
+private:
+	void writeCode(unsigned int code) {
+		// right aligned in 3 columns
+		if (code < 100) outs << ' ';
+		if (code < 10) outs << ' ';
+		outs << NumberText((long) code) << '\n';
+	}
+};
+
+// Binary DXF: a sentinel followed by group codes and values in binary form.
+// Group codes are 1 byte (255 + 2 bytes for larger codes) up to R12 and 2 bytes
+// since R13. The type of a value is defined by its group code. All numbers are
+// little endian, strings are terminated by 0.
+class DXFBinaryWriter : public DXFGroupWriter {
+public:
+	DXFBinaryWriter(ostream & outs_p, bool twoByteCodes_p) :
+		DXFGroupWriter(outs_p), twoByteCodes(twoByteCodes_p), haveCode(false), textCode(0), lineLength(0) {}
+
+	static void writeSentinel(ostream & outs) {
+		outs.write("AutoCAD Binary DXF\r\n\032\0", 22);
+	}
+
+	virtual void writeText(const char * dxftext) {
+		// the text may end in the middle of a line or pair, the rest follows with the next call
+		for (const char * cp = dxftext; *cp; cp++) {
+			if (*cp == '\n') {
+				line[lineLength] = '\0';
+				lineLength = 0;
+				if (!haveCode) {
+					textCode = (unsigned int) atoi(line);
+					haveCode = true;
+				} else {
+					haveCode = false;
+					writeValue(textCode, line);
+				}
+			} else if (lineLength < maxLineLength) {
+				line[lineLength++] = *cp;
+			}
+		}
+	}
+	virtual void writeString(unsigned int code, const char * value) {
+		assert(!haveCode);
+		writeCode(code);
+		outs.write(value, (streamsize) strlen(value) + 1);
+	}
+	virtual void writeReal(unsigned int code, double value, const char * /* text */ ) {
+		assert(!haveCode);
+		writeCode(code);
+		unsigned long long bits;
+		memcpy(&bits, &value, sizeof(bits));
+		writeLE(bits, 8);
+	}
+	virtual void writeInt(unsigned int code, long value, bool /* indented */ ) {
+		assert(!haveCode);
+		writeCode(code);
+		writeLE((unsigned long long) value, intSize(code));
+	}
+
+private:
+	enum valueType { stringValue, realValue, intValue };
+	static valueType typeOf(unsigned int code) {
+		if (((code >= 10) && (code <= 59)) || ((code >= 110) && (code <= 149)) ||
+			((code >= 210) && (code <= 239)) || ((code >= 460) && (code <= 469)) ||
+			((code >= 1010) && (code <= 1059))) return realValue;
+		if (((code >= 60) && (code <= 99)) || ((code >= 160) && (code <= 179)) ||
+			((code >= 270) && (code <= 299)) || ((code >= 370) && (code <= 389)) ||
+			((code >= 400) && (code <= 409)) || ((code >= 420) && (code <= 429)) ||
+			((code >= 440) && (code <= 459)) || ((code >= 1060) && (code <= 1071))) return intValue;
+		return stringValue;
+	}
+	static unsigned int intSize(unsigned int code) {
+		if ((code >= 290) && (code <= 299)) return 1; // bool
+		if ((code >= 160) && (code <= 169)) return 8;
+		if (((code >= 90) && (code <= 99)) || ((code >= 420) && (code <= 429)) ||
+			((code >= 440) && (code <= 459)) || (code == 1071)) return 4;
+		return 2;
+	}
+	void writeValue(unsigned int code, const char * text) {
+		switch (typeOf(code)) {
+		case realValue:
+			writeReal(code, atof(text), 0);
+			break;
+		case intValue:
+			writeInt(code, atol(text), false);
+			break;
+		case stringValue:
+		default:
+			writeString(code, text);
+			break;
+		}
+	}
+	void writeCode(unsigned int code) {
+		if (twoByteCodes) {
+			writeLE(code, 2);
+		} else if (code < 255) {
+			outs.put((char) code);
+		} else {
+			outs.put((char) 255);
+			writeLE(code, 2);
+		}
+	}
+	void writeLE(unsigned long long value, unsigned int bytes) {
+		for (unsigned int i = 0; i < bytes; i++) {
+			outs.put((char) (value & 0xff));
+			value >>= 8;
+		}
+	}
+
+	const bool twoByteCodes;
+	enum { maxLineLength = 2049 };	// longest string value allowed in DXF
+	bool haveCode;			// writeText has read a group code, the value line is next
+	unsigned int textCode;
+	char line[maxLineLength + 1];	// current line of writeText
+	unsigned int lineLength;
+};
+
 
 /* results: (25.12.2001) (v - VoloView ; i - IntelliCAD)
 p2ed -f dxf_s:-splineasbezier 			curvetest.ps curve_bz.dxf v ok  i   ok
@@ -666,13 +878,18 @@ drvDXF::derivedConstructor(drvDXF):
 	trailer(dxf14acadtrailer),
 #endif
 	layers(new DXFLayers),
+	layerCache(256, (LayerInfo *) 0),
+	layerCacheEntries(0),
+	lastLayer(0),
+	headerWriter(0),
+	writer(0),
 	handleint(255),
 	scalefactor(1.0f),
 	buffer(tempFile.asOutput())
 
 {
 	const bool withcurves = Pdriverdesc && Pdriverdesc->backendSupportsCurveto;
-	if (!withcurves) { 
+	if (!withcurves && !options->lwpolyline) { // LWPOLYLINE needs the R14 format
 		formatis14 = false; // if no curves are generated by the frontent, no splines can occur and thus the old header is sufficient
 		header_prelayer1  = dxf9shortheader_prelayer;
 		header_prelayer2  = 0;
@@ -707,20 +924,33 @@ drvDXF::derivedConstructor(drvDXF):
 					options->splineprecision = 2;
 			}
 
-	outf << header_prelayer1;
+	if (options->binary) {
+		// the text format is written in text mode, only -binary needs binary mode
+		ctorOK &= close_output_file_and_reopen_in_binary_mode();
+		// R12 (AC1009) uses 1 byte group codes, the R14 header 2 byte group codes
+		const bool twoByteCodes = (header_prelayer1 != dxf9shortheader_prelayer);
+		DXFBinaryWriter::writeSentinel(outf);
+		headerWriter = new DXFBinaryWriter(outf, twoByteCodes);
+		writer = new DXFBinaryWriter(buffer, twoByteCodes);
+	} else {
+		headerWriter = new DXFTextWriter(outf);
+		writer = new DXFTextWriter(buffer);
+	}
+
+	headerWriter->writeText(header_prelayer1);
 	if (formatis14) {
 		if(options->mm) {
-			outf <<
+			headerWriter->writeText(
 				"$MEASUREMENT\n"
 				" 70\n"
 				"1\n" // 1 means metrix - 0 english
-			;
+			);
 		} else {
-			outf <<
+			headerWriter->writeText(
 				"$MEASUREMENT\n"
 				" 70\n"
 				"0\n" // 1 means metrix - 0 english
-			;
+			);
 		}
 	} else {
 		//
@@ -731,7 +961,7 @@ drvDXF::derivedConstructor(drvDXF):
 		// still displayed in inch-mode since that seems to be the default in DXF.
 		//
 	}
-	if (header_prelayer2) outf << header_prelayer2;
+	if (header_prelayer2) headerWriter->writeText(header_prelayer2);
 	if (options->mm) {
 		//debug cout << "mm enabled " << endl;
 		scalefactor = 25.4f/72.0f;
@@ -742,42 +972,43 @@ drvDXF::derivedConstructor(drvDXF):
 
 }
 
-void drvDXF::writelayerentry(ostream & outs, unsigned int color, const char * layername) {
-				outs <<
+void drvDXF::writelayerentry(DXFGroupWriter & outs, unsigned int color, const char * layername) {
+				outs.writeText(
 					"  0\n"
-					"LAYER\n";
+					"LAYER\n");
 				if (formatis14) {
 					writeHandle(outs);
-					outs <<
+					outs.writeText(
 						"100\n"
 						"AcDbSymbolTableRecord\n"
 						"100\n"
-						"AcDbLayerTableRecord\n";
+						"AcDbLayerTableRecord\n");
 				}
-				outs << "  2\n" 
-					<< layername << endl; // layername
-				outs <<
+				outs.writeString(2, layername); // layername
+				outs.writeText(
 					" 70\n"
-					"0\n"  // unfrozen
-					" 62\n";
-				outs << color << endl; // color
-				outs << "  6\n"
-					"CONTINUOUS\n" ;		// linestyle
+					"0\n");  // unfrozen
+				outs.writeInt(62, color); // color
+				outs.writeText("  6\n"
+					"CONTINUOUS\n");		// linestyle
 }
 
 drvDXF::~drvDXF()
 {
 	// write size of color definition table
+	// (the header ends with the group code, the value follows here)
 	if (options->colorsToLayers) {
-		outf << layers->numberOfLayers + 4 << endl; // 2 layers for C00-00-00-BLACK and CFF-FF-FF-WHITE and one predefined and one reserve
+		char numberOfLayers[20];
+		sprintf_s(TARGETWITHLEN(numberOfLayers,20),"%u\n",layers->numberOfLayers + 4); // 2 layers for C00-00-00-BLACK and CFF-FF-FF-WHITE and one predefined and one reserve
+		headerWriter->writeText(numberOfLayers);
 	} else {
-		outf << "1" << endl;
+		headerWriter->writeText("1\n");
 	}
-	if (formatis14) outf << layer0def; else outf << layer0short;
+	headerWriter->writeText(formatis14 ? layer0def : layer0short);
 	if (options->colorsToLayers) {
 		// write the layer definitions
-		writelayerentry(outf,7,"C00-00-00-BLACK"); // both black and white have color 7 ("visible")
-		writelayerentry(outf,7,"CFF-FF-FF-WHITE");
+		writelayerentry(*headerWriter,7,"C00-00-00-BLACK"); // both black and white have color 7 ("visible")
+		writelayerentry(*headerWriter,7,"CFF-FF-FF-WHITE");
 		for (unsigned int i = 0; i < DXFColor::numberOfColors; i++) {
 			DXFLayers::Layer * layer = layers->LayerTable[i];
 			while (layer) {
@@ -785,7 +1016,7 @@ drvDXF::~drvDXF()
 				if (options->dumplayernames) {
 					cout << "Layer (generated): " << DXFLayers::getLayerName(layer->rgb.r,layer->rgb.g,layer->rgb.b) << endl;
 				}
-				writelayerentry(outf,i,DXFLayers::getLayerName(layer->rgb.r,layer->rgb.g,layer->rgb.b));
+				writelayerentry(*headerWriter,i,DXFLayers::getLayerName(layer->rgb.r,layer->rgb.g,layer->rgb.b));
 				layer = pnext;
 			}
 		}
@@ -794,17 +1025,18 @@ drvDXF::~drvDXF()
 			if (options->dumplayernames) {
 				cout << "Layer (defined in input): " << nl->layerName.value() << endl;
 			}
-			writelayerentry(outf,7,nl->layerName.value());
+			writelayerentry(*headerWriter,7,nl->layerName.value());
 			nl = nl->next;
 		}
 	}
 
-	outf << header_postlayer;
+	headerWriter->writeText(header_postlayer);
 	// now we can copy the buffer the output
-	ifstream & inbuffer = tempFile.asInput();
-	copy_file(inbuffer, outf);
+	tempFile.copyTo(outf);
 
-	outf << trailer;
+	headerWriter->writeText(trailer);
+	delete headerWriter; headerWriter = 0;
+	delete writer; writer = 0;
 	//lint -esym(1740,header) // no need to free header.
 	//lint -esym(1740,trailer) // no need to free trailer.
 	header_prelayer1 = 0;
@@ -812,17 +1044,30 @@ drvDXF::~drvDXF()
 	header_postlayer = 0;
 	trailer = 0;
 	delete layers; layers = 0;
+	for (size_t i = 0; i < layerCache.size(); i++) {
+		LayerInfo * entry = layerCache[i];
+		while (entry) {
+			LayerInfo * pnext = entry->next;
+			delete entry;
+			entry = pnext;
+		}
+		layerCache[i] = 0;
+	}
+	layerCacheEntries = 0;
+	lastLayer = 0;
 	options=0;
 }
 
-void drvDXF::writeHandle(ostream & outs) {
+void drvDXF::writeHandle(DXFGroupWriter & outs) {
 
 	// VoloView needs the handle, intellicad doesn't need it but they don't harm
-	outs << "  5\n" << hex << handleint << dec << endl;
+	char handle[20];
+	sprintf_s(TARGETWITHLEN(handle,20),"%lx",handleint);
+	outs.writeString(5, handle);
 	handleint++;
 }
 
-void drvDXF::writeLayer(float r, float g, float b, const RSString& colorName) 
+void drvDXF::writeLayer(const LayerInfo & layer) 
 {
 	//
 	// Some notes about layers:
@@ -832,41 +1077,9 @@ void drvDXF::writeLayer(float r, float g, float b, const RSString& colorName)
 	// or define its own color (so far BYLAYER is not used by pstoedit)
 	//
 
-	buffer << "  8\n";
-#if 1
-	buffer << calculateLayerString(r,g,b,colorName) << endl;
-#else
-	if (options->colorsToLayers) {		
-		const float roundinglimit = 0.001f;
-
-		// map black (0,0,0) to layer 7-black and white (1,1,1) to 7-white
-
-		if (colorName != "") {
-			cout << colorName << endl;
-		} else if ((r < roundinglimit) && 
-			(g < roundinglimit) && 
-			(b < roundinglimit) ) {
-					// black
-			buffer << "C00-00-00-BLACK" << endl;
-		} else if (	(r > (1.0f- roundinglimit)) && 
-					(g > (1.0f- roundinglimit)) && 
-					(b > (1.0f- roundinglimit)) ) {
-			buffer << "CFF-FF-FF-WHITE" << endl;
-						// white
-		} else {
-			const unsigned int dxfcolor = DXFColor::getDXFColor(r,g,b,1);
-			const char * layerString = DXFLayers::getLayerName(r,g,b);
-			if (! (layers->alreadyDefined(r,g,b,dxfcolor))) {
-				layers->defineLayer(r,g,b,dxfcolor);
-	//			cout << "defined new layer " << layerString << endl;
-			}
-			buffer << layerString << endl;
-		}
-	} else {
-		buffer << "0\n";
-	}
-#endif
+	writer->writeString(8, layer.layerName.value());
 }
+
 RSString drvDXF::calculateLayerString(float r, float g, float b, const RSString& colorName) 
 {
 	//
@@ -909,27 +1122,81 @@ RSString drvDXF::calculateLayerString(float r, float g, float b, const RSString&
 	}
 }
 
-bool drvDXF::wantedLayer(float r, float g, float b,const RSString& colorName)  // layer shall be written
+bool drvDXF::wantedLayer(const RSString& layerName) const // layer shall be written
 { 
-	// inspect layerpositivfilter and layerpositivfilter
-	// use colorname if set, else calculate layername from color
-	// then if positivfilter is set, then check if contained in that one -> true
+	// inspect layerpositivfilter and layernegativfilter
+	// if positivfilter is set, then check if contained in that one -> true
 	// else if negativfilter is set, then check if contained in that one -> false
 	// else -> true
-	static const RSString comma(","); // used as delimiter for string based containment test
+	const RSString comma(","); // used as delimiter for string based containment test
 	if (options->layerpositivfilter.value != "" ) {
-		static const RSString compareto = comma + options->layerpositivfilter.value + comma;
-		const RSString layerstring = comma + calculateLayerString(r,g,b,colorName) + comma ;
-		// cout << "L: " << layerstring << " P:" << options->layerpositivfilter << " " << options->layerpositivfilter.value.contains(layerstring) << endl;
-		return compareto.contains(layerstring);
+		const RSString compareto = comma + options->layerpositivfilter.value + comma;
+		return compareto.contains(comma + layerName + comma);
 	} else if (options->layernegativfilter.value != "" ) {
-		const RSString layerstring = comma + calculateLayerString(r,g,b,colorName) + comma;
-		static const RSString compareto = comma + options->layerpositivfilter.value + comma;
-		// cout << "L: " << layerstring << " N:" << options->layernegativfilter << " " << !options->layernegativfilter.value.contains(layerstring) << endl;
-		return !compareto.contains(layerstring);
+		const RSString compareto = comma + options->layernegativfilter.value + comma;
+		return !compareto.contains(comma + layerName + comma);
 	} else return true;
 }
 
+// bucket of a color in layerCache, before the reduction to the table size (the low
+// bits are used): the 24 bit color mixed by the finalizer of MurmurHash3, so that
+// every bit of R, G and B changes about half of the low bits
+unsigned int drvDXF::layerHash(float r, float g, float b)
+{
+	unsigned long h = (floatColTointCol(r) << 16) | (floatColTointCol(g) << 8) | floatColTointCol(b);
+	h ^= h >> 16;
+	h = (h * 0x85EBCA6BUL) & 0xFFFFFFFFUL;
+	h ^= h >> 13;
+	h = (h * 0xC2B2AE35UL) & 0xFFFFFFFFUL;
+	h ^= h >> 16;
+	return (unsigned int) h;
+}
+
+// doubles the number of buckets, so that the chains stay short for any number of colors
+void drvDXF::growLayerCache()
+{
+	std::vector<LayerInfo *> oldCache(layerCache.size() * 2, (LayerInfo *) 0);
+	oldCache.swap(layerCache);
+	for (size_t i = 0; i < oldCache.size(); i++) {
+		LayerInfo * entry = oldCache[i];
+		while (entry) {
+			LayerInfo * const pnext = entry->next;
+			const size_t index = layerHash(entry->r, entry->g, entry->b) & (layerCache.size() - 1);
+			entry->next = layerCache[index];
+			layerCache[index] = entry;
+			entry = pnext;
+		}
+	}
+}
+
+const drvDXF::LayerInfo & drvDXF::resolveLayer(float r, float g, float b, const RSString& colorName)
+{
+	// Calculating the layer name needs the nearest DXF color and some string operations.
+	// So this is done only once per color and the result is kept in a hash table, which
+	// grows with the number of colors.
+	// Consecutive entities (e.g. the vertices of a path) mostly have the same color,
+	// so the last entry is checked first.
+	if (lastLayer && lastLayer->matches(r, g, b, colorName)) return *lastLayer;
+
+	size_t index = layerHash(r, g, b) & (layerCache.size() - 1);
+	LayerInfo * entry = layerCache[index];
+	while (entry && !entry->matches(r, g, b, colorName)) entry = entry->next;
+	if (!entry) {
+		if (layerCacheEntries >= layerCache.size()) {
+			growLayerCache();
+			index = layerHash(r, g, b) & (layerCache.size() - 1);
+		}
+		entry = new LayerInfo(r, g, b, colorName, layerCache[index]);
+		entry->layerName = calculateLayerString(r, g, b, DXFLayers::normalizeColorName(colorName));
+		entry->dxfColor = DXFColor::getDXFColor(r, g, b);
+		entry->wanted = wantedLayer(entry->layerName);
+		layerCache[index] = entry;
+		layerCacheEntries++;
+	}
+	lastLayer = entry;
+	return *entry;
+}
+
 void drvDXF::close_page()
 {
 /*buffer << "#Seite beendet.\n";*/
@@ -942,80 +1209,112 @@ void drvDXF::open_page()
 
 void drvDXF::show_text(const TextInfo & textinfo)
 {
-	if (wantedLayer(textinfo.currentR, textinfo.currentG, textinfo.currentB,DXFLayers::normalizeColorName(textinfo.colorName))) {
-	buffer << "  0\n"
-			"TEXT\n";
+	const LayerInfo & layer = resolveLayer(textinfo.currentR, textinfo.currentG, textinfo.currentB, textinfo.colorName);
+	if (layer.wanted) {
+	writer->writeText("  0\n"
+			"TEXT\n");
 
 	if (formatis14) {
-		writeHandle(buffer);
-		buffer << "100\n" "AcDbEntity\n";
-		writeLayer(textinfo.currentR, textinfo.currentG, textinfo.currentB,DXFLayers::normalizeColorName(textinfo.colorName)); //"  8\n" "0\n"
-		buffer << "100\n" "AcDbText\n";
+		writeHandle(*writer);
+		writer->writeText("100\n" "AcDbEntity\n");
+		writeLayer(layer); //"  8\n" "0\n"
+		writer->writeText("100\n" "AcDbText\n");
 	} else {
-		writeLayer(textinfo.currentR, textinfo.currentG, textinfo.currentB,DXFLayers::normalizeColorName(textinfo.colorName)); //buffer << "  8\n" "0\n";
+		writeLayer(layer); //buffer << "  8\n" "0\n";
 	}
 
 	// color
-	if (!options->colorsToLayers) buffer << " 62\n     " << DXFColor::getDXFColor(textinfo.currentR,
-												  textinfo.currentG, 
-												  textinfo.currentB)
-		<< "\n";
-	buffer << " 10\n" << textinfo.x * scalefactor << "\n";
-	buffer << " 20\n" << textinfo.y * scalefactor << "\n";
-
-	buffer << " 30\n" << 0.0 << "\n";
-	buffer << " 40\n" << textinfo.currentFontSize * scalefactor << "\n";
-	buffer << "  1\n" << textinfo.thetext.value() << "\n";
-	buffer << " 50\n" << textinfo.currentFontAngle << "\n";
+	if (!options->colorsToLayers) writer->writeInt(62, layer.dxfColor, true);
+	writer->writeReal(10, textinfo.x * scalefactor);
+	writer->writeReal(20, textinfo.y * scalefactor);
+
+	writer->writeReal(30, 0.0);
+	writer->writeReal(40, textinfo.currentFontSize * scalefactor);
+	writer->writeString(1, textinfo.thetext.value());
+	writer->writeReal(50, textinfo.currentFontAngle);
 	if (formatis14) {
-		buffer << "100\n"
-				"AcDbText\n";
+		writer->writeText("100\n"
+				"AcDbText\n");
 	}
 	}
 }
 
 void drvDXF::printPoint(const Point & p, unsigned short add)
 {
-	buffer << " " << add << "\n" << p.x_* scalefactor << "\n";
-	buffer << " " << 10 + add << "\n" << p.y_* scalefactor << "\n";
-	buffer << " " << 20 + add << "\n" << "0.0" << "\n";
+	writer->writeReal(add, p.x_* scalefactor);
+	writer->writeReal(10 + add, p.y_* scalefactor);
+	writer->writeReal(20 + add, 0.0, "0.0");
 }
 
 void drvDXF::drawVertex(const Point & p, bool withlinewidth, int val70)
 {
-	if (wantedLayer(currentR(), currentG(), currentB(),DXFLayers::normalizeColorName(currentColorName()))) {
-	buffer << "  0\nVERTEX\n"; // "  8\n0\n";
-	writeLayer(currentR(), currentG(), currentB(),DXFLayers::normalizeColorName(currentColorName()));
+	if (currentLayer().wanted) {
+	writer->writeText("  0\nVERTEX\n"); // "  8\n0\n";
+	writeLayer(currentLayer());
 	printPoint(p, 10);
 	if (withlinewidth) {
 		const double lineWidth = currentLineWidth()* scalefactor;
-		buffer << " 40\n" << lineWidth << "\n 41\n" << lineWidth << "\n";
+		writer->writeReal(40, lineWidth);
+		writer->writeReal(41, lineWidth);
 	}
 	if (val70)					// used only for try with spline type polylines (which doesn't work anyway)
-		buffer << " 70\n    16\n";
+		writer->writeText(" 70\n    16\n");
 	}
 }
 
 void drvDXF::drawLine(const Point & start_p, const Point & end_p)
 {
-if (wantedLayer(currentR(), currentG(), currentB(),DXFLayers::normalizeColorName(currentColorName()))) {
-	buffer << "  0\nLINE\n"; // "  8\n0\n";
+if (currentLayer().wanted) {
+	writer->writeText("  0\nLINE\n"); // "  8\n0\n";
 	if (formatis14) {
-		writeHandle(buffer);
+		writeHandle(*writer);
 		//entity 
-		buffer <<	"100\n" "AcDbEntity\n";
-		writeLayer(currentR(), currentG(), currentB(),DXFLayers::normalizeColorName(currentColorName())); //buffer <<	"  8\n" "0\n" ;
-		buffer <<	"100\n" "AcDbLine" << endl;
+		writer->writeText("100\n" "AcDbEntity\n");
+		writeLayer(currentLayer()); //buffer << "  8\n" "0\n" ;
+		writer->writeText("100\n" "AcDbLine\n");
 	} else {
-		writeLayer(currentR(), currentG(), currentB(),DXFLayers::normalizeColorName(currentColorName()));
+		writeLayer(currentLayer());
 	}
 	// color
-	if (!options->colorsToLayers) buffer << " 62\n     " << DXFColor::getDXFColor(currentR(), currentG(), currentB()) << '\n';
+	if (!options->colorsToLayers) writer->writeInt(62, currentLayer().dxfColor, true);
 	printPoint(start_p, 10);
 	printPoint(end_p, 11);
 }
 }
 
+void drvDXF::drawLWPolyline()
+{
+	// all vertices go into the one entity as 10/20 pairs - no VERTEX entities 
+	// with layer, width and z coordinate for each point
+	unsigned int numberOfPoints = numberOfElementsInPath();
+	if (isPolygon() && (numberOfPoints > 2)) {
+		// closed via flag 70 - the segment back to the start point is not needed
+		const basedrawingelement & last = pathElement(numberOfPoints - 1);
+		if ((last.getType() == closepath) || (last.getPoint(0) == pathElement(0).getPoint(0))) {
+			numberOfPoints--;
+		}
+	}
+	const LayerInfo & layer = currentLayer();
+	writer->writeText("  0\nLWPOLYLINE\n");
+	writeHandle(*writer);
+	writer->writeText("100\n" "AcDbEntity\n");
+	writeLayer(layer);
+	// color
+	if (!options->colorsToLayers) writer->writeInt(62, layer.dxfColor, true);
+	writer->writeText("100\n" "AcDbPolyline\n");
+	writer->writeInt(90, numberOfPoints);
+	writer->writeInt(70, isPolygon() ? 1 : 0);
+	// constant width
+	writer->writeReal(43, currentLineWidth() * scalefactor);
+	// The path elements are lines only, so there are no arc segments which 
+	// would need a bulge (42) value
+	for (unsigned int t = 0; t < numberOfPoints; t++) {
+		const Point & p = pathElement(t).getPoint(0);
+		writer->writeReal(10, p.x_ * scalefactor);
+		writer->writeReal(20, p.y_ * scalefactor);
+	}
+}
+
 #if 0
 0 LINE
 	5
@@ -1115,7 +1414,7 @@ const unsigned short RationalSpline = 4 ; //= Rational spline
 
 
 void drvDXF::writesplinetype(const unsigned short stype = 0) {
-	buffer << " 70\n     " << stype << "\n";	  /* spline type: */
+	writer->writeInt(70, stype, true);	  /* spline type: */
 }
 
 
@@ -1125,35 +1424,35 @@ void drvDXF::curvetoAsBezier(const basedrawingelement & elem, const Point & curr
 	// each curveto is one SPLINE element
 	// only the 4 points of the curveto are used
 	//
-if (wantedLayer(currentR(), currentG(), currentB(),DXFLayers::normalizeColorName(currentColorName()))) {
-	buffer << "  0\nSPLINE\n";
+if (currentLayer().wanted) {
+	writer->writeText("  0\nSPLINE\n");
 
-	writeHandle(buffer);
-	buffer << "100\n" "AcDbEntity\n";
-	writeLayer(currentR(), currentG(), currentB(),DXFLayers::normalizeColorName(currentColorName())); //buffer << "  8\n0\n";			/* Layer */
-	buffer << "100\n" "AcDbSpline\n";
+	writeHandle(*writer);
+	writer->writeText("100\n" "AcDbEntity\n");
+	writeLayer(currentLayer()); //buffer << "  8\n0\n";			/* Layer */
+	writer->writeText("100\n" "AcDbSpline\n");
 
-	buffer << "210\n0.0\n220\n0.0\n230\n1.0\n";	/* Norm vector */
+	writer->writeText("210\n0.0\n220\n0.0\n230\n1.0\n");	/* Norm vector */
 
-	if (!options->colorsToLayers) buffer << " 62\n     " << DXFColor::getDXFColor(currentR(), currentG(), currentB()) << '\n';
+	if (!options->colorsToLayers) writer->writeInt(62, currentLayer().dxfColor, true);
 
 	writesplinetype( 0 );
 
-	buffer << " 71\n     3\n";            /* degree of curve */
-	buffer << " 72\n     8\n";            /* no of knots */
-	buffer << " 73\n" << 4 << "\n";	/* no of control points */
+	writer->writeText(" 71\n     3\n");            /* degree of curve */
+	writer->writeText(" 72\n     8\n");            /* no of knots */
+	writer->writeInt(73, 4);	/* no of control points */
 
 	
 	// knot values 
-	buffer << " 40\n0.0\n"; 
-	buffer << " 40\n0.0\n";
-	buffer << " 40\n0.0\n";
-	buffer << " 40\n0.0\n";
+	writer->writeText(" 40\n0.0\n"); 
+	writer->writeText(" 40\n0.0\n");
+	writer->writeText(" 40\n0.0\n");
+	writer->writeText(" 40\n0.0\n");
 
-	buffer << " 40\n1.0\n"; 
-	buffer << " 40\n1.0\n";
-	buffer << " 40\n1.0\n";
-	buffer << " 40\n1.0\n";
+	writer->writeText(" 40\n1.0\n"); 
+	writer->writeText(" 40\n1.0\n");
+	writer->writeText(" 40\n1.0\n");
+	writer->writeText(" 40\n1.0\n");
 
 
 	//  START_POINT(first).x, START_POINT(first).y);
@@ -1182,34 +1481,34 @@ void drvDXF::curvetoAsNurb(const basedrawingelement & elem, const Point & curren
 	// Here we use the mapping to Nurbs as described in Schneiders Nurbs tutorial
 	// 
 	// 
-	if (wantedLayer(currentR(), currentG(), currentB(),DXFLayers::normalizeColorName(currentColorName()))) {
-	buffer << "  0\nSPLINE\n";
-	writeHandle(buffer);
-	buffer << "100\n" "AcDbEntity\n";
-	writeLayer(currentR(), currentG(), currentB(),DXFLayers::normalizeColorName(currentColorName())); //buffer << "  8\n0\n";			/* Layer */
-	buffer << "100\n" "AcDbSpline\n";
+	if (currentLayer().wanted) {
+	writer->writeText("  0\nSPLINE\n");
+	writeHandle(*writer);
+	writer->writeText("100\n" "AcDbEntity\n");
+	writeLayer(currentLayer()); //buffer << "  8\n0\n";			/* Layer */
+	writer->writeText("100\n" "AcDbSpline\n");
 
-	buffer << "210\n0.0\n220\n0.0\n230\n1.0\n";	/* Norm vector */
+	writer->writeText("210\n0.0\n220\n0.0\n230\n1.0\n");	/* Norm vector */
 
-	if (!options->colorsToLayers) buffer << " 62\n     " << DXFColor::getDXFColor(currentR(), currentG(), currentB()) << '\n';
+	if (!options->colorsToLayers) writer->writeInt(62, currentLayer().dxfColor, true);
 
 	writesplinetype( RationalSpline );
 
-	buffer << " 71\n     3\n";            /* degree of curve */
-	buffer << " 72\n     8\n";            /* no of knots */
+	writer->writeText(" 71\n     3\n");            /* degree of curve */
+	writer->writeText(" 72\n     8\n");            /* no of knots */
 
-	buffer << " 73\n" << 4 << "\n";	/* no of control points */
+	writer->writeInt(73, 4);	/* no of control points */
 
 	// knot values 
-	buffer << " 40\n0.0\n"; 
-	buffer << " 40\n0.0\n";
-	buffer << " 40\n0.0\n";
-	buffer << " 40\n0.0\n";
+	writer->writeText(" 40\n0.0\n"); 
+	writer->writeText(" 40\n0.0\n");
+	writer->writeText(" 40\n0.0\n");
+	writer->writeText(" 40\n0.0\n");
 
-	buffer << " 40\n1.0\n"; 
-	buffer << " 40\n1.0\n";
-	buffer << " 40\n1.0\n";
-	buffer << " 40\n1.0\n";
+	writer->writeText(" 40\n1.0\n"); 
+	writer->writeText(" 40\n1.0\n");
+	writer->writeText(" 40\n1.0\n");
+	writer->writeText(" 40\n1.0\n");
 
 
 	//  START_POINT(first).x, START_POINT(first).y);
@@ -1238,39 +1537,39 @@ void drvDXF::curvetoAsBSpline(const basedrawingelement & elem, const Point & cur
 	//
 	// The Bezier points are transformed to the corresponding B-Spline control points.
 	// 
-if (wantedLayer(currentR(), currentG(), currentB(),DXFLayers::normalizeColorName(currentColorName()))) {
-	buffer << "  0\nSPLINE\n";
-	writeHandle(buffer);
-	buffer << "100\n" "AcDbEntity\n";
-	writeLayer(currentR(), currentG(), currentB(),DXFLayers::normalizeColorName(currentColorName())); //buffer << "  8\n0\n";			/* Layer */
-	buffer << "100\n" "AcDbSpline\n";
+if (currentLayer().wanted) {
+	writer->writeText("  0\nSPLINE\n");
+	writeHandle(*writer);
+	writer->writeText("100\n" "AcDbEntity\n");
+	writeLayer(currentLayer()); //buffer << "  8\n0\n";			/* Layer */
+	writer->writeText("100\n" "AcDbSpline\n");
 
-	buffer << "210\n0.0\n220\n0.0\n230\n1.0\n";	/* Norm vector */
+	writer->writeText("210\n0.0\n220\n0.0\n230\n1.0\n");	/* Norm vector */
 
-	if (!options->colorsToLayers) buffer << " 62\n     " << DXFColor::getDXFColor(currentR(), currentG(), currentB()) << '\n';
+	if (!options->colorsToLayers) writer->writeInt(62, currentLayer().dxfColor, true);
 
 	writesplinetype(RationalSpline);     
-	buffer << " 71\n     3\n";        /* degree of curve */
+	writer->writeText(" 71\n     3\n");        /* degree of curve */
 #define bsplinewithknots
 #ifdef bsplinewithknots
-	buffer << " 72\n     8\n";	    /* no of knots */
+	writer->writeText(" 72\n     8\n");	    /* no of knots */
 #else
-	buffer << " 72\n     0\n";	    /* no of knots */
+	writer->writeText(" 72\n     0\n");	    /* no of knots */
 #endif
-	buffer << " 73\n" << 4 << "\n";	/*  no of control points */
+	writer->writeInt(73, 4);	/*  no of control points */
 
 
 #ifdef bsplinewithknots
 		// knot values 
-	buffer << " 40\n0.0\n"; 
-	buffer << " 40\n1.0\n";
-	buffer << " 40\n2.0\n";
-	buffer << " 40\n3.0\n";
+	writer->writeText(" 40\n0.0\n"); 
+	writer->writeText(" 40\n1.0\n");
+	writer->writeText(" 40\n2.0\n");
+	writer->writeText(" 40\n3.0\n");
 
-	buffer << " 40\n4.0\n"; 
-	buffer << " 40\n5.0\n";
-	buffer << " 40\n6.0\n";
-	buffer << " 40\n7.0\n";
+	writer->writeText(" 40\n4.0\n"); 
+	writer->writeText(" 40\n5.0\n");
+	writer->writeText(" 40\n6.0\n");
+	writer->writeText(" 40\n7.0\n");
 
 #endif
 
@@ -1322,48 +1621,48 @@ void drvDXF::curvetoAsOneSpline(const basedrawingelement & elem, const Point & c
 
 
 	// 
-	if (wantedLayer(currentR(), currentG(), currentB(),DXFLayers::normalizeColorName(currentColorName()))) {
-	buffer << "  0\nSPLINE\n";
-	writeHandle(buffer);
-	buffer << "100\n" "AcDbEntity\n";
-	writeLayer(currentR(), currentG(), currentB(),DXFLayers::normalizeColorName(currentColorName())); // << "  8\n0\n";			/* Layer */
-	buffer << "100\n" "AcDbSpline\n";
+	if (currentLayer().wanted) {
+	writer->writeText("  0\nSPLINE\n");
+	writeHandle(*writer);
+	writer->writeText("100\n" "AcDbEntity\n");
+	writeLayer(currentLayer()); // << "  8\n0\n";			/* Layer */
+	writer->writeText("100\n" "AcDbSpline\n");
 
-	buffer << "210\n0.0\n220\n0.0\n230\n1.0\n";	/* Norm vector */
+	writer->writeText("210\n0.0\n220\n0.0\n230\n1.0\n");	/* Norm vector */
 
 
-	if (!options->colorsToLayers) buffer << " 62\n     " << DXFColor::getDXFColor(currentR(), currentG(), currentB()) << '\n';
+	if (!options->colorsToLayers) writer->writeInt(62, currentLayer().dxfColor, true);
 
 	writesplinetype(RationalSpline);
 	/* 8: planar; 1 closed; 2 periodic; 16 linear */
-	buffer << " 71\n     3\n";             /* degree of curve */
+	writer->writeText(" 71\n     3\n");             /* degree of curve */
 
 
 
 #ifdef bsplinewithknots
-	buffer << " 72\n    10\n";	    /* no of knots */
+	writer->writeText(" 72\n    10\n");	    /* no of knots */
 			// knot values 
-	buffer << " 40\n0.0\n"; 
-	buffer << " 40\n1.0\n";
-	buffer << " 40\n2.0\n";
-	buffer << " 40\n3.0\n";
-
-	buffer << " 40\n4.0\n"; 
-	buffer << " 40\n5.0\n";
-	buffer << " 40\n6.0\n";
-	buffer << " 40\n7.0\n";
-	buffer << " 40\n8.0\n";
-	buffer << " 40\n9.0\n";
+	writer->writeText(" 40\n0.0\n"); 
+	writer->writeText(" 40\n1.0\n");
+	writer->writeText(" 40\n2.0\n");
+	writer->writeText(" 40\n3.0\n");
+
+	writer->writeText(" 40\n4.0\n"); 
+	writer->writeText(" 40\n5.0\n");
+	writer->writeText(" 40\n6.0\n");
+	writer->writeText(" 40\n7.0\n");
+	writer->writeText(" 40\n8.0\n");
+	writer->writeText(" 40\n9.0\n");
 
 #else
-	buffer << " 72\n     0\n";	    /* no of knots */
+	writer->writeText(" 72\n     0\n");	    /* no of knots */
 #endif
 
 
 // approach with the phantom nodes
 		// (abcd)   ->   d1=(b-a);d2=(d-c) ; (a-d1),(a),(a+d1==b),(d-d2==c),(d),(d+d2)
 
-	buffer << " 73\n" << 6 << "\n";	  /* no of control points */
+	writer->writeInt(73, 6);	  /* no of control points */
 
 
 //	buffer << " 74\n" << 2 << "\n";	  /* no of fit points */
@@ -1397,32 +1696,32 @@ void drvDXF::curvetoAsOneSpline(const basedrawingelement & elem, const Point & c
 
 void drvDXF::curvetoAsMultiSpline(const basedrawingelement & elem, const Point & currentpoint)
 {
-	if (wantedLayer(currentR(), currentG(), currentB(),DXFLayers::normalizeColorName(currentColorName()))) {
+	if (currentLayer().wanted) {
 	// multiple fit points on a single SPLINE
 	const unsigned int fitpoints = options->splineprecision.value ; // 4;
 
-	buffer << "  0\nSPLINE\n";
-	writeHandle(buffer);
-	buffer << "100\n" "AcDbEntity\n";
-	writeLayer(currentR(), currentG(), currentB(),DXFLayers::normalizeColorName(currentColorName())); // << "  8\n0\n";			/* Layer */
-	buffer << "100\n" "AcDbSpline\n";
+	writer->writeText("  0\nSPLINE\n");
+	writeHandle(*writer);
+	writer->writeText("100\n" "AcDbEntity\n");
+	writeLayer(currentLayer()); // << "  8\n0\n";			/* Layer */
+	writer->writeText("100\n" "AcDbSpline\n");
 
-	buffer << "210\n0.0\n220\n0.0\n230\n1.0\n";	/* Norm vector */
+	writer->writeText("210\n0.0\n220\n0.0\n230\n1.0\n");	/* Norm vector */
 
 
-	if (!options->colorsToLayers) buffer << " 62\n     " << DXFColor::getDXFColor(currentR(), currentG(), currentB()) << '\n';
+	if (!options->colorsToLayers) writer->writeInt(62, currentLayer().dxfColor, true);
 
 	writesplinetype( 0 );
 	/* 8: planar; 1 closed; 2 periodic; 16 linear */
-	buffer << " 71\n     3\n";	// , 3);             /* degree of curve */
-	buffer << " 72\n     0\n";	//, 0);             /* no of knots */
-	buffer << " 73\n" << 0 << "\n";	// ????????? , SPLINE_LIST_LENGTH (list));  /* no of control points */
-	buffer << " 74\n" << fitpoints << "\n";	// , SPLINE_LIST_LENGTH (list));  /* no of fit points */
+	writer->writeText(" 71\n     3\n");	// , 3);             /* degree of curve */
+	writer->writeText(" 72\n     0\n");	//, 0);             /* no of knots */
+	writer->writeInt(73, 0);	// ????????? , SPLINE_LIST_LENGTH (list));  /* no of control points */
+	writer->writeInt(74, fitpoints);	// , SPLINE_LIST_LENGTH (list));  /* no of fit points */
 
 
 //wogl                      buffer << " 42\n0.0000001\n"; // , 0.0000001);                /* knot tolerance */
 //wogl                      buffer << " 43\n0.0000001\n"; //, 0.0000001);             /* control-point tolerance */
-	buffer << " 44\n0.0000000001\n";	//, 0.0000000001);           /* fit tolerance */
+	writer->writeText(" 44\n0.0000000001\n");	//, 0.0000000001);           /* fit tolerance */
 
 	//  START_POINT(first).x, START_POINT(first).y);
 	/* 10 control points
@@ -1444,22 +1743,21 @@ void drvDXF::curvetoAsMultiSpline(const basedrawingelement & elem, const Point &
 
 void drvDXF::curvetoAsPolyLine(const basedrawingelement & elem, const Point & currentpoint)
 {
-	if (wantedLayer(currentR(), currentG(), currentB(),DXFLayers::normalizeColorName(currentColorName()))) {
+	if (currentLayer().wanted) {
 	// approximate spline with lines.
 	const unsigned int sections = options->splineprecision.value ; // 20;
 
-	buffer << "  0\nLWPOLYLINE\n";
-	writeHandle(buffer);
-	buffer << "100\n" "AcDbEntity\n";
-	writeLayer(currentR(), currentG(), currentB(),DXFLayers::normalizeColorName(currentColorName())); // buffer << "  8\n0\n";
-	buffer << "100\n" "AcDbPolyline\n";
-	buffer << " 90\n"; // number of edges
-	buffer << (sections+1) << endl;
-	buffer << " 70\n"
-			" 0\n";
+	writer->writeText("  0\nLWPOLYLINE\n");
+	writeHandle(*writer);
+	writer->writeText("100\n" "AcDbEntity\n");
+	writeLayer(currentLayer()); // buffer << "  8\n0\n";
+	writer->writeText("100\n" "AcDbPolyline\n");
+	writer->writeInt(90, sections+1); // number of edges
+	writer->writeText(" 70\n"
+			" 0\n");
 
 	// color
-	if (!options->colorsToLayers) buffer << " 62\n     " << DXFColor::getDXFColor(currentR(), currentG(), currentB()) << "\n";
+	if (!options->colorsToLayers) writer->writeInt(62, currentLayer().dxfColor, true);
 
 	// the following lines marked with nolw are not needed with the lwpolyline object.
 	// vertex flag (always 1)
@@ -1584,33 +1882,37 @@ void drvDXF::show_path()
 			const Point & q = pathElement(t).getPoint(0);
 			drawLine(p, q);
 		}
+	} else if (options->lwpolyline) {
+		if (currentLayer().wanted) {
+			drawLWPolyline();
+		}
 	} else {
-		if (wantedLayer(currentR(), currentG(), currentB(),DXFLayers::normalizeColorName(currentColorName()))) {
+		if (currentLayer().wanted) {
 		// no curveto and not forced to draw LINEs - use PolyLine/VERTEX then
-		buffer << "  0\nPOLYLINE\n";
+		writer->writeText("  0\nPOLYLINE\n");
 		// layer
-		writeLayer(currentR(), currentG(), currentB(),DXFLayers::normalizeColorName(currentColorName()));
+		writeLayer(currentLayer());
 		// color
-		if (!options->colorsToLayers) buffer << " 62\n     " << DXFColor::getDXFColor(currentR(), currentG(), currentB())
-			<< "\n";
+		if (!options->colorsToLayers) writer->writeInt(62, currentLayer().dxfColor, true);
 		// vertex flag (always 1)
-		buffer << " 66\n     1\n";
+		writer->writeText(" 66\n     1\n");
 		// base point
 		printPoint(Point(0.0f,0.0f), 10);
 		// buffer << " 10\n0.0\n 20\n0.0\n 30\n0.0\n";
 		if (isPolygon()) {
-			buffer << " 70\n     1\n";
+			writer->writeText(" 70\n     1\n");
 		}
 		// start and end line width
 		{
 			const float lineWidth = currentLineWidth();
-			buffer << " 40\n" << lineWidth << "\n 41\n" << lineWidth << "\n";
+			writer->writeReal(40, lineWidth);
+			writer->writeReal(41, lineWidth);
 		}
 		for (unsigned int t = 0; t < numberOfElementsInPath(); t++) {
 			const Point & p = pathElement(t).getPoint(0);
 			drawVertex(p, true, 0);
 		}
-		buffer << "  0\nSEQEND\n"" 8\n0\n";
+		writer->writeText("  0\nSEQEND\n"" 8\n0\n");
 		}
 	}
 }
@@ -23,6 +23,7 @@
 
 */
 #include "drvbase.h"
+#include <vector>
 
 class drvDXF : public drvbase {
 
@@ -35,6 +36,7 @@ public:
 	class DriverOptions : public ProgramOptions {
 	public:
 		OptionT < bool, BoolTrueExtractor > polyaslines ;
+		OptionT < bool, BoolTrueExtractor > lwpolyline ;
 		OptionT < bool, BoolTrueExtractor > mm ;
 		OptionT < bool, BoolTrueExtractor > colorsToLayers ;
 		OptionT < bool, BoolTrueExtractor > splineaspolyline ;
@@ -47,9 +49,11 @@ public:
 		OptionT < bool, BoolTrueExtractor > dumplayernames ;
 		OptionT < RSString, RSStringValueExtractor > layerpositivfilter;
 		OptionT < RSString, RSStringValueExtractor > layernegativfilter;
+		OptionT < bool, BoolTrueExtractor > binary ;
 
 		DriverOptions():
 			polyaslines(true,"-polyaslines",0,0,"use LINE instead of POLYLINE in DXF",0,false),
+			lwpolyline(true,"-lwpolyline",0,0,"use LWPOLYLINE (one entity with all vertices, DXF R14 and later) instead of POLYLINE and VERTEX in DXF (only for -f dxf)",0,false),
 			mm(true,"-mm",0,0,"use mm coordinates instead of points in DXF (mm=pt/72*25.4)",0,false),
 			colorsToLayers(true,"-ctl",0,0,"map colors to layers",0,false),
 			splineaspolyline(true,"-splineaspolyline",0,0,"approximate splines with PolyLines (only for -f dxf_s)",0,false),
@@ -62,10 +66,12 @@ public:
 				"number of samples to take from spline curve when doing approximation with -splineaspolyline or -splineasmultispline - should be >=2 (default 5)",0,5 ),
 			dumplayernames(true,"-dumplayernames",0,0,"dump all layer names found to standard output",0,false),
 			layerpositivfilter(true,"-layers","string",0,"layers to be shown (comma separated list of layer names, no space)",0,(const char *)""),
-			layernegativfilter(true,"-layerfilter","string",0,"layers to be hidden (comma separated list of layer names, no space)",0,(const char *)"")
+			layernegativfilter(true,"-layerfilter","string",0,"layers to be hidden (comma separated list of layer names, no space)",0,(const char *)""),
+			binary(true,"-binary",0,0,"write binary DXF instead of ASCII DXF",0,false)
 
 		{
 			ADD(polyaslines);
+			ADD(lwpolyline);
 			ADD(mm);
 			ADD(colorsToLayers);
 			ADD(splineaspolyline);
@@ -78,23 +84,46 @@ public:
 			ADD(dumplayernames);
 			ADD(layerpositivfilter);
 			ADD(layernegativfilter);
+			ADD(binary);
 		}
 	}*options;
 
 private:
 		void drawVertex(const Point & p, bool withlinewidth, int val70 = 0);
 		void drawLine(const Point & start,const Point & end);
+		void drawLWPolyline();
 		void curvetoAsOneSpline(const basedrawingelement & elem, const Point & currentpoint);
 		void curvetoAsMultiSpline(const basedrawingelement & elem, const Point & currentpoint);
 		void curvetoAsPolyLine(const basedrawingelement & elem, const Point & currentpoint);
 		void curvetoAsNurb(const basedrawingelement & elem, const Point & currentpoint);
 		void curvetoAsBSpline(const basedrawingelement & elem, const Point & currentpoint);
 		void curvetoAsBezier(const basedrawingelement & elem, const Point & currentpoint);
-		void writeHandle(ostream & outs) ;
-		void writeLayer(float r, float g, float b,const RSString& colorName) ;
-		void writelayerentry(ostream & outf, unsigned int color, const char * layername);
-		bool wantedLayer(float r, float g, float b,const RSString& colorName)  ; // layer shall be written
+		// layer and color of one fill/stroke color - resolved once per color and then
+		// looked up for each entity (see resolveLayer)
+		struct LayerInfo {
+			LayerInfo(float r_p, float g_p, float b_p, const RSString & colorName_p, LayerInfo * next_p) :
+				r(r_p), g(g_p), b(b_p), colorName(colorName_p), dxfColor(0), wanted(true), next(next_p) {}
+			bool matches(float r_p, float g_p, float b_p, const RSString & colorName_p) const {
+				return (r == r_p) && (g == g_p) && (b == b_p) && (colorName == colorName_p);
+			}
+			float r, g, b;
+			RSString colorName;		// as given by the frontend (not normalized)
+			RSString layerName;		// group code 8
+			unsigned int dxfColor;	// group code 62
+			bool wanted;			// passes -layers / -layerfilter
+			LayerInfo * next;
+			NOCOPYANDASSIGN(LayerInfo)
+		};
+		void growLayerCache();
+		static unsigned int layerHash(float r, float g, float b);
+
+		void writeHandle(class DXFGroupWriter & outs) ;
+		void writeLayer(const LayerInfo & layer) ;
+		void writelayerentry(class DXFGroupWriter & outs, unsigned int color, const char * layername);
+		bool wantedLayer(const RSString& layerName) const ; // layer shall be written
 		RSString calculateLayerString(float r, float g, float b,const RSString& colorName) ;
+		const LayerInfo & resolveLayer(float r, float g, float b, const RSString& colorName) ;
+		const LayerInfo & currentLayer() { return resolveLayer(currentR(), currentG(), currentB(), currentColorName()); }
 		
 		
 		void printPoint(const Point & p, unsigned short add );
@@ -112,11 +141,16 @@ private:
 		const char * header_postlayer;
 		const char * trailer;
 		class DXFLayers * layers;
+		std::vector<LayerInfo *> layerCache;	// hash table (power of two size), buckets are linked lists
+		unsigned int layerCacheEntries;
+		const LayerInfo * lastLayer;			// most recently used entry of layerCache
+		class DXFGroupWriter * headerWriter;	// header and tables to outf
+		class DXFGroupWriter * writer;			// entities to buffer
 		long handleint;
 		double scalefactor; 
 
 		TempFile  tempFile;
-		ofstream  &buffer;
+		ostream   &buffer;
 
 #include "drvfuncs.h"
 
@@ -215,8 +215,7 @@ drvFIG::~drvFIG()
 {
 	dumpnewcolors(outf);
 	// now we can copy the buffer the output
-	ifstream & inbuffer = tempFile.asInput();
-	copy_file(inbuffer, outf);
+	tempFile.copyTo(outf);
 	options=0;
 }
 
@@ -235,7 +234,7 @@ unsigned int
 
 void drvFIG::prpoint(ostream & os, const Point & p, bool withspaceatend) const
 {
-	os << (int) (PntFig * p.x_ + 0.5f) << " " << (int) (y_offset - (PntFig * p.y_) + 0.5f);
+	os << NumberText((int) (PntFig * p.x_ + 0.5f)) << " " << NumberText((int) (y_offset - (PntFig * p.y_) + 0.5f));
 	if (withspaceatend)
 		os << " ";
 }
@@ -58,7 +58,7 @@ public:
 private:
 	int	      objectId;
 	TempFile  tempFile;
-	ofstream  &buffer;
+	ostream   &buffer;
 	int	      imgcount;
 	int	      format; // either 31 or something else
 //	int	      startdepth; // Start depth for objectID (range 0 - 999)
@@ -27,23 +27,176 @@
 #include I_stdio
 #include I_string_h
 #include I_iostream
+#include I_fstream
+#include <sstream>
 #include <time.h>
+#include <math.h>
 #include <version.h>
 
+#ifndef M_PI
+#define M_PI		3.14159265358979323846
+#endif
+
+// values from the header written in open_page, used for the time estimate
+static const float feedrate = 10.0f;	// #1001, inch per minute
+static const float rapidrate = 100.0f;	// G00 moves, inch per minute (machine dependent, not in the output)
+static const float safeZ = 0.100f;		// #1000, inch
+static const float cuttingDepth = -0.010f;	// #1002, inch
+static const float ptToMM = 25.4f / 72.0f;	// #1003/#1004 scale to inches, in mm
+static const float pathTolerance = 0.003f;	// G64 P, inch
+
+// limits for -arcs
+static const unsigned int maxRun = 2000;	// points looked at for one line or arc
+static const unsigned int minArcSegments = 3;	// shorter runs are written as lines
+static const double maxArcRadius = 100000.0;	// points, flatter arcs are lines
+
+// used for -compact if there is no template file, same as misc/drvgcode.template
+static const char defaultTemplate[] =
+	"%%Header\n"
+	"( Generated by pstoedit _version_ from _filename_ at _date_ )\n"
+	"( gcode output module by Lawrence Glaister VE7IT )\n"
+	"_units_ G90 G17 ( units, absolute distance mode, XY plane )\n"
+	"G64 P_pathtolerance_ ( continuous mode with path tolerance )\n"
+	"M3 S15000 ( spindle cw at 15000rpm )\n"
+	"G4 P2 ( let spindle get to speed )\n"
+	"M7 ( mist coolant on )\n"
+	"G01 Z_safez_ F_feed_\n"
+	"%%Footer\n"
+	"G00 Z_safez_ ( safe Z )\n"
+	"M5 ( spindle off )\n"
+	"M9 ( coolant off )\n"
+	"M2 ( end of program )\n";
+
+static void replaceAll(std::string & text, const char * key, const std::string & value)
+{
+	const size_t keyLength = strlen(key);
+	for (size_t pos = text.find(key); pos != std::string::npos; pos = text.find(key, pos + value.size()))
+		text.replace(pos, keyLength, value);
+}
+
+// split a template into the lines after %%Header and the lines after %%Footer
+static void readTemplate(istream & in, std::string & header, std::string & footer)
+{
+	std::string * section = 0;
+	std::string line;
+	header = footer = "";
+	while (getline(in, line)) {
+		if (line.size() && (line[line.size() - 1] == '\r')) line.erase(line.size() - 1);
+		if (line == "%%Header") {
+			section = &header;
+		} else if (line == "%%Footer") {
+			section = &footer;
+		} else if (section) {
+			*section += line;
+			*section += '\n';
+		}
+	}
+}
+
 drvGCODE::derivedConstructor(drvGCODE):
-constructBase
+constructBase,
+g01BlocksWithoutArcs(0),
+g01Blocks(0),
+arcBlocks(0),
+unitsPerInch(1.0f),
+digits(4),
+lastMotion(noMotion),
+lastX(0), lastY(0), lastZ(0),
+haveXY(false), haveZ(false), haveFeed(false),
+toolPosition(0.0f, 0.0f)
 {
 // driver specific initializations
-	
+	if (options->compact) {
+		if (options->mm) unitsPerInch = 25.4f;
+		digits = options->precision;
+		if (digits < 0) digits = 0;
+		if (digits > 9) digits = 9;
+		loadTemplate();
+	} else if (options->arcs) {
+		// the default header scales X and Y by #1003 and #1004, and a negative one
+		// mirrors the drawing. That turns G02 into G03, and I/J would be scaled
+		// by the factors as well, so arcs are only written with the fixed units of -compact.
+		errf << "Option -arcs ignored - only valid together with -compact" << endl;
+		options->arcs = false;
+	}
+}
+
+void drvGCODE::loadTemplate()
+{
+	RSString name(options->templatefile.value);
+	if (!strlen(name.value())) {
+		name = drvbase::pstoeditDataDir();
+		name += directoryDelimiter;
+		name += GCODE_TEMPLATE_FILE;
+	}
+	if (fileExists(name.value())) {
+		ifstream templateFile(name.value());
+		readTemplate(templateFile, header, footer);
+		if (Verbose())
+			errf << "header and footer read from " << name.value() << endl;
+	} else {
+		if (strlen(options->templatefile.value.value()) || Verbose())
+			errf << "template file " << name.value() << " not found, using the built-in header and footer" << endl;
+		istringstream builtin(defaultTemplate);
+		readTemplate(builtin, header, footer);
+	}
 }
 
 drvGCODE::~drvGCODE()
 {
+	if (options->arcs && (options->jobstats || Verbose())) {
+		const unsigned long blocks = g01Blocks + arcBlocks;
+		errf << "arc fitting: " << g01BlocksWithoutArcs << " G01 blocks without -arcs, now "
+			<< g01Blocks << " G01 and " << arcBlocks << " G02/G03 blocks";
+		if (g01BlocksWithoutArcs)
+			errf << " (" << (long) (100.0 - 100.0 * blocks / g01BlocksWithoutArcs + 0.5) << "% less)";
+		errf << endl;
+	}
+	if (options->jobstats || Verbose())
+		stats.report(errf, outFileName.value(), options->jobstats);
 	options=0;
 }
 
+// add a G01 move to the statistics (G00 rapids have no configured speed)
+void drvGCODE::countLine(const Point & from, const Point & to)
+{
+	stats.addCut(pythagoras(to.x_ - from.x_, to.y_ - from.y_) * ptToMM, feedrate * 25.4f / 60.0f);
+}
+
+// replace the placeholders of a header or footer
+std::string drvGCODE::fillTemplate(const std::string & section) const
+{
+	//date and time of convertion
+	time_t kz = time(NULL);
+	struct tm *ozt = localtime(&kz);
+	char date[30];
+	strftime(date, (size_t) 30, "%c", ozt);
+
+	char number[numberBufferSize];
+	std::string text(section);
+	replaceAll(text, "_version_", version);
+	replaceAll(text, "_filename_", inFileName.value());
+	replaceAll(text, "_date_", date);
+	replaceAll(text, "_units_", options->mm ? "G21" : "G20");
+	replaceAll(text, "_feed_", std::string(number, formatQuantized(number, quantizeDecimal(feedrate * unitsPerInch, digits), digits, true)));
+	replaceAll(text, "_safez_", std::string(number, formatQuantized(number, quantizeDecimal(safeZ * unitsPerInch, digits), digits, true)));
+	replaceAll(text, "_depth_", std::string(number, formatQuantized(number, quantizeDecimal(cuttingDepth * unitsPerInch, digits), digits, true)));
+	replaceAll(text, "_pathtolerance_", std::string(number, formatQuantized(number, quantizeDecimal(pathTolerance * unitsPerInch, digits), digits, true)));
+	return text;
+}
+
 void drvGCODE::open_page()
 {
+	toolPosition = Point(0.0f, 0.0f);
+	if (options->compact) {
+		outf << fillTemplate(header);
+		// the template may leave the controller in any state
+		lastMotion = noMotion;
+		haveXY = haveZ = haveFeed = false;
+		stats.beginPage(currentPageNumber);
+		return;
+	}
+
 	//date and time of convertion
 	time_t kz = time(NULL);;
 	struct tm *ozt = localtime(&kz);
@@ -66,19 +219,26 @@ void drvGCODE::open_page()
 	outf << "G4 P2          ( let spindle get to speed )\n";
 	outf << "M7             ( mist coolant on )\n";
 	outf << "G01 Z#1000 F#1001\n";
+	stats.beginPage(currentPageNumber);
 }
 
 void drvGCODE::close_page()
 {
+	if (options->compact) {
+		outf << fillTemplate(footer);
+		stats.endPage();
+		return;
+	}
 	outf << "G00 Z#1000 ( safe Z )\n";
 	outf << "M5         ( spindle off )\n";
 	outf << "M9         ( coolant off )\n";
 	outf << "M2         ( end of program )\n";
+	stats.endPage();
 }
 
 void drvGCODE::show_path()
 {
-	Point currentPoint(0.0f, 0.0f);	
+	Point currentPoint = toolPosition;
 	const Point firstPoint = pathElement(0).getPoint(0);
 
 	for (unsigned int n = 0; n < numberOfElementsInPath(); n++) {
@@ -87,20 +247,38 @@ void drvGCODE::show_path()
 		switch (elem.getType()) {
 		case moveto:{
 				const Point & p = elem.getPoint(0);
-				outf << "\nG00 Z#1000\n";
-				outf << "G00 X[#1003*" << p.x_ << "] Y[#1004*" << p.y_ << "]\n";
-				outf << "G01 Z#1002\n";
+				if (options->arcs) flushPolyline();
+				writeMoveTo(p);
+				// retract to safe Z and move to p with G00, plunge to cutting depth with the feedrate
+				stats.addTravel(pythagoras(p.x_ - currentPoint.x_, p.y_ - currentPoint.y_) * ptToMM, rapidrate * 25.4f / 60.0f);
+				stats.addPierce((safeZ - cuttingDepth) / rapidrate * 60.0f + (safeZ - cuttingDepth) / feedrate * 60.0f);
 				currentPoint = p;
+				if (options->arcs) polyline.push_back(p);
 			}
 			break;
 		case lineto:{
 				const Point & p = elem.getPoint(0);
-				outf << "G01 X[#1003*" << p.x_ << "] Y[#1004*" << p.y_ << "]\n";
+				if (options->arcs) {
+					polyline.push_back(p);
+					g01BlocksWithoutArcs++;
+				} else {
+					writeLine(p);
+					countLine(currentPoint, p);
+				}
 				currentPoint = p;
 			}
 			break;
 		case closepath:
-				outf << "G01 X[#1003*" << firstPoint.x_ << "] Y[#1004*" << firstPoint.y_ << "]\n";
+				if (options->arcs) {
+					polyline.push_back(firstPoint);
+					g01BlocksWithoutArcs++;
+				} else {
+					writeLine(firstPoint);
+					countLine(currentPoint, firstPoint);
+				}
+				// the tool is back at the start of the path, a following curveto
+				// starts there (and the time estimate measures from there)
+				currentPoint = firstPoint;
 			break;
 
 		case curveto:{
@@ -116,10 +294,32 @@ void drvGCODE::show_path()
 			if ( fitpoints < 5 ) fitpoints = 5;
 			if ( fitpoints > 50 ) fitpoints = 50;
 
-			for (unsigned int s = 1; s < fitpoints; s++) {
-				const float t = 1.0f * s / (fitpoints - 1);
-				const Point pt = PointOnBezier(t, currentPoint, cp1, cp2, ep);
-				outf << " G01 X[#1003*" << pt.x_ << "] Y[#1004*" << pt.y_ << "]\n";
+			if (options->arcs) {
+				g01BlocksWithoutArcs += fitpoints - 1;
+				// Sample the curve finely, such that the samples are within a quarter of the tolerance.
+				// |B''| <= 6 * max(|p0 - 2p1 + p2|, |p1 - 2p2 + p3|) and n chords of a curve
+				// deviate at most |B''| / (8 n^2) from it.
+				const Point d1 = currentPoint + (cp1 * -2.0f) + cp2;
+				const Point d2 = cp1 + (cp2 * -2.0f) + ep;
+				const double maxSecondDerivative = 6.0 * max(pythagoras(d1.x_, d1.y_), pythagoras(d2.x_, d2.y_));
+				const double sampleTolerance = options->arctolerance / 4.0;
+				unsigned int samples = (sampleTolerance > 0.0) ? 
+					(unsigned int) ceil(sqrt(maxSecondDerivative / (8.0 * sampleTolerance))) : maxRun;
+				if (samples < 1) samples = 1;
+				if (samples > maxRun) samples = maxRun;
+				for (unsigned int s = 1; s <= samples; s++) {
+					const float t = 1.0f * s / samples;
+					polyline.push_back(PointOnBezier(t, currentPoint, cp1, cp2, ep));
+				}
+			} else {
+				Point lastPoint = currentPoint;
+				for (unsigned int s = 1; s < fitpoints; s++) {
+					const float t = 1.0f * s / (fitpoints - 1);
+					const Point pt = PointOnBezier(t, currentPoint, cp1, cp2, ep);
+					writeLine(pt, true);
+					countLine(lastPoint, pt);
+					lastPoint = pt;
+				}
 			}
 			currentPoint = ep;
 
@@ -131,6 +331,164 @@ void drvGCODE::show_path()
 			break;
 		}
 	}
+	if (options->arcs) flushPolyline();
+	toolPosition = currentPoint;
+}
+
+//
+// Arc fitting (-arcs)
+//
+// The collected points of a path are written greedily: from the current point the
+// longest run of points is taken that fits either a line or a circular arc. A run fits
+// if all its points and the midpoints of its segments are within the fit tolerance
+// of the line or arc. Curves are sampled with a quarter of -arctolerance and fitted
+// with the other three quarters, so the written path stays within -arctolerance of 
+// the original path.
+//
+
+static inline double distanceToSegment(const Point & p, const Point & a, const Point & b)
+{
+	const double dx = b.x_ - a.x_;
+	const double dy = b.y_ - a.y_;
+	const double len2 = dx * dx + dy * dy;
+	double t = (len2 > 0.0) ? ((p.x_ - a.x_) * dx + (p.y_ - a.y_) * dy) / len2 : 0.0;
+	if (t < 0.0) t = 0.0;
+	if (t > 1.0) t = 1.0;
+	const double ex = a.x_ + t * dx - p.x_;
+	const double ey = a.y_ + t * dy - p.y_;
+	return sqrt(ex * ex + ey * ey);
+}
+
+// circle through three points, false if they are (nearly) collinear
+static bool circleThrough(const Point & a, const Point & b, const Point & c, Point & center, float & radius)
+{
+	const double bx = b.x_ - a.x_, by = b.y_ - a.y_;
+	const double cx = c.x_ - a.x_, cy = c.y_ - a.y_;
+	const double d = 2.0 * (bx * cy - by * cx);
+	if (fabs(d) < 1e-9) return false;
+	const double b2 = bx * bx + by * by;
+	const double c2 = cx * cx + cy * cy;
+	const double ux = (cy * b2 - by * c2) / d;
+	const double uy = (bx * c2 - cx * b2) / d;
+	center = Point((float) (a.x_ + ux), (float) (a.y_ + uy));
+	radius = (float) sqrt(ux * ux + uy * uy);
+	return true;
+}
+
+static inline float fitTolerance(double arctolerance) { return (float) (arctolerance * 0.75); }
+
+// does the run of points from first to last fit a line resp. (arc) the circle through
+// its first, middle and last point? center and ccw are set for a fitting arc.
+bool drvGCODE::runFits(unsigned int first, unsigned int last, bool arc, Point & center, bool & ccw) const
+{
+	const Point & a = polyline[first];
+	const Point & c = polyline[last];
+	if (arc) {
+		const Point & b = polyline[(first + last) / 2];
+		float radius = 0.0f;
+		if (!circleThrough(a, b, c, center, radius)) return false;
+		ccw = ((b.x_ - a.x_) * (c.y_ - b.y_) - (b.y_ - a.y_) * (c.x_ - b.x_)) > 0.0f;
+		return arcFits(first, last, center, radius, ccw);
+	} else {
+		const float tolerance = fitTolerance(options->arctolerance);
+		for (unsigned int m = first + 1; m < last; m++) {
+			if (distanceToSegment(polyline[m], a, c) > tolerance) return false;
+		}
+		return true;
+	}
+}
+
+// Returns the last point of the longest run starting at first that fits a line
+// resp. an arc, 0 if no arc fits. The end of the run is searched with doubling
+// steps and then by bisection, so finding a run of n points costs O(n log n)
+// point checks. Shorter runs of a fitting run fit as well, apart from rare cases
+// near the tolerance, in which a shorter run than possible is taken.
+unsigned int drvGCODE::longestRun(unsigned int first, bool arc, Point & center, bool & ccw) const
+{
+	const unsigned int shortest = first + (arc ? minArcSegments : 1);
+	const unsigned int limit = min((unsigned int) polyline.size() - 1, first + maxRun);
+	if (shortest > limit) return arc ? 0 : limit;
+	Point runCenter;
+	bool runCcw = false;
+	if (arc && !runFits(first, shortest, arc, center, ccw)) return 0;
+	unsigned int fits = shortest;		// the longest run known to fit
+	unsigned int fails = limit + 1;		// the shortest run known not to fit
+	for (unsigned int step = 1; fits < limit; step *= 2) {
+		const unsigned int last = min(fits + step, limit);
+		if (!runFits(first, last, arc, runCenter, runCcw)) {
+			fails = last;
+			break;
+		}
+		fits = last;
+		center = runCenter;
+		ccw = runCcw;
+	}
+	while (fails - fits > 1) {
+		const unsigned int last = fits + (fails - fits) / 2;
+		if (runFits(first, last, arc, runCenter, runCcw)) {
+			fits = last;
+			center = runCenter;
+			ccw = runCcw;
+		} else {
+			fails = last;
+		}
+	}
+	return fits;
+}
+
+bool drvGCODE::arcFits(unsigned int first, unsigned int last, const Point & center, float radius, bool ccw) const
+{
+	const float tolerance = fitTolerance(options->arctolerance);
+	if (radius > maxArcRadius) return false;
+	// start and end point must differ, otherwise the controller would cut a full circle
+	if (pythagoras(polyline[last].x_ - polyline[first].x_, polyline[last].y_ - polyline[first].y_) <= tolerance) return false;
+	double sweep = 0.0;
+	for (unsigned int m = first; m <= last; m++) {
+		const Point & p = polyline[m];
+		if (fabs(pythagoras(p.x_ - center.x_, p.y_ - center.y_) - radius) > tolerance) return false;
+		if (m == last) break;
+		const Point & q = polyline[m + 1];
+		const Point mid((p.x_ + q.x_) / 2.0f, (p.y_ + q.y_) / 2.0f);
+		if (fabs(pythagoras(mid.x_ - center.x_, mid.y_ - center.y_) - radius) > tolerance) return false;
+		// the points have to go around the center in one direction
+		const double px = p.x_ - center.x_, py = p.y_ - center.y_;
+		const double qx = q.x_ - center.x_, qy = q.y_ - center.y_;
+		const double step = atan2(px * qy - py * qx, px * qx + py * qy);
+		if (ccw ? (step < 0.0) : (step > 0.0)) return false;
+		sweep += fabs(step);
+	}
+	return sweep < 2.0 * M_PI - 0.01;
+}
+
+void drvGCODE::flushPolyline()
+{
+	unsigned int first = 0;
+	while (first + 1 < polyline.size()) {
+		Point center;
+		bool ccw = false;
+		const unsigned int lineEnd = longestRun(first, false, center, ccw);
+		const unsigned int arcEnd = longestRun(first, true, center, ccw);
+		if (arcEnd > lineEnd) {
+			const Point & start = polyline[first];
+			const Point & end = polyline[arcEnd];
+			writeArc(ccw, end, center);
+			const double sx = start.x_ - center.x_, sy = start.y_ - center.y_;
+			const double ex = end.x_ - center.x_, ey = end.y_ - center.y_;
+			double sweep = atan2(sx * ey - sy * ex, sx * ex + sy * ey);
+			if (ccw && (sweep < 0.0)) sweep += 2.0 * M_PI;
+			if (!ccw && (sweep > 0.0)) sweep -= 2.0 * M_PI;
+			stats.addCut(fabs(sweep) * pythagoras((float) sx, (float) sy) * ptToMM, feedrate * 25.4f / 60.0f);
+			arcBlocks++;
+			first = arcEnd;
+		} else {
+			const Point & p = polyline[lineEnd];
+			writeLine(p);
+			countLine(polyline[first], p);
+			g01Blocks++;
+			first = lineEnd;
+		}
+	}
+	polyline.clear();
 }
 
 
@@ -155,3 +513,88 @@ static DriverDescriptionT < drvGCODE > D_gcode("gcode", "emc2 gcode format",
 												   DriverDescription::normalopen, false,	// if format supports multiple pages in one file
 												   false /*clipping */ );
  
+
+// retract, rapid move to p and plunge
+void drvGCODE::writeMoveTo(const Point & p)
+{
+	if (options->compact) {
+		writeBlock(rapid, 0, &safeZ, 0);
+		writeBlock(rapid, &p, 0, 0);
+		writeBlock(linear, 0, &cuttingDepth, 0);
+	} else {
+		outf << "\nG00 Z#1000\n";
+		outf << "G00 X[#1003*" << NumberText(p.x_) << "] Y[#1004*" << NumberText(p.y_) << "]\n";
+		outf << "G01 Z#1002\n";
+	}
+}
+
+void drvGCODE::writeLine(const Point & p, bool curveSample)
+{
+	if (options->compact) {
+		writeBlock(linear, &p, 0, 0);
+	} else {
+		outf << (curveSample ? " G01" : "G01") << " X[#1003*" << NumberText(p.x_) << "] Y[#1004*" << NumberText(p.y_) << "]\n";
+	}
+}
+
+// only with -compact, see the constructor
+void drvGCODE::writeArc(bool ccw, const Point & end, const Point & center)
+{
+	writeBlock(ccw ? counterclockwise : clockwise, &end, 0, &center);
+}
+
+// One block of -compact output. xy and the center of an arc are in points, z in
+// inches. The motion word is only written if it differs from the last one, X, Y
+// and Z only if they changed. Linear moves that do not move at all are dropped.
+// I and J are the difference of the quantized center and start point, so that the
+// radii to the written start and end point differ at most by the rounding of these.
+void drvGCODE::writeBlock(Motion motion, const Point * xy, const float * z, const Point * center)
+{
+	static const char * const motionWords[] = { "G00", "G01", "G02", "G03" };
+	const float unitsPerPoint = unitsPerInch / 72.0f;
+	const long long x = xy ? quantizeDecimal(xy->x_ * unitsPerPoint, digits) : lastX;
+	const long long y = xy ? quantizeDecimal(xy->y_ * unitsPerPoint, digits) : lastY;
+	const long long zValue = z ? quantizeDecimal(*z * unitsPerInch, digits) : lastZ;
+	const bool writeX = xy && (!haveXY || (x != lastX));
+	const bool writeY = xy && (!haveXY || (y != lastY));
+	const bool writeZ = z && (!haveZ || (zValue != lastZ));
+	if (!writeX && !writeY && !writeZ) return;	// an arc to the same point would be a full circle
+
+	char block[160];	// 6 words of at most 26 chars
+	unsigned int len = 0;
+	if (motion != lastMotion) {
+		block[len++] = ' ';
+		memcpy(block + len, motionWords[motion], 3);
+		len += 3;
+		lastMotion = motion;
+	}
+	if (writeX) {
+		block[len++] = ' '; block[len++] = 'X';
+		len += formatQuantized(block + len, x, digits, true);
+	}
+	if (writeY) {
+		block[len++] = ' '; block[len++] = 'Y';
+		len += formatQuantized(block + len, y, digits, true);
+	}
+	if (writeZ) {
+		block[len++] = ' '; block[len++] = 'Z';
+		len += formatQuantized(block + len, zValue, digits, true);
+	}
+	if (center) {
+		// arcs always have their center offsets, even if they are the same as before
+		block[len++] = ' '; block[len++] = 'I';
+		len += formatQuantized(block + len, quantizeDecimal(center->x_ * unitsPerPoint, digits) - lastX, digits, true);
+		block[len++] = ' '; block[len++] = 'J';
+		len += formatQuantized(block + len, quantizeDecimal(center->y_ * unitsPerPoint, digits) - lastY, digits, true);
+	}
+	if ((motion != rapid) && !haveFeed) {
+		block[len++] = ' '; block[len++] = 'F';
+		len += formatQuantized(block + len, quantizeDecimal(feedrate * unitsPerInch, digits), digits, true);
+		haveFeed = true;
+	}
+	block[len++] = '\n';
+	outf.write(block + 1, len - 1);
+
+	if (xy) { lastX = x; lastY = y; haveXY = true; }
+	if (z) { lastZ = zValue; haveZ = true; }
+}
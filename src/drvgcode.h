@@ -23,6 +23,12 @@
 
 */
 #include "drvbase.h"
+#include "jobstats.h"
+#include <vector>
+#include <string>
+
+// header and footer for -compact, looked up in the pstoedit data directory
+#define GCODE_TEMPLATE_FILE "drvgcode.template"
 
 class drvGCODE : public drvbase {
 
@@ -33,8 +39,29 @@ public:
 
 	class DriverOptions : public ProgramOptions {
 	public:
-		DriverOptions() 
+		OptionT < bool, BoolTrueExtractor > jobstats;
+		OptionT < bool, BoolTrueExtractor > arcs;
+		OptionT < double, DoubleValueExtractor > arctolerance;
+		OptionT < bool, BoolTrueExtractor > compact;
+		OptionT < bool, BoolTrueExtractor > mm;
+		OptionT < int, IntValueExtractor > precision;
+		OptionT < RSString, RSStringValueExtractor > templatefile;
+		DriverOptions() :
+		jobstats(true,"-jobstats",0,0,"print path statistics and estimated job time (rapid moves at 100 inch per minute), also written to <outfile>.jobstats.json",0,false),
+		arcs(true,"-arcs",0,0,"approximate curves and polylines with G02/G03 arcs and fewer G01 lines where they fit within -arctolerance (only with -compact)",0,false),
+		arctolerance(true,"-arctolerance","number",0,"maximum deviation from the path for -arcs in points (default 0.1)",0,0.1),
+		compact(true,"-compact",0,0,"write pre-scaled coordinates instead of #1003/#1004 expressions and omit unchanged G words and axes, header and footer are taken from -template",0,false),
+		mm(true,"-mm",0,0,"use mm instead of inches with -compact",0,false),
+		precision(true,"-precision","number",0,"number of decimals of the coordinates with -compact (default 4)",0,4),
+		templatefile(true,"-template","string",0,"file with header and footer for -compact (default " GCODE_TEMPLATE_FILE " in the pstoedit data directory)",0,(const char *)"")
 		{
+			ADD(jobstats);
+			ADD(arcs);
+			ADD(arctolerance);
+			ADD(compact);
+			ADD(mm);
+			ADD(precision);
+			ADD(templatefile);
 		}
 	}*options;
 
@@ -42,6 +69,42 @@ private:
 
 #include "drvfuncs.h"
 
+	void countLine(const Point & from, const Point & to);
+
+	// output of the blocks, either with #1003/#1004 expressions or (-compact)
+	// with pre-scaled numbers and only the words that changed
+	enum Motion { rapid, linear, clockwise, counterclockwise, noMotion };
+	void writeMoveTo(const Point & p);
+	void writeLine(const Point & p, bool curveSample = false);
+	void writeArc(bool ccw, const Point & end, const Point & center);
+	void writeBlock(Motion motion, const Point * xy, const float * z, const Point * center);
+	void loadTemplate();
+	std::string fillTemplate(const std::string & section) const;
+	void flushPolyline();
+	bool runFits(unsigned int first, unsigned int last, bool arc, Point & center, bool & ccw) const;
+	unsigned int longestRun(unsigned int first, bool arc, Point & center, bool & ccw) const;
+	bool arcFits(unsigned int first, unsigned int last, const Point & center, float radius, bool ccw) const;
+
+	JobStatistics stats;
+
+	// -arcs: the points of the current path are collected (curves sampled finely)
+	// and written as lines and arcs when the path ends
+	std::vector<Point> polyline;
+	unsigned long g01BlocksWithoutArcs;	// what would have been written without -arcs
+	unsigned long g01Blocks;
+	unsigned long arcBlocks;
+
+	// -compact
+	std::string header;		// from the template, placeholders not yet replaced
+	std::string footer;
+	float unitsPerInch;		// 1 or 25.4 (-mm)
+	int digits;				// -precision
+	Motion lastMotion;		// modal state of the controller, noMotion if unknown
+	long long lastX, lastY, lastZ;	// last written values, in units of 10^-digits
+	bool haveXY, haveZ, haveFeed;
+
+	Point toolPosition;		// where the last path ended, start of the next rapid move
+
 };
 #endif
 
@@ -78,9 +78,11 @@ constructBase,
 	prevColor(0),
 	maxPen(0),
 	currentPen(0),
-	penColors(0)
+	penColors(0),
 
 	//  End DA hpgl color addition
+	pathOut(0),
+	penChanges(0)
 {
 	// driver specific initializations
 	// and writing of header to output file
@@ -88,6 +90,7 @@ constructBase,
 	if (strcmp(Pdriverdesc->symbolicname, "pcl") == 0) {
 		options->hpgl2 = true;
 	}
+	pathOut = options->groupbypen ? (ostream *) &pathBuffer : &outf;
 	if (options->rot90) rotation = 90; else 
 		if (options->rot180) rotation = 180; else 
 			if (options->rot270) rotation = 270; else rotation = 0;
@@ -147,6 +150,7 @@ drvHPGL::~drvHPGL()
 	// and writing of trailer to output file
 // should be done either here or in close_page      	outf << "PU;PA0,0;SP;EC;PG1;EC1;OE\n";
 	// fillinstruction = NIL;
+	if (Verbose()) errf << "pen changes: " << penChanges << endl;
 	delete [] penColors;
 	penColors = NIL;
 	options = NIL;
@@ -202,6 +206,7 @@ unsigned int drvHPGL::readPenColors(ostream & errstream, const char *filename, b
 
 void drvHPGL::print_coords()
 {
+	ostream & out = *pathOut;
 	const unsigned int elems = numberOfElementsInPath();
 	if (elems) {
 		for (unsigned int n = 0; n < elems; n++) {
@@ -216,9 +221,9 @@ void drvHPGL::print_coords()
 #if USESPRINTF
 					char str[256];
 					sprintf_s(TARGETWITHLEN(str,256), "PU%i,%i;", (int) x, (int) y);
-					outf << str;
+					out << str;
 #else
-					outf << "PU" << (int) x << "," << (int) y << ";";
+					out << "PU" << NumberText((int) x) << "," << NumberText((int) y) << ";";
 #endif
 				}
 				break;
@@ -232,9 +237,9 @@ void drvHPGL::print_coords()
 #if USESPRINTF
 						char str[256];
 						sprintf_s(TARGETWITHLEN(str,256), "PD%i,%i;", (int) x, (int) y);
-						outf << str;
+						out << str;
 #else
-						outf << "PD" << (int) x << "," << (int) y << ";";
+						out << "PD" << NumberText((int) x) << "," << NumberText((int) y) << ";";
 #endif
 					}
 					if (isPolygon() && (n == elems)) {
@@ -246,9 +251,9 @@ void drvHPGL::print_coords()
 #if USESPRINTF
 						char str[256];
 						sprintf_s(TARGETWITHLEN(str,256), "PD%i,%i;", (int) x, (int) y);
-						outf << str;
+						out << str;
 #else
-						outf << "PD" << (int) x << "," << (int) y << ";";
+						out << "PD" << NumberText((int) x) << "," << NumberText((int) y) << ";";
 #endif
 					}
 				}
@@ -262,9 +267,9 @@ void drvHPGL::print_coords()
 #if USESPRINTF
 					char str[256];
 					sprintf_s(TARGETWITHLEN(str,256), "PD%i,%i;", (int) x, (int) y);
-					outf << str;
+					out << str;
 #else
-					outf << "PD" << (int) x << "," << (int) y << ";";
+					out << "PD" << NumberText((int) x) << "," << NumberText((int) y) << ";";
 #endif
 				}
 				break;
@@ -281,6 +286,75 @@ void drvHPGL::print_coords()
 	}
 }
 
+// HP-GL/2 polyline encoded number in 7 bit mode: the sign goes into the lowest
+// bit, the result is written in groups of 5 bits, least significant first, as
+// characters 63..94 and the last group as 95..126. Returns the end of buf.
+static char * encodePENumber(char * buf, long value)
+{
+	unsigned long n = (value < 0) ? (((unsigned long) -value) << 1) | 1 : ((unsigned long) value) << 1;
+	while (n >= 32) {
+		*buf++ = (char) (63 + (n & 31));
+		n >>= 5;
+	}
+	*buf++ = (char) (95 + n);
+	return buf;
+}
+
+// -pe: the path as one PE command. The first point is absolute (=), all others
+// are relative to the previous one. The relative values are computed from the
+// rounded absolute positions, so the rounding errors do not add up.
+void drvHPGL::print_coords_pe()
+{
+	ostream & out = *pathOut;
+	const unsigned int elems = numberOfElementsInPath();
+	if (!elems) return;
+
+	int fractionBits = options->pefractionbits;
+	if (fractionBits < 0) fractionBits = 0;
+	if (fractionBits > 16) fractionBits = 16;
+	const double fractionScale = (double) (1L << fractionBits);
+
+	char buf[64];	// flags and two numbers of at most 13 characters each
+	char * b = buf;
+	*b++ = 'P'; *b++ = 'E'; *b++ = '7';
+	if (fractionBits) {
+		*b++ = '>';
+		b = encodePENumber(b, fractionBits);
+	}
+	out.write(buf, b - buf);
+
+	long lastX = 0;
+	long lastY = 0;
+	for (unsigned int n = 0; n < elems; n++) {
+		const basedrawingelement & elem = pathElement(n);
+		const Point & p = (elem.getType() == closepath) ? pathElement(0).getPoint(0) : elem.getPoint(0);
+		if (elem.getType() == curveto) {
+			errf << "\t\tFatal: unexpected case curveto in drvHPGL " << endl;
+			abort();
+		}
+		// same rounding as print_coords for fractionBits == 0
+		double x = (p.x_ + x_offset) * HPGLScale * fractionScale;
+		double y = (p.y_ + y_offset) * HPGLScale * fractionScale;
+		rot(x, y, rotation);
+		const long ix = (long) x;
+		const long iy = (long) y;
+		b = buf;
+		if (elem.getType() == moveto) *b++ = '<';	// pen up for this point
+		if (n == 0) {
+			*b++ = '=';
+			b = encodePENumber(b, ix);
+			b = encodePENumber(b, iy);
+		} else {
+			b = encodePENumber(b, ix - lastX);
+			b = encodePENumber(b, iy - lastY);
+		}
+		out.write(buf, b - buf);
+		lastX = ix;
+		lastY = iy;
+	}
+	out << ';';
+}
+
 // note: 23.2.2011 - VS doesn't really mean scale but velocity (which I do not know how it impacts scaling)
 // HPGL graphic units are 1/1016 of an inch
 // PostScript points are 1/72 of an inch - so there is a factor of 14.11111
@@ -314,6 +388,7 @@ void drvHPGL::open_page()
 
 void drvHPGL::close_page()
 {
+	if (options->groupbypen) writePens();
 	outf << "PU;SP;EC;PG1;EC1;OE\n";
 	if (options->hpgl2) { outf << Ec << "%0A" << Ec <<"E" ; }
 }
@@ -344,27 +419,17 @@ void drvHPGL::SelectPen(float R, float G, float B)
 
 			// use the pen colors as defined in the pen color file
 			// so we need to find the best matching color/pen for the current color
-			double bestquality = 1e+100;    // Arbitrary large number
-
-			// Linear search for a match
-			// 0th element is never used - 0 indicates "new" color
-			unsigned int bestIndex = 0;
-			for (unsigned int i = 1; i < maxPen; i++) {
-				const double quality = (R - penColors[i].R) * (R - penColors[i].R) +
-					(G - penColors[i].G) * (G - penColors[i].G) +
-					(B - penColors[i].B) * (B - penColors[i].B);
-				if (quality < bestquality) {
-					bestquality = quality;
-					bestIndex = i;
-				}
-			}
+			const unsigned int bestIndex = nearestPen(R, G, B);
 
 			// errf << "After lookup  r " << " MP " << maxPen << " "<< reducedColor << " RGB " << R << G << B << " prev " << prevColor << " " << bestquality<< endl;
 			// Select new pen if best match is a different pen
 			prevColor = reducedColor; // to avoid the lookup in probable case that next item is drawn with same color
 			if (currentPen != bestIndex) {
 				currentPen=bestIndex;
-				outf << "PU; \nSP" << currentPen << ";\n";
+				if (!options->groupbypen) {
+					outf << "PU; \nSP" << currentPen << ";\n";
+					penChanges++;
+				}
 			}
 		}
 	} else if (options->maxPenColors > 0) {
@@ -403,7 +468,11 @@ void drvHPGL::SelectPen(float R, float G, float B)
 			}
 			// Select new pen
 			prevColor = reducedColor;
-			outf << "PU; \nSP" << npen << ";\n";
+			currentPen = npen;
+			if (!options->groupbypen) {
+				outf << "PU; \nSP" << npen << ";\n";
+				penChanges++;
+			}
 		}
 		//  End DA hpgl color addition
 	} else {
@@ -411,9 +480,186 @@ void drvHPGL::SelectPen(float R, float G, float B)
 	}
 }
 
+// best matching pen of the pen color file, remembered for each color
+unsigned int drvHPGL::nearestPen(float R, float G, float B)
+{
+	const PenColorKey key = { R, G, B };
+	const std::map<PenColorKey, unsigned int>::const_iterator cached = nearestPenCache.find(key);
+	if (cached != nearestPenCache.end()) return cached->second;
+
+	double bestquality = 1e+100;    // Arbitrary large number
+
+	// Linear search for a match
+	// 0th element is never used - 0 indicates "new" color
+	unsigned int bestIndex = 0;
+	for (unsigned int i = 1; i < maxPen; i++) {
+		const double quality = (R - penColors[i].R) * (R - penColors[i].R) +
+			(G - penColors[i].G) * (G - penColors[i].G) +
+			(B - penColors[i].B) * (B - penColors[i].B);
+		if (quality < bestquality) {
+			bestquality = quality;
+			bestIndex = i;
+		}
+	}
+	nearestPenCache[key] = bestIndex;
+	return bestIndex;
+}
+
+// -groupbypen: keep what was written to pathBuffer for the current pen
+void drvHPGL::storeForPen(const Point & start, const Point & end)
+{
+	if (penJobs.size() <= currentPen) penJobs.resize(currentPen + 1);
+	penJobs[currentPen].push_back(PenJob());
+	PenJob & job = penJobs[currentPen].back();
+	job.commands = pathBuffer.str();
+	job.start = start;
+	job.end = end;
+	pathBuffer.str("");
+}
+
+// -mintravel: the start points of the jobs of one pen in a uniform grid of about
+// one job per cell. nearest() looks at the cells in rings around the given point
+// and stops as soon as no cell outside the rings can hold a closer start point,
+// emitted jobs are removed. For evenly spread paths a search visits a few cells,
+// so ordering n jobs takes about linear time instead of n*n distance checks.
+class PenJobGrid {
+public:
+	explicit PenJobGrid(const std::vector<Point> & starts_p) :
+		starts(starts_p), cells(), location(starts_p.size()), columns(1), rows(1),
+		minX(0.0), minY(0.0), cellWidth(1.0), cellHeight(1.0)
+	{
+		double maxX = 0.0, maxY = 0.0;
+		for (size_t i = 0; i < starts.size(); i++) {
+			const double x = starts[i].x_, y = starts[i].y_;
+			if ((i == 0) || (x < minX)) minX = x;
+			if ((i == 0) || (y < minY)) minY = y;
+			if ((i == 0) || (x > maxX)) maxX = x;
+			if ((i == 0) || (y > maxY)) maxY = y;
+		}
+		const unsigned int side = (unsigned int) ceil(sqrt((double) starts.size()));
+		columns = rows = side ? side : 1;
+		// the extent is enlarged a bit, so that the largest coordinate falls into the last cell
+		cellWidth = ((maxX - minX) * 1.0001 + 1e-3) / columns;
+		cellHeight = ((maxY - minY) * 1.0001 + 1e-3) / rows;
+		cells.resize(columns * rows);
+		for (size_t i = 0; i < starts.size(); i++) {
+			std::vector<size_t> & cell = cells[cellIndex(column(starts[i].x_), row(starts[i].y_))];
+			location[i] = cell.size();
+			cell.push_back(i);
+		}
+	}
+
+	// index of the job that starts closest to p (the lowest index of equally close ones)
+	// the job is removed from the grid
+	size_t nearest(const Point & p)
+	{
+		const int pc = (int) column(p.x_), pr = (int) row(p.y_);
+		size_t best = 0;
+		double bestDistance = -1.0;
+		const int maxRing = (int) ((columns > rows) ? columns : rows);
+		for (int ring = 0; ring <= maxRing; ring++) {
+			for (int r = pr - ring; r <= pr + ring; r++) {
+				if ((r < 0) || (r >= (int) rows)) continue;
+				// inner rows of the ring only have the first and the last column
+				const int step = ((r == pr - ring) || (r == pr + ring) || (ring == 0)) ? 1 : 2 * ring;
+				for (int c = pc - ring; c <= pc + ring; c += step) {
+					if ((c < 0) || (c >= (int) columns)) continue;
+					const std::vector<size_t> & cell = cells[cellIndex(c, r)];
+					for (size_t k = 0; k < cell.size(); k++) {
+						const size_t i = cell[k];
+						const double dx = starts[i].x_ - p.x_;
+						const double dy = starts[i].y_ - p.y_;
+						const double distance = dx * dx + dy * dy;
+						if ((bestDistance < 0.0) || (distance < bestDistance) ||
+							((distance == bestDistance) && (i < best))) {
+							bestDistance = distance;
+							best = i;
+						}
+					}
+				}
+			}
+			if (bestDistance >= 0.0) {
+				// distance from p to the nearest cell outside the rings (if any)
+				double bound = -1.0;
+				if (pc - ring > 0) bound = minDistance(bound, p.x_ - (minX + (pc - ring) * cellWidth));
+				if (pc + ring + 1 < (int) columns) bound = minDistance(bound, (minX + (pc + ring + 1) * cellWidth) - p.x_);
+				if (pr - ring > 0) bound = minDistance(bound, p.y_ - (minY + (pr - ring) * cellHeight));
+				if (pr + ring + 1 < (int) rows) bound = minDistance(bound, (minY + (pr + ring + 1) * cellHeight) - p.y_);
+				// with some slack for the rounding of the cell index
+				if ((bound < 0.0) || (bestDistance < (bound * bound) * 0.999)) break;
+			}
+		}
+		remove(best);
+		return best;
+	}
+
+private:
+	unsigned int column(double x) const { return clamp((x - minX) / cellWidth, columns); }
+	unsigned int row(double y) const { return clamp((y - minY) / cellHeight, rows); }
+	unsigned int cellIndex(int c, int r) const { return (unsigned int) r * columns + (unsigned int) c; }
+	static unsigned int clamp(double v, unsigned int n) {
+		if (v < 0.0) return 0;
+		if (v >= n) return n - 1;
+		return (unsigned int) v;
+	}
+	static double minDistance(double bound, double d) {
+		if (d < 0.0) d = 0.0;
+		return ((bound < 0.0) || (d < bound)) ? d : bound;
+	}
+	void remove(size_t i)
+	{
+		std::vector<size_t> & cell = cells[cellIndex(column(starts[i].x_), row(starts[i].y_))];
+		const size_t last = cell.back();
+		cell[location[i]] = last;
+		location[last] = location[i];
+		cell.pop_back();
+	}
+
+	const std::vector<Point> & starts;
+	std::vector< std::vector<size_t> > cells;
+	std::vector<size_t> location;	// position of a job in its cell
+	unsigned int columns, rows;
+	double minX, minY, cellWidth, cellHeight;
+
+	NOCOPYANDASSIGN(PenJobGrid)
+};
+
+// -groupbypen: write the paths and texts of the page pen by pen. Pen 0 (no
+// pen selected, e.g. no -pencolors) comes first and does not select a pen.
+void drvHPGL::writePens()
+{
+	Point position(0.0f, 0.0f);
+	for (unsigned int pen = 0; pen < penJobs.size(); pen++) {
+		std::vector<PenJob> & jobs = penJobs[pen];
+		if (jobs.empty()) continue;
+		if (pen) {
+			outf << "PU; \nSP" << pen << ";\n";
+			penChanges++;
+		}
+		if (options->mintravel) {
+			// nearest neighbor: continue with the job that starts closest to the last end point
+			std::vector<Point> starts(jobs.size());
+			for (size_t i = 0; i < jobs.size(); i++) starts[i] = jobs[i].start;
+			PenJobGrid grid(starts);
+			for (size_t n = 0; n < jobs.size(); n++) {
+				const size_t best = grid.nearest(position);
+				outf << jobs[best].commands;
+				position = jobs[best].end;
+			}
+		} else {
+			for (size_t i = 0; i < jobs.size(); i++) {
+				outf << jobs[i].commands;
+			}
+			position = jobs.back().end;
+		}
+		jobs.clear();
+	}
+}
+
 void drvHPGL::show_text(const TextInfo & textinfo)
 {
 
+	ostream & out = *pathOut;
 	const double pi = 3.1415926535;
 	const double angleofs = rotation * pi / 180;
 	const double dix = 100.0 * cos(textinfo.currentFontAngle * pi / 180.0 + angleofs);
@@ -434,22 +680,24 @@ drvhpgl.cpp:318: warning: ISO C++ does not support the `%lg' printf format
 #if USESPRINTF
 	char str[256];
 	sprintf_s(TARGETWITHLEN(str,256), "DI%g,%g;", dix, diy);
-	outf << str;
+	out << str;
 	sprintf_s(TARGETWITHLEN(str,256), "SI%g,%g;", textinfo.currentFontSize / 1000 * HPGLScale, textinfo.currentFontSize / 1000 * HPGLScale);
-	outf << str;
+	out << str;
 	sprintf_s(TARGETWITHLEN(str,256), "PU%i,%i;", (int) x, (int) y);
-	outf << str;
+	out << str;
 #else
-	outf << "DI" << dix << "," << diy << ";";
-	outf << "SI" << textinfo.currentFontSize / 1000 * HPGLScale << "," << textinfo.currentFontSize / 1000  * HPGLScale << ";";
-	outf << "PU" << (int) x << "," << (int) y << ";";
+	out << "DI" << dix << "," << diy << ";";
+	out << "SI" << textinfo.currentFontSize / 1000 * HPGLScale << "," << textinfo.currentFontSize / 1000  * HPGLScale << ";";
+	out << "PU" << NumberText((int) x) << "," << NumberText((int) y) << ";";
 #endif
-	outf << "LB" << textinfo.thetext.value() << "\003;" << endl;
+	out << "LB" << textinfo.thetext.value() << "\003;" << endl;
+	if (options->groupbypen) storeForPen(Point(textinfo.x, textinfo.y), Point(textinfo.x, textinfo.y));
 }
 
 
 void drvHPGL::show_path()
 {
+	ostream & out = *pathOut;
 	if (numberOfElementsInPath()) {
 
 		SelectPen(currentR(), currentG(), currentB());
@@ -468,11 +716,11 @@ void drvHPGL::show_path()
 #if USESPRINTF
 				char str[256];
 				sprintf_s(TARGETWITHLEN(str,256), "PU%i,%i;", (int) x, (int) y);
-				outf << str;
+				out << str;
 #else
-				outf << "PU" << (int) x << "," << (int) y << ";";
+				out << "PU" << NumberText((int) x) << "," << NumberText((int) y) << ";";
 #endif
-				outf << options->fillinstruction.value << ";PM0;";
+				out << options->fillinstruction.value << ";PM0;";
 			}
 			break;
 		default:				// cannot happen
@@ -483,13 +731,16 @@ void drvHPGL::show_path()
 #if USESPRINTF
 			char str[256];
 			sprintf_s(TARGETWITHLEN(str,256), "PW%lg;", currentLineWidth());
-			outf << str;
+			out << str;
 #else
-			outf << "PW" << currentLineWidth() << ";";
+			out << "PW" << currentLineWidth() << ";";
 #endif
 		}
 
-		print_coords();
+		if (options->pe)
+			print_coords_pe();
+		else
+			print_coords();
 
 		switch (currentShowType()) {	// To check which endsequenz we need
 		case drvbase::stroke:
@@ -497,13 +748,18 @@ void drvHPGL::show_path()
 		case drvbase::eofill:
 			// Probably Wrong, but treat eoffil like fill
 		case drvbase::fill:
-			outf << "PM2;FP;EP;";	// EP also draws path
+			out << "PM2;FP;EP;";	// EP also draws path
 			break;
 		default:				// cannot happen
-			outf << "unexpected ShowType " << (int) currentShowType();
+			out << "unexpected ShowType " << (int) currentShowType();
 			break;
 		}
-		outf << endl;
+		out << endl;
+		if (options->groupbypen) {
+			const Point & start = pathElement(0).getPoint(0);
+			const basedrawingelement & last = pathElement(numberOfElementsInPath() - 1);
+			storeForPen(start, (last.getType() == closepath) ? start : last.getPoint(0));
+		}
 	}
 }
 
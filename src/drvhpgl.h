@@ -26,6 +26,10 @@
 */
 
 #include "drvbase.h"
+#include <map>
+#include <vector>
+#include <string>
+#include <sstream>
 
    class drvHPGL : public drvbase {
    
@@ -48,6 +52,10 @@ protected:
 		OptionT < bool, BoolTrueExtractor > rot90 ;
 		OptionT < bool, BoolTrueExtractor > rot180 ;
 		OptionT < bool, BoolTrueExtractor > rot270 ;
+		OptionT < bool, BoolTrueExtractor > groupbypen ;
+		OptionT < bool, BoolTrueExtractor > mintravel ;
+		OptionT < bool, BoolTrueExtractor > pe ;
+		OptionT < int,  IntValueExtractor > pefractionbits ;
 
 			// penColors(0), maxPenColors(0)
 		DriverOptions():
@@ -76,7 +84,11 @@ protected:
 			hpgl2 (true,"-hpgl2" ,0, 0, "Use HPGL/2 instead of HPGL/1",0,false),
 			rot90 (true,"-rot90" ,0, 0, "rotate hpgl by 90 degrees",0,false),
 			rot180(true,"-rot180",0, 0, "rotate hpgl by 180 degrees",0,false),
-			rot270(true,"-rot270",0, 0, "rotate hpgl by 270 degrees",0,false)
+			rot270(true,"-rot270",0, 0, "rotate hpgl by 270 degrees",0,false),
+			groupbypen(true,"-groupbypen",0, 0, "collect the paths and texts of a page and plot them pen by pen, i.e. select each pen only once per page",0,false),
+			mintravel(true,"-mintravel",0, 0, "with -groupbypen: plot the paths of a pen in nearest neighbor order to reduce pen up travel (grid search, about linear time for evenly spread paths)",0,false),
+			pe(true,"-pe",0, 0, "write the coordinates of paths with the HP-GL/2 polyline encoded command PE (7 bit mode) instead of PU/PD",0,false),
+			pefractionbits(true,"-pefractionbits", "number", 0, "number of fractional bits of the PE coordinates, i.e. resolution of 1/2^n plotter units (default 0)",0,0)
 		{
 			ADD( penplotter );
 			ADD( pencolorsfromfile );
@@ -86,6 +98,10 @@ protected:
 			ADD( rot90 );
 			ADD( rot180 );
 			ADD( rot270 );
+			ADD( groupbypen );
+			ADD( mintravel );
+			ADD( pe );
+			ADD( pefractionbits );
 		}
 	}*options;
    
@@ -96,8 +112,12 @@ protected:
 
    private:
 	   void print_coords();
+	   void print_coords_pe();
 	   unsigned int readPenColors(ostream & errstream, const char *filename, bool justcount);
 	   void SelectPen(float R, float G, float B);
+	   unsigned int nearestPen(float R, float G, float B);
+	   void storeForPen(const Point & start, const Point & end);
+	   void writePens();
 
 	   //  Start DA hpgl color addition
 	   struct HPGLColor { float R; float G; float B; unsigned int intColor;};
@@ -107,6 +127,29 @@ protected:
 	   HPGLColor * penColors;	
        //  End DA hpgl color addition
 
+	   // -pencolorsfromfile: best pen for each color seen so far
+	   struct PenColorKey {
+		   float R, G, B;
+		   bool operator<(const PenColorKey & other) const {
+			   if (R != other.R) return R < other.R;
+			   if (G != other.G) return G < other.G;
+			   return B < other.B;
+		   }
+	   };
+	   std::map<PenColorKey, unsigned int> nearestPenCache;
+
+	   // -groupbypen: the output of a path or text is collected in pathBuffer
+	   // and then stored with the pen until the page is finished
+	   struct PenJob {
+		   std::string commands;
+		   Point start;
+		   Point end;
+	   };
+	   std::vector< std::vector<PenJob> > penJobs;	// index is the pen
+	   std::ostringstream pathBuffer;
+	   ostream * pathOut;	// outf or pathBuffer
+	   unsigned long penChanges;
+
 	   int rotation;
 
    public:
@@ -67,7 +67,7 @@ private:
 
      //  int           objectId;
        TempFile      tempFile;
-       ofstream      &buffer;
+       ostream       &buffer;
        int           imgcount;
 
 
@@ -54,6 +54,7 @@
 #include <time.h>
 #include <version.h>
 #include "cppcomp.h"
+#include "runstats.h"
 #define PNG_DEBUG 3
 #include <png.h>
 
@@ -65,6 +66,11 @@ drvLAOS::derivedConstructor(drvLAOS): constructBase
 {
     // driver specific initializations
 
+    // the text format is written in text mode, only -binary needs binary mode
+    if (options->binary) {
+        ctorOK &= close_output_file_and_reopen_in_binary_mode();
+    }
+
     cout << "\ndrvlaos: (c) 2010-2012 Peter Brier & Jaap Vermaas (www.laoslaser.org)\n";
     if (Verbose())
     {
@@ -91,9 +97,13 @@ drvLAOS::derivedConstructor(drvLAOS): constructBase
     psfeatures["*Scale"] = "352.777777778";
     psfeatures["*Digits"] = "0";
     psfeatures["*Threshold"] = "0";
+    psfeatures["*RemoveRedundantPoints"] = "True";
+    psfeatures["*LaserMaxSpeed"] = "200"; // mm/s at 100% speed, only for the time estimate
+    psfeatures["*LaserEngravingCrop"] = "True";
     psfeatures["*Prolog"] = "; Generated by pstoedit _version_ from _filename_ at _date_ \n";
     psfeatures["*Trailer"] = "; www.laoslaser.org";
     // now read features from PostScript file
+    haveInputBBox = false;
     ReadFeatures(nameOfInputFile_p);
     // store global configuration values in numeric variables
     scale = atof(psfeatures["*Scale"].c_str());
@@ -103,17 +113,42 @@ drvLAOS::derivedConstructor(drvLAOS): constructBase
     threshold = atoi(psfeatures["*Threshold"].c_str());
     imgFactor = atof(psfeatures["*LaserEngravingPPI"].c_str()) / 72.0;
 
+    removeRedundant = (psfeatures["*RemoveRedundantPoints"].compare("True") == 0);
+
+    // for the statistics: speeds are given in % of *LaserMaxSpeed
+    maxSpeed = atof(psfeatures["*LaserMaxSpeed"].c_str());
+    cuttingSpeed = maxSpeed * featureNumber("*LaserCuttingSpeed") / 100.0;
+    markingSpeed = maxSpeed * featureNumber("*LaserMarkingSpeed") / 100.0;
+    engravingSpeed = maxSpeed * featureNumber("*LaserEngravingSpeed") / 100.0;
+    coordToMM = 25.4 / 72.0 / (scale * pow(10.0, digits));
+    for (unsigned int i = 0; i < 3; i++) {
+        statPos[i].x = statPos[i].y = 0;
+        laserOn[i] = false;
+    }
+
     // init some global runtime variables
     filter = _undefined; // current filter
     doMove = false; // Current position
+    coordOut = 0;
+    havePos = havePending = false;
+    binPos.x = binPos.y = 0;
+    for (unsigned int i = 0; i < 3; i++) {
+        binSection[i].pos.x = binSection[i].pos.y = 0;
+        binSection[i].firstOffset = -1;
+    }
 
     // define temporary filenames
+    // (each section gets its own large buffer, set before opening the file)
+    const ios::openmode sectionMode = options->binary ? (ios::out | ios::binary) : ios::out;
     tc_outname =  full_qualified_tempnam("pscut");
-    tc_out.open(tc_outname.value());
+    tc_out.rdbuf()->pubsetbuf(tc_buf, sizeof(tc_buf));
+    tc_out.open(tc_outname.value(), sectionMode);
     tm_outname = full_qualified_tempnam("psmark");
-    tm_out.open(tm_outname.value());
+    tm_out.rdbuf()->pubsetbuf(tm_buf, sizeof(tm_buf));
+    tm_out.open(tm_outname.value(), sectionMode);
     te_outname = full_qualified_tempnam("psengrave");
-    te_out.open(te_outname.value());
+    te_out.rdbuf()->pubsetbuf(te_buf, sizeof(te_buf));
+    te_out.open(te_outname.value(), sectionMode);
 
     pngname = full_qualified_tempnam("pngtmp");
     if (Verbose()) {
@@ -126,6 +161,67 @@ drvLAOS::derivedConstructor(drvLAOS): constructBase
     sprintf(resolution, "-r%sx%s", psfeatures["*LaserEngravingPPI"].c_str(), psfeatures["*LaserEngravingPPI"].c_str());
     globaloptions_p.psArgs.copyvalue_simple(resolution);  /* set resolution */
 
+    // The PNG for engraving covers the page, unless the input tells us
+    // (%%BoundingBox) where its marks are. Then only that box (plus a one
+    // point margin for anti aliasing) is rendered: the device gets the size
+    // of the box and the page is shifted by PageOffset, so that the lower
+    // left corner of the box is the origin of the PNG. PageOffset moves the
+    // default matrix as well, so the vector output is not affected.
+    // engraveLine adds renderOffsetX/Y back to the pixel positions.
+    renderWidth = atof(psfeatures["*PageLength"].c_str());
+    renderHeight = atof(psfeatures["*PageWidth"].c_str());
+    renderOffsetX = 0.0f;
+    renderOffsetY = 0.0f;
+    if (psfeatures["*LaserEngravingCrop"].compare("True") == 0) {
+        if (!haveInputBBox) {
+            if (Verbose())
+                cout << "drvlaos: the input has no %%BoundingBox, the full page is rendered for engraving" << endl;
+        } else {
+            // the box is limited to the page, nothing outside of it was rendered before either
+            float llx = floor(inputBBox.ll.x_) - 1.0f;
+            float lly = floor(inputBBox.ll.y_) - 1.0f;
+            float urx = ceil(inputBBox.ur.x_) + 1.0f;
+            float ury = ceil(inputBBox.ur.y_) + 1.0f;
+            if (llx < 0.0f) llx = 0.0f;
+            if (lly < 0.0f) lly = 0.0f;
+            if (urx > renderWidth) urx = renderWidth;
+            if (ury > renderHeight) ury = renderHeight;
+            if ((urx > llx) && (ury > lly) &&
+                ((llx > 0.0f) || (lly > 0.0f) || (urx < renderWidth) || (ury < renderHeight))) {
+                renderOffsetX = llx;
+                renderOffsetY = lly;
+                renderWidth = urx - llx;
+                renderHeight = ury - lly;
+                char deviceSize[60];
+                sprintf(deviceSize, "-dDEVICEWIDTHPOINTS=%g", renderWidth);
+                globaloptions_p.psArgs.copyvalue_simple(deviceSize);
+                sprintf(deviceSize, "-dDEVICEHEIGHTPOINTS=%g", renderHeight);
+                globaloptions_p.psArgs.copyvalue_simple(deviceSize);
+                globaloptions_p.psArgs.copyvalue_simple("-dFIXEDMEDIA");
+                if ((llx > 0.0f) || (lly > 0.0f)) {
+                    // -c <code> -f runs before the input. The code is passed as
+                    // single tokens without << >> [ ], since the unix command
+                    // line goes through the shell.
+                    // 1 dict dup /PageOffset -llx -lly 2 array astore put setpagedevice
+                    static const char * const pageOffsetPrefix[] = { "-c", "1", "dict", "dup", "/PageOffset" };
+                    static const char * const pageOffsetSuffix[] = { "2", "array", "astore", "put", "setpagedevice", "-f" };
+                    for (unsigned int i = 0; i < sizeof(pageOffsetPrefix) / sizeof(pageOffsetPrefix[0]); i++)
+                        globaloptions_p.psArgs.copyvalue_simple(pageOffsetPrefix[i]);
+                    char offset[30];
+                    sprintf(offset, "%g", -llx);
+                    globaloptions_p.psArgs.copyvalue_simple(offset);
+                    sprintf(offset, "%g", -lly);
+                    globaloptions_p.psArgs.copyvalue_simple(offset);
+                    for (unsigned int i = 0; i < sizeof(pageOffsetSuffix) / sizeof(pageOffsetSuffix[0]); i++)
+                        globaloptions_p.psArgs.copyvalue_simple(pageOffsetSuffix[i]);
+                }
+                if (Verbose())
+                    cout << "drvlaos: engraving render limited to " << renderWidth << " x " << renderHeight
+                         << " pt at " << renderOffsetX << "," << renderOffsetY << endl;
+            }
+        }
+    }
+
 #ifdef __APPLE__ 
     RSString test("/usr/local/share/pstoedit");
 #endif
@@ -145,6 +241,17 @@ drvLAOS::derivedConstructor(drvLAOS): constructBase
     } 
 }
 
+// Write one line of the text format to the real output,
+// either as is or in the binary format (-binary)
+void drvLAOS::writeLine(const string & line)
+{
+    if (line.size() == 0) return;
+    if (options->binary)
+        encodeLine(line);
+    else
+        outf << line << endl;
+}
+
 void drvLAOS::catFile(RSString *name)
 {   
     // paste temp output file to real output
@@ -157,8 +264,40 @@ void drvLAOS::catFile(RSString *name)
         while (myfile.good())
         {
             getline (myfile, line);
-            if (line.size() > 0) 
-                outf << line << endl;
+            writeLine(line);
+        }
+        myfile.close();
+    }
+    remove (name->value());
+}
+
+// copies count bytes (all if count < 0)
+static void copyBytes(istream & in, ostream & out, long count)
+{
+    char buffer[4096];
+    while (in && (count != 0)) {
+        const long chunk = ((count < 0) || (count > (long) sizeof(buffer))) ? (long) sizeof(buffer) : count;
+        in.read(buffer, chunk);
+        out.write(buffer, in.gcount());
+        if (count > 0) count -= (long) in.gcount();
+    }
+}
+
+// Paste a section written in binary mode to the real output and delete the
+// file. Only its first move/line is encoded again, relative to binPos.
+void drvLAOS::catBinaryFile(RSString *name, const BinarySection & section)
+{
+    ifstream myfile (name->value(), ios::in | ios::binary);
+    if (myfile.is_open())
+    {
+        copyBytes(myfile, outf, section.firstOffset);
+        if (section.firstOffset >= 0) {
+            (void) myfile.ignore(section.firstLength);
+            writeVarint(outf, section.firstCommand - '0');
+            writeSignedVarint(outf, section.first.x - binPos.x);
+            writeSignedVarint(outf, section.first.y - binPos.y);
+            binPos = section.pos;
+            copyBytes(myfile, outf, -1);
         }
         myfile.close();
     }
@@ -169,12 +308,136 @@ drvLAOS::~drvLAOS()
 {
     // turn all images into one engraving layer
     engrave_images();
+    flushCoords();
 	// now it's time to merge the temp output files
     // into one "real" output:
-    te_out.close(); catFile(&te_outname);
-    tm_out.close(); catFile(&tm_outname);
-    tc_out.close(); catFile(&tc_outname);
-    outf << psfeatures["*Trailer"];
+    if (options->binary) {
+        // header: magic, format version, *Digits
+        outf << "LGCB" << (char) 1 << (char) digits;
+        // then the prolog lines collected in th_out
+        istringstream header(th_out.str());
+        string line;
+        while (getline(header, line)) writeLine(line);
+    }
+    te_out.close(); tm_out.close(); tc_out.close();
+    if (options->binary) {
+        catBinaryFile(&te_outname, binSection[2]);
+        catBinaryFile(&tm_outname, binSection[1]);
+        catBinaryFile(&tc_outname, binSection[0]);
+    } else {
+        catFile(&te_outname);
+        catFile(&tm_outname);
+        catFile(&tc_outname);
+    }
+    if (options->binary) {
+        istringstream trailer(psfeatures["*Trailer"]);
+        string line;
+        while (getline(trailer, line)) writeLine(line);
+    } else {
+        outf << psfeatures["*Trailer"];
+    }
+    if (options->jobstats || Verbose())
+        stats.report(errf, outFileName.value(), options->jobstats);
+}
+
+// Numeric part of a feature like "v10" or "m70%"
+double drvLAOS::featureNumber(const char * key)
+{
+    const string & value = psfeatures[key];
+    const size_t start = value.find_first_of("0123456789.");
+    if (start == string::npos) return 0.0;
+    return atof(value.c_str() + start);
+}
+
+// Unsigned LEB128 varint, buf must hold 10 bytes. Returns the number of bytes.
+static unsigned int encodeVarint(char * buf, unsigned long long v)
+{
+    unsigned int len = 0;
+    while (v >= 0x80) {
+        buf[len++] = (char) ((v & 0x7f) | 0x80);
+        v >>= 7;
+    }
+    buf[len++] = (char) v;
+    return len;
+}
+
+// Signed value as zigzag encoded varint
+static unsigned int encodeSignedVarint(char * buf, long long v)
+{
+    return encodeVarint(buf, ((unsigned long long) v << 1) ^ (unsigned long long) (v >> 63));
+}
+
+void drvLAOS::writeVarint(ostream & out, unsigned long long v)
+{
+    char buf[10];
+    out.write(buf, encodeVarint(buf, v));
+}
+
+void drvLAOS::writeSignedVarint(ostream & out, long long v)
+{
+    char buf[10];
+    out.write(buf, encodeSignedVarint(buf, v));
+}
+
+// Encode one line of the text format, see readme.laos for the format.
+// Only used for the prolog and trailer lines, which are given as text by the
+// features - the sections are written in the binary format directly.
+// Comments and lines that are not a command are not transferred.
+void drvLAOS::encodeLine(const string & line)
+{
+    if (line[0] == ';') return;
+    istringstream in(line);
+    in.imbue(locale::classic());
+    long long command;
+    if (!(in >> command) || (command < 0)) {
+        errf << "drvlaos: cannot encode '" << line << "' in binary format, skipped" << endl;
+        return;
+    }
+    if ((command == 0) || (command == 1)) {
+        double x, y;
+        if (!(in >> x >> y)) {
+            errf << "drvlaos: cannot encode '" << line << "' in binary format, skipped" << endl;
+            return;
+        }
+        // the text already contains the scaled value, so only apply *Digits
+        const long long qx = quantizeDecimal(x, digits);
+        const long long qy = quantizeDecimal(y, digits);
+        writeVarint(outf, command);
+        writeSignedVarint(outf, qx - binPos.x);
+        writeSignedVarint(outf, qy - binPos.y);
+        binPos.x = qx;
+        binPos.y = qy;
+    } else if (command == 9) {
+        unsigned long bitsPerPixel, columns;
+        in >> bitsPerPixel >> columns;
+        vector<unsigned long> words;
+        unsigned long word;
+        while (in >> word) words.push_back(word);
+        writeVarint(outf, command);
+        writeVarint(outf, bitsPerPixel);
+        writeVarint(outf, columns);
+        writeVarint(outf, words.size());
+        for (size_t i = 0; i < words.size(); i++) {
+            const char le[4] = { (char) (words[i] & 0xff), (char) ((words[i] >> 8) & 0xff),
+                                 (char) ((words[i] >> 16) & 0xff), (char) ((words[i] >> 24) & 0xff) };
+            outf.write(le, 4);
+        }
+    } else {
+        vector<long long> args;
+        double arg;
+        while (in >> arg) args.push_back((arg < 0.0) ? -(long long) (-arg + 0.5) : (long long) (arg + 0.5));
+        writeVarint(outf, command);
+        writeVarint(outf, args.size());
+        for (size_t i = 0; i < args.size(); i++) writeSignedVarint(outf, args[i]);
+    }
+}
+
+// Stream for the prolog and page setup lines. These go directly to the
+// output for the text format, in binary mode they are encoded at the end.
+ostream & drvLAOS::headerOut()
+{
+    if (options->binary) return th_out;
+    return outf;
 }
 
 /**
@@ -197,7 +460,17 @@ void drvLAOS::ReadFeatures(const char * filename)
             if ( line.find("%%%LaosInclude:" ) != string::npos)
             {
                 Substitute(line, "\\n", "\n");
-                outf << line.substr(15); 
+                headerOut() << line.substr(15); 
+            }
+            if ( !haveInputBBox && (line.compare(0, 14, "%%BoundingBox:") == 0) )
+            {
+                // "(atend)" does not scan, then the one from the trailer is used
+                float llx, lly, urx, ury;
+                if (sscanf(line.c_str() + line.find(':') + 1, "%f %f %f %f", &llx, &lly, &urx, &ury) == 4) {
+                    inputBBox.ll = Point(llx, lly);
+                    inputBBox.ur = Point(urx, ury);
+                    haveInputBBox = true;
+                }
             }
             if ( line.find("%%BeginFeature:" ) != string::npos)
             {
@@ -250,9 +523,8 @@ int drvLAOS::Substitute(string &src, string key, string value)
 // Replace key with numeric value (defined scale and digits)
 int drvLAOS::Substitute(string &src, string key, double value, double scale, int digits)
 {
-    stringstream ss;
-    ss << setiosflags(ios::fixed) << setprecision(digits) << scale*value;
-    return Substitute(src, key, ss.str()); 
+    char number[numberBufferSize];
+    return Substitute(src, key, string(number, formatFixed(number, scale*value, digits)));
 }
 
 // Replace key with numeric value, use global scale and offset, and specific scale and 
@@ -267,21 +539,194 @@ int drvLAOS::Substitute(string &src, string key, int value)
     return Substitute(src, key, (double)value, 1.0, 0); 
 }
 
-int drvLAOS::Substitute( string &src, Point p )
+// Stream of the section (cut, mark or engrave) selected by the current filter
+ostream * drvLAOS::sectionStream()
+{
+    switch (filter) {
+        case _cut:              return &tc_out;
+        case _mark:             return &tm_out;
+        case _stroke_engrave:
+        case _fill_engrave:     return &te_out;
+        default:                return 0;
+    }
+}
+
+// Index of the section written to out (0 = cut, 1 = mark, 2 = engrave)
+unsigned int drvLAOS::sectionIndex(const ostream & out) const
+{
+    return (&out == &tc_out) ? 0 : ((&out == &tm_out) ? 1 : 2);
+}
+
+// Write "<command> x y" (0 = move, 1 = line), or its binary record
+void drvLAOS::writeCoord(ostream & out, char command, const QPoint & q)
+{
+    if (options->binary) {
+        BinarySection & section = binSection[sectionIndex(out)];
+        char record[32];
+        unsigned int len = encodeVarint(record, command - '0');
+        len += encodeSignedVarint(record + len, q.x - section.pos.x);
+        len += encodeSignedVarint(record + len, q.y - section.pos.y);
+        if (section.firstOffset < 0) {
+            section.firstOffset = (long) out.tellp();
+            section.firstLength = len;
+            section.firstCommand = command;
+            section.first = q;
+        }
+        out.write(record, len);
+        section.pos = q;
+    } else {
+        char line[64];
+        unsigned int len = 0;
+        line[len++] = command;
+        line[len++] = ' ';
+        len += formatQuantized(line + len, q.x, digits, false);
+        line[len++] = ' ';
+        len += formatQuantized(line + len, q.y, digits, false);
+        line[len++] = '\n';
+        out.write(line, len);
+    }
+    countCoord(out, command, q);
+}
+
+// Write the setting "7 number value"
+void drvLAOS::writeSetting(ostream & out, int number, int value)
+{
+    if (options->binary) {
+        writeVarint(out, 7);
+        writeVarint(out, 2);
+        writeSignedVarint(out, number);
+        writeSignedVarint(out, value);
+    } else {
+        out << "7 " << number << ' ' << value << endl;
+    }
+}
+
+// Write the engraving data in engravingWords as "9 bits columns words..."
+void drvLAOS::writeEngravingRow(int columns)
+{
+    if (options->binary) {
+        writeVarint(te_out, 9);
+        writeVarint(te_out, bits);
+        writeVarint(te_out, columns);
+        writeVarint(te_out, engravingWords.size());
+        for (size_t i = 0; i < engravingWords.size(); i++) {
+            const unsigned long word = engravingWords[i];
+            const char le[4] = { (char) (word & 0xff), (char) ((word >> 8) & 0xff),
+                                 (char) ((word >> 16) & 0xff), (char) ((word >> 24) & 0xff) };
+            te_out.write(le, 4);
+        }
+    } else {
+        te_out << "9 " << bits << ' '<< columns;
+        for (size_t i = 0; i < engravingWords.size(); i++) {
+            te_out << ' ' << engravingWords[i];
+        }
+        te_out << endl;
+    }
+}
+
+// Path statistics, based on the emitted coordinates. The sections are
+// executed one after the other, so each keeps its own position.
+void drvLAOS::countCoord(const ostream & out, char command, const QPoint & q)
+{
+    const unsigned int section = sectionIndex(out);
+    const double dx = (double) (q.x - statPos[section].x), dy = (double) (q.y - statPos[section].y);
+    const double length = sqrt(dx * dx + dy * dy) * coordToMM;
+    statPos[section] = q;
+    if (command == '0') {
+        stats.addTravel(length, maxSpeed);
+        laserOn[section] = false;
+        return;
+    }
+    if (!laserOn[section]) {
+        stats.addPierce(0.0);
+        laserOn[section] = true;
+    }
+    switch (section) {
+        case 0:     stats.addCut(length, cuttingSpeed); break;
+        case 1:     stats.addMark(length, markingSpeed); break;
+        default:    stats.addEngrave(length, engravingSpeed); break;
+    }
+}
+
+// Write the line end point that is still held back by emitCoord
+void drvLAOS::flushCoords()
+{
+    if (havePending) {
+        writeCoord(*coordOut, '1', pending);
+        lastPos = pending;
+        havePending = false;
+    }
+}
+
+// Flush and forget the current position, e.g. before other commands are
+// written to a section. The next coordinate is then always emitted.
+void drvLAOS::breakCoords()
+{
+    flushCoords();
+    havePos = false;
+}
+
+// Emit a move or line for the current section.
+// Coordinates are compared after rounding, i.e. exactly as they end up in the
+// output: moves to the current position, repeated points and the middle
+// point of three collinear points (running in the same direction) are dropped.
+// For this the end point of the last line is held back until the next
+// coordinate shows whether the line can be extended.
+void drvLAOS::emitCoord(char command, const Point & p)
 {
-    Substitute(src, "_x_", p.x_);
-    Substitute(src, "_y_", p.y_);
-    return 0;
+    ostream * out = sectionStream();
+    if (!out) return;
+    if (out != coordOut) {
+        breakCoords();
+        coordOut = out;
+    }
+    QPoint q;
+    q.x = quantizeDecimal((double) scale * p.x_, digits);
+    q.y = quantizeDecimal((double) scale * p.y_, digits);
+
+    if (!removeRedundant) {
+        writeCoord(*out, command, q);
+        return;
+    }
+    if (command == '0') {
+        const QPoint & cur = havePending ? pending : lastPos;
+        if (havePos && (cur == q)) return; // already there
+        flushCoords();
+        writeCoord(*out, command, q);
+        lastPos = q;
+        havePos = true;
+        return;
+    }
+    if (!havePos) {
+        // line from an unknown position
+        writeCoord(*out, command, q);
+        lastPos = q;
+        havePos = true;
+        return;
+    }
+    if (!havePending) {
+        if (q == lastPos) return;
+        pending = q;
+        havePending = true;
+        return;
+    }
+    if (q == pending) return;
+    const long long dx1 = pending.x - lastPos.x, dy1 = pending.y - lastPos.y;
+    const long long dx2 = q.x - pending.x, dy2 = q.y - pending.y;
+    if ((dx1 * dy2 == dy1 * dx2) && (dx1 * dx2 + dy1 * dy2 > 0)) {
+        // same direction, just extend the pending line
+        pending = q;
+        return;
+    }
+    flushCoords();
+    pending = q;
+    havePending = true;
 }
 
 // Move to position (directly emitted)
 void drvLAOS::DoMoveTo(Point p)
 {
-    string s = "0 _x_ _y_\n";
-    Substitute(s, p);
-    if (filter == 1) tc_out << s;
-    if (filter == 2) tm_out << s;
-    if (filter > 2) te_out << s;
+    emitCoord('0', p);
     curPos.x_ = p.x_;
     curPos.y_ = p.y_;
     doMove = false;
@@ -300,18 +745,10 @@ void drvLAOS::LineTo(Point p)
 {
     if ( doMove )
     {
-        string s = "0 _x_ _y_\n";
-        Substitute(s, curPos);
-        if (filter == 1) tc_out << s;
-        if (filter == 2) tm_out << s;
-        if (filter > 2) te_out << s;
+        emitCoord('0', curPos);
         doMove = false;
     }
-    string str = "1 _x_ _y_\n";
-    Substitute(str, p);
-    if (filter == 1) tc_out << str;
-    if (filter == 2) tm_out << str;
-    if (filter > 2) te_out << str;
+    emitCoord('1', p);
 }
 
 // Called when a new page is started, we output the prolog and the features
@@ -330,29 +767,33 @@ void drvLAOS::open_page()
     Substitute(p, "_version_", version);
     Substitute(p, "_filename_", inFileName.value());
     Substitute(p, "_date_", sdate);
-    outf <<  p; 
+    headerOut() <<  p; 
 
     // add page bounding box in moves
     if (psfeatures["*LaserBoundaryBox"].compare("True") == 0)
     {
         // TODO: what happens with LandScape / Portrait???
         // TODO: is this Inkscape specific or not?
-        outf << "7 201 0" << endl;
+        headerOut() << "7 201 0" << endl;
         string p = "7 202 _x_";
         Substitute(p, "_x_", atof(psfeatures["*PageLength"].c_str()));
-        outf << p << endl;
-        outf << "7 203 0" << endl;
+        headerOut() << p << endl;
+        headerOut() << "7 203 0" << endl;
         p = "7 204 _y_";
         Substitute(p, "_y_", atof(psfeatures["*PageWidth"].c_str()));
-        outf << p << endl;
+        headerOut() << p << endl;
     }
 
+    breakCoords();
     filterPresets(); // write filter presets to temp outfiles
+    stats.beginPage(currentPageNumber);
 }
 
 void drvLAOS::close_page()
 {
     // everything is done in drvLAOS::~drvLAOS();
+    flushCoords(); // so that the statistics of the page are complete
+    stats.endPage();
 }
 
 inline Point pob(float t, const Point & p1, const Point & p2, const Point & p3, const Point & p4)
@@ -377,11 +818,11 @@ void drvLAOS::filterPresets()
     string s_speed = psfeatures["*LaserCuttingSpeed"];
     s_speed = s_speed.substr(1, (s_speed.size() -1));
     int speed = atoi(s_speed.c_str()) * 1000;
-    tc_out << "7 100 " << speed << endl;
+    writeSetting(tc_out, 100, speed);
     string s_power = psfeatures["*LaserCuttingPower"];
     s_power = s_power.substr(0, s_power.size() -1);
     int power = atoi(s_power.c_str()) * 100;
-    tc_out << "7 101 " << power << endl;
+    writeSetting(tc_out, 101, power);
     // string s_freq = psfeatures["*LaserCuttingFrequency"];
     // s_freq = s_freq.substr(1, s_freq.size() -1);
     // int freq = atoi(s_freq.c_str());
@@ -391,11 +832,11 @@ void drvLAOS::filterPresets()
     s_speed = psfeatures["*LaserMarkingSpeed"];
     s_speed = s_speed.substr(2, (s_speed.size() -2));
     speed = atoi(s_speed.c_str()) * 1000;
-    tm_out << "7 100 " << speed << endl;
+    writeSetting(tm_out, 100, speed);
     s_power = psfeatures["*LaserMarkingPower"];
     s_power = s_power.substr(1, s_power.size() -2);
     power = atoi(s_power.c_str()) * 100;
-    tm_out << "7 101 " << power << endl;
+    writeSetting(tm_out, 101, power);
     // s_freq = psfeatures["*LaserMarkingFrequency"];
     // s_freq = s_freq.substr(2, s_freq.size() -2);
     // freq = atoi(s_freq.c_str());
@@ -404,10 +845,10 @@ void drvLAOS::filterPresets()
     //te_out << "; engraving (" << filter << ")" << endl;
     s_speed = psfeatures["*LaserEngravingSpeed"];
     speed = atoi(s_speed.c_str()) * 1000;
-    te_out << "7 100 " << speed << endl;
+    writeSetting(te_out, 100, speed);
     s_power = psfeatures["*LaserEngravingPower"];
     power = atoi(s_power.c_str()) * 100;
-    te_out << "7 101 " << power << endl;
+    writeSetting(te_out, 101, power);
 }
 
 /**
@@ -510,14 +951,15 @@ void drvLAOS::engraveLine(int x_start, int x_end, int y) {
         x_start = x_end;
         x_end = x_tmp;
     }
-    Point p (x_start * imgfactor_x, (height-y) * imgfactor_y);
+    Point p (x_start * imgfactor_x + renderOffsetX, (height-y) * imgfactor_y + renderOffsetY);
+    breakCoords(); // always move to the start of the engraving data
     DoMoveTo(p);
         
     // create engraving data line
     unsigned int val = 0;
     int c = 0;
     int columns = abs(x_start-x_end);
-    te_out << "9 " << bits << ' '<< columns;
+    engravingWords.clear();
     int x;
     // printf("engraveLine from %d to %d step %d\n", x_start, x_end, engravedir);
     if (engravedir == 1)
@@ -525,7 +967,7 @@ void drvLAOS::engraveLine(int x_start, int x_end, int y) {
             val = val + (pixelValue(&(row[x*3])) << c);
             c += bits;
             if (c == 32) {
-                te_out << ' ' << val;
+                engravingWords.push_back(val);
                 val = 0; c = 0;
             }
         }
@@ -534,19 +976,29 @@ void drvLAOS::engraveLine(int x_start, int x_end, int y) {
             val = val + (pixelValue(&(row[x*3])) << c);
             c += bits;
             if (c == 32) {
-                te_out << ' ' << val;
+                engravingWords.push_back(val);
                 val = 0; c = 0;
             }
         }
-    if (c != 0 ) te_out << ' ' << val;
-    te_out << endl;
+    if (c != 0 ) engravingWords.push_back(val);
+    writeEngravingRow(columns);
+    stats.addEngravingRow(((columns + 1) * bits + 31) / 32 * 4);
          
     // line to end of bitmap data
-    p.x_ = x_end * imgfactor_x;
+    p.x_ = x_end * imgfactor_x + renderOffsetX;
     LineTo(p);
     engravedir = -1 * engravedir;
 } 
 
+void drvLAOS::freeRowPointers(size_t rowbytes)
+{
+    for (int y=0; y<height; y++)
+        free(row_pointers[y]);
+    free(row_pointers);
+    row_pointers = 0;
+    MemoryStatistics::release(MemoryStatistics::driver, height * (sizeof(png_bytep) + rowbytes));
+}
+
 void drvLAOS::engrave_images()
 {
     int x, y;
@@ -620,17 +1072,20 @@ void drvLAOS::engrave_images()
                 errf << "[read_png_file] Error during read_image" << endl;
                 return;
             }
+            const size_t rowbytes = png_get_rowbytes(png_ptr,info_ptr);
             row_pointers = (png_bytep*) malloc(sizeof(png_bytep) * height);
             for (y=0; y<height; y++)
-                row_pointers[y] = (png_byte*) malloc(png_get_rowbytes(png_ptr,info_ptr));
+                row_pointers[y] = (png_byte*) malloc(rowbytes);
+            MemoryStatistics::allocate(MemoryStatistics::driver, height * (sizeof(png_bytep) + rowbytes));
 
             png_read_image(png_ptr, row_pointers);
 
             fclose(fp);
 
-            imgfactor_y = atof(psfeatures["*PageWidth"].c_str()) / height;
+            // the PNG covers renderWidth x renderHeight starting at renderOffsetX/Y
+            imgfactor_y = renderHeight / height;
             // Factor for Y-Axis should match X-Axis: does this work for LandScape/Portrait?
-            imgfactor_x = atof(psfeatures["*PageLength"].c_str()) / width;
+            imgfactor_x = renderWidth / width;
             if ((imgfactor_x - imgfactor_y) > 0.001) {
                 errf << "Image Scaling error: X and Y scaling is not the same: X=" << imgfactor_x << ", Y=" << imgfactor_y << endl;
             }
@@ -639,6 +1094,7 @@ void drvLAOS::engrave_images()
             
             if (png_get_color_type(png_ptr, info_ptr) != PNG_COLOR_TYPE_RGB) {
                 cout << "[process_file] input file is not PNG_COLOR_TYPE_RGB, cannot handle this type" << endl;
+                freeRowPointers(rowbytes);
                 return;
             }
 
@@ -668,6 +1124,7 @@ void drvLAOS::engrave_images()
                     */
                 }
             }   
+            freeRowPointers(rowbytes);
             remove (pngname.value());
     }
 }
@@ -28,10 +28,13 @@
 */
 
 #include "drvbase.h"
+#include "jobstats.h"
 using namespace std;
 
 #include <float.h>
 #include <map>
+#include <sstream>
+#include <vector>
 #include <png.h>
 
 //
@@ -59,10 +62,16 @@ public:
 	class DriverOptions : public ProgramOptions {
 	public:
 		OptionT < RSString, RSStringValueExtractor> configfile;
+		OptionT < bool, BoolTrueExtractor > binary;
+		OptionT < bool, BoolTrueExtractor > jobstats;
 		DriverOptions():
-		configfile(true,"-configfile", "string", 0, "specify configuration file (default " LAOS_CONFIG_FILE ")", 0, (const char*)LAOS_CONFIG_FILE)
+		configfile(true,"-configfile", "string", 0, "specify configuration file (default " LAOS_CONFIG_FILE ")", 0, (const char*)LAOS_CONFIG_FILE),
+		binary(true,"-binary", 0, 0, "write the compact binary job format instead of text (see readme.laos)", 0, false),
+		jobstats(true,"-jobstats", 0, 0, "print path statistics and estimated job time, also written to <outfile>.jobstats.json", 0, false)
 		{
 			ADD( configfile );
+			ADD( binary );
+			ADD( jobstats );
 		}
 	}*options;
 
@@ -130,7 +139,10 @@ private:
             }
     };
 */
+    enum { SectionBufferSize = 65536 };
+    char tc_buf[SectionBufferSize], tm_buf[SectionBufferSize], te_buf[SectionBufferSize];
     ofstream tc_out, tm_out, te_out;
+    ostringstream th_out;   // prolog and page setup in binary mode
     RSString tc_outname, tm_outname, te_outname, pngname;
     map<string,string> psfeatures;  
     // list<EngraveImage> engraveImg;
@@ -143,13 +155,54 @@ private:
     int engravedir;
     float imgfactor_x;
     float imgfactor_y;
+    float renderWidth, renderHeight; // area of the page rendered to PNG (pt)
+    float renderOffsetX, renderOffsetY; // lower left corner of that area
+    bool haveInputBBox;
+    BBox inputBBox;         // %%BoundingBox of the input file
 
     // Image *imageptr;
 	int Substitute(string &src, string key, double value, double scale, int digits);
 	int Substitute(string &src, string key, int value);
 	int Substitute(string &src, string key, string value);	  
 	int Substitute(string &src, string key, double value);
-	int Substitute( string &src, Point p );
+    // coordinate as emitted, i.e. scaled and rounded to *Digits
+    struct QPoint {
+        long long x, y;
+        bool operator==(const QPoint & q) const { return (x == q.x) && (y == q.y); }
+    };
+    bool removeRedundant;   // *RemoveRedundantPoints
+    ostream * coordOut;     // section of lastPos/pending
+    bool havePos, havePending;
+    QPoint lastPos;         // last emitted position
+    QPoint pending;         // end of the last line, not yet emitted
+    // With -binary the sections are written in the binary format right away.
+    // The first move/line of a section is relative to 0 0 there, it is encoded
+    // again when the sections are joined (catBinaryFile) and the previous
+    // position is known.
+    struct BinarySection {
+        QPoint pos;             // last position written to the section
+        QPoint first;           // first position of the section
+        char firstCommand;
+        long firstOffset;       // of its record in the temp file, -1 if none yet
+        unsigned int firstLength; // bytes of that record
+    };
+    BinarySection binSection[3]; // per section (cut, mark, engrave)
+    QPoint binPos;          // last position written to the output in binary mode
+    vector<unsigned long> engravingWords; // data of the current engraving row
+
+    JobStatistics stats;
+    double coordToMM;       // emitted coordinate units -> mm
+    double cuttingSpeed, markingSpeed, engravingSpeed, maxSpeed; // mm/s
+    QPoint statPos[3];      // per section (cut, mark, engrave)
+    bool laserOn[3];
+
+	ostream * sectionStream();
+	unsigned int sectionIndex(const ostream & out) const;
+	void writeCoord(ostream & out, char command, const QPoint & q);
+	void countCoord(const ostream & out, char command, const QPoint & q);
+	void emitCoord(char command, const Point & p);
+	void flushCoords();
+	void breakCoords();
 	void LineTo(Point p);
     void engraveLine(int x_start, int x_end, int y);
     // void ImageLineTo(Point p, list<Coordinate> *pcl);
@@ -158,8 +211,18 @@ private:
 	void ReadFeatures(const char * filename);
     void filterPresets();
     void catFile(RSString *name);
+    void catBinaryFile(RSString *name, const BinarySection & section);
+    void writeSetting(ostream & out, int number, int value);
+    void writeEngravingRow(int columns);
+    double featureNumber(const char * key);
+    ostream & headerOut();
+    void writeLine(const string & line);
+    void encodeLine(const string & line);
+    static void writeVarint(ostream & out, unsigned long long v);
+    static void writeSignedVarint(ostream & out, long long v);
     int pixelValue(png_byte* ptr);
     void engrave_images();
+    void freeRowPointers(size_t rowbytes);
 };
 #endif
 
@@ -216,8 +216,7 @@ void drvLATEX2E::close_page()
 	}
 #endif
 // now we can copy the buffer the output
-	ifstream & inbuffer = tempFile.asInput();
-	copy_file(inbuffer, outf);
+	tempFile.copyTo(outf);
 	(void) tempFile.asOutput();
 
 	// Close the picture environment.
@@ -79,7 +79,7 @@ private:
 //  STRQUEUE outputQ;  
   
   	TempFile      tempFile;
-	ofstream      &buffer;  
+	ostream       &buffer;  
 	// Queue for buffering our output until we know our bounding box
 
   // Bounding box for the current picture
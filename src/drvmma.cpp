@@ -99,17 +99,15 @@ static ostream & operator << (ostream & os, Point & pt)
 // Draw a (closed) path
 void drvMMA::draw_path(bool close, Point firstpoint, bool filled)
 {
-	ifstream & inbuffer = tempFile.asInput();
 	if (filled) {
 		RGBColor(fillR(), fillG(), fillB());
 		outf << "Polygon[{";
-		copy_file(inbuffer, outf);
-		(void) inbuffer.seekg(0);
+		tempFile.copyTo(outf);
 		outf << "}],\n";
 	}
 	RGBColor(currentR(), currentG(), currentB());
 	outf << "Line[{";
-	copy_file(inbuffer, outf);
+	tempFile.copyTo(outf);
 	if (close) {
 		outf << ", " << firstpoint;
 	}
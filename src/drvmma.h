@@ -63,7 +63,7 @@ public:
 
 	// temp file for buffering a subpath
   	TempFile tempFile;
-	ofstream &buffer;  
+	ostream  &buffer;  
 };
 
 #endif
@@ -37,6 +37,10 @@
 // for sin and cos
 #include <math.h>
 
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
+
 USESTD 
 
 static float rnd(const float f, const float roundnumber)
@@ -46,11 +50,14 @@ static float rnd(const float f, const float roundnumber)
 
 }
 
-static inline float RND3(const float f)
+// rounded to 3 decimals, as text for the content stream
+static inline NumberText RND3(const float f)
 {
-	return rnd(f, 1000.0f);
+	return NumberText(rnd(f, 1000.0f));
 }
 
+static streampos newlinebytes = 1;	// how many bytes are a newline (1 or 2)
+
 static const char *PDFFonts[] = {	// predefined Fonts (see page 64 PDF Ref. Manual )
 	"Courier",
 	"Courier-Bold",
@@ -79,18 +86,180 @@ const char *const *drvPDF::knownFontNames() const
 unsigned int drvPDF::newobject()
 {
 	currentobject++;
-	if (currentobject >= maxobjects) {
-		errf << "Sorry, too many objects in this file" << endl;
-		exit(1);
+	if (collectObjects) {
+		// the final place is known after writeObjectStreams
+		xref.push_back(XRefEntry());
+		streamedObjectOffsets.push_back((long) objectStreamData.tellp());
+	} else {
+		xref.push_back(XRefEntry(1, (long) outf.tellp()));
+		outf << currentobject << " 0 obj" << endl;
 	}
-	startPosition[currentobject] = outf.tellp();
-	outf << currentobject << " 0 obj" << endl;
 	return currentobject;
 }
 
 void drvPDF::endobject()
 {
-	outf << "endobj" << endl;
+	if (!collectObjects) {
+		outf << "endobj" << endl;
+	}
+}
+
+#ifdef HAVE_LIBZ
+// compresses all of in to out - chunk by chunk, so that a large page is never held in memory
+static void deflateCopy(istream & in, ostream & out, ostream & errf)
+{
+	const unsigned int chunkSize = 64 * 1024;
+	z_stream zs;
+	zs.zalloc = Z_NULL;
+	zs.zfree = Z_NULL;
+	zs.opaque = Z_NULL;
+	if (deflateInit(&zs, Z_DEFAULT_COMPRESSION) != Z_OK) {
+		errf << "Fatal: could not initialize zlib" << endl;
+		exit(1);
+	}
+	std::vector<char> inChunk(chunkSize);
+	std::vector<char> outChunk(chunkSize);
+	int flush = Z_NO_FLUSH;
+	do {
+		in.read(&inChunk[0], chunkSize);
+		zs.avail_in = (uInt) in.gcount();
+		zs.next_in = (Bytef *) &inChunk[0];
+		flush = in ? Z_NO_FLUSH : Z_FINISH;
+		do {
+			zs.avail_out = chunkSize;
+			zs.next_out = (Bytef *) &outChunk[0];
+			(void) deflate(&zs, flush);
+			out.write(&outChunk[0], chunkSize - zs.avail_out);
+		} while (zs.avail_out == 0);
+	} while (flush != Z_FINISH);
+	(void) deflateEnd(&zs);
+}
+#endif
+
+// writes the rest of a stream dictionary and the stream itself.
+// length is the number of bytes in data - if the stream is compressed, the
+// /Length is not known in advance and is filled in afterwards.
+void drvPDF::writeStream(istream & data, streampos length)
+{
+#ifdef HAVE_LIBZ
+	if (compressStreams) {
+		outf << "/Filter /FlateDecode" << endl;
+		outf << "/Length ";
+		const streampos lengthPosition = outf.tellp();
+		outf << "          " << endl;
+		outf << ">>" << endl;
+		outf << "stream" << endl;
+		const streampos streamBegin = outf.tellp();
+		deflateCopy(data, outf, errf);
+		const streampos streamEnd = outf.tellp();
+		outf.seekp(lengthPosition);
+		outf << (long) (streamEnd - streamBegin);
+		outf.seekp(streamEnd);
+		outf << endl;
+		outf << "endstream" << endl;
+		return;
+	}
+#endif
+	outf << "/Length " << length << endl;
+	outf << ">>" << endl;
+	outf << "stream" << endl;
+	copy_file(data, outf);
+	outf << "endstream" << endl;
+}
+
+// PDF 1.5 object streams - the objects collected in objectStreamData are
+// written in groups, each as one stream object
+void drvPDF::writeObjectStreams()
+{
+	const unsigned int objectsPerStream = 100;
+	const std::string data = objectStreamData.str();
+	const unsigned int count = (unsigned int) streamedObjectOffsets.size();
+	for (unsigned int first = 0; first < count; first += objectsPerStream) {
+		const unsigned int last = (count - first > objectsPerStream) ? first + objectsPerStream : count;
+		const long begin = streamedObjectOffsets[first];
+		const long end = (last < count) ? streamedObjectOffsets[last] : (long) data.size();
+		const unsigned int objstm = newobject();
+		std::ostringstream header;
+		for (unsigned int i = first; i < last; i++) {
+			xref[firstStreamedObject + i] = XRefEntry(2, objstm, i - first);
+			header << firstStreamedObject + i << " " << streamedObjectOffsets[i] - begin << " ";
+		}
+		header << endl;
+		const std::string headerString = header.str();
+		outf << "<<" << endl;
+		outf << "/Type /ObjStm" << endl;
+		outf << "/N " << last - first << endl;
+		outf << "/First " << headerString.size() << endl;
+		std::istringstream streamData(headerString + data.substr(begin, end - begin));
+		writeStream(streamData, (streampos) (headerString.size() + (end - begin)));
+		endobject();
+	}
+}
+
+void drvPDF::writeXRefTable(unsigned int catalog, unsigned int info)
+{
+	streampos xrefbegin = outf.tellp();
+	outf << "xref" << endl;
+	outf << "0 " << currentobject + 1 << endl;
+	outf << "0000000000 65535 f";
+	if ((long) newlinebytes == 1L) {
+		outf << " ";
+	}
+	outf << endl;
+
+	for (unsigned int x = 1; x <= currentobject; x++) {
+		outf.width(10);
+		outf.fill('0');
+		outf << xref[x].offset << " 00000 n";
+		if ((long) newlinebytes == 1L) {
+			outf << " ";
+		}
+		outf << endl;
+	}
+	outf << "trailer" << endl;
+	outf << "<<" << endl;
+	outf << "/Size " << currentobject + 1 << endl;
+	outf << "/Info " << info << " 0 R" << endl;
+	outf << "/Root " << catalog << " 0 R" << endl;
+	outf << ">>" << endl;
+	outf << "startxref" << endl;
+	outf << xrefbegin << endl;
+	outf << "%%EOF" << endl;
+}
+
+// the cross-reference stream replaces xref table and trailer (PDF 1.5)
+void drvPDF::writeXRefStream(unsigned int catalog, unsigned int info)
+{
+	const unsigned int xrefobject = newobject();
+	const long xrefbegin = xref[xrefobject].offset;
+	// bytes needed for the second field (offsets and object stream numbers)
+	unsigned int offsetBytes = 1;
+	while ((xrefbegin >> (8 * offsetBytes)) != 0) {
+		offsetBytes++;
+	}
+	std::string entries;
+	for (unsigned int x = 0; x <= currentobject; x++) {
+		const XRefEntry & entry = xref[x];
+		entries += (char) entry.type;
+		for (int b = (int) offsetBytes - 1; b >= 0; b--) {
+			entries += (char) ((entry.offset >> (8 * b)) & 0xff);
+		}
+		const unsigned int field3 = (x == 0) ? 0xffff : entry.index;
+		entries += (char) ((field3 >> 8) & 0xff);
+		entries += (char) (field3 & 0xff);
+	}
+	outf << "<<" << endl;
+	outf << "/Type /XRef" << endl;
+	outf << "/Size " << currentobject + 1 << endl;
+	outf << "/W [1 " << offsetBytes << " 2]" << endl;
+	outf << "/Info " << info << " 0 R" << endl;
+	outf << "/Root " << catalog << " 0 R" << endl;
+	std::istringstream streamData(entries);
+	writeStream(streamData, (streampos) entries.size());
+	endobject();
+	outf << "startxref" << endl;
+	outf << xrefbegin << endl;
+	outf << "%%EOF" << endl;
 }
 
 template <class T >inline T Max(T a, T b)
@@ -127,14 +296,16 @@ void drvPDF::endtext()
 }
 
 
-static streampos newlinebytes = 1;	// how many bytes are a newline (1 or 2)
-
 static const char *const stdEncoding = "Standard";
 
 const int largeint = 32000;
 drvPDF::derivedConstructor(drvPDF):
 constructBase,
+xref(1),
 currentobject(0),
+compressStreams(false),
+collectObjects(false),
+firstStreamedObject(0),
 pagenr(0),
 inTextMode(false),
 encodingName(stdEncoding),
@@ -146,7 +317,14 @@ bb_llx(largeint), bb_lly(largeint), bb_urx(-largeint), bb_ury(-largeint)
 		errf << "Sorry, PDF cannot be written to standard output. Use a file instead\n";
 		exit(1);
 	}
-	const char *const header = "%PDF-1.1";
+	if (options->flate) {
+#ifdef HAVE_LIBZ
+		compressStreams = true;
+#else
+		errf << "Warning: pstoedit was built without zlib - option -flate is ignored" << endl;
+#endif
+	}
+	const char *const header = options->objectstreams ? "%PDF-1.5" : (compressStreams ? "%PDF-1.2" : "%PDF-1.1");
 	outf << header << endl;
 #ifdef HAVESTL
 	//to avoid message "3 overloads have similar conversion"
@@ -175,164 +353,169 @@ drvPDF::~drvPDF()
 
 	endtext();					// close text if open
 
+	// with -objectstreams all of the following objects go to object streams
+	collectObjects = options->objectstreams;
+	firstStreamedObject = currentobject + 1;
+	ostream & out = collectObjects ? (ostream &) objectStreamData : outf;
+
 	unsigned int outlines = newobject();
-	outf << "<<" << endl;
-	outf << "/Type /Outlines" << endl;
-	outf << "/Count 0" << endl;
-	outf << ">>" << endl;
+	out << "<<" << endl;
+	out << "/Type /Outlines" << endl;
+	out << "/Count 0" << endl;
+	out << ">>" << endl;
 	endobject();
 
 	unsigned int encoding = newobject();
 	// write the diffs between pdf-encoding and WinAnsiEncoding
-	outf << "<<" << endl;
-	outf << "/Type /Encoding" << endl;
+	out << "<<" << endl;
+	out << "/Type /Encoding" << endl;
 
 #ifdef basedonwinansi
 // For some reasons this does not work.
 // I haven't seen a working example using the /BaseEncoding feature
-	outf << "/BaseEncoding /WinAnsiEncoding" << endl;
-	outf << "%/Differences [" << endl;
-	outf << "% 24 /breve/caron/circumflex/dotaccent/hungarumlaut/ogonek/ring/tilde" << endl;
-	outf << "%127 /.notdef 129 /dagger/daggerdbl/ellipsis/emdash/endash/florin/fraction" << endl;
-	outf << "%/guilsinglleft/guilsinglright/minus/perthousand/quotedblbase/quotedblleft" << endl;
-	outf << "%/quotedblright/quoteleft/quoteright/quotesinglbase/trademark/fi/fl/Lslash" << endl;
-	outf <<
+	out << "/BaseEncoding /WinAnsiEncoding" << endl;
+	out << "%/Differences [" << endl;
+	out << "% 24 /breve/caron/circumflex/dotaccent/hungarumlaut/ogonek/ring/tilde" << endl;
+	out << "%127 /.notdef 129 /dagger/daggerdbl/ellipsis/emdash/endash/florin/fraction" << endl;
+	out << "%/guilsinglleft/guilsinglright/minus/perthousand/quotedblbase/quotedblleft" << endl;
+	out << "%/quotedblright/quoteleft/quoteright/quotesinglbase/trademark/fi/fl/Lslash" << endl;
+	out <<
 		"%/OE/Scaron/Ydieresis/Zcaron/dotlessi/lslash/scaron/zcaron/.notdef/.notdef/.notdef"
 		<< endl;
-	outf << "%]" << endl;
+	out << "%]" << endl;
 #endif
 
 // The following part (diffs between standard encoding and pdf encoding)
 // was generated by a small PostScript program run through gs
-	outf << "/Differences [" << endl;
-	outf << "24 /breve" << endl;
-	outf << "25 /caron" << endl;
-	outf << "26 /circumflex" << endl;
-	outf << "27 /dotaccent" << endl;
-	outf << "28 /hungarumlaut" << endl;
-	outf << "29 /ogonek" << endl;
-	outf << "30 /ring" << endl;
-	outf << "31 /tilde" << endl;
-	outf << "39 /quotesingle" << endl;
-	outf << "96 /grave" << endl;
-	outf << "128 /bullet" << endl;
-	outf << "129 /dagger" << endl;
-	outf << "130 /daggerdbl" << endl;
-	outf << "131 /ellipsis" << endl;
-	outf << "132 /emdash" << endl;
-	outf << "133 /endash" << endl;
-	outf << "134 /florin" << endl;
-	outf << "135 /fraction" << endl;
-	outf << "136 /guilsinglleft" << endl;
-	outf << "137 /guilsinglright" << endl;
-	outf << "138 /minus" << endl;
-	outf << "139 /perthousand" << endl;
-	outf << "140 /quotedblbase" << endl;
-	outf << "141 /quotedblleft" << endl;
-	outf << "142 /quotedblright" << endl;
-	outf << "143 /quoteleft" << endl;
-	outf << "144 /quoteright" << endl;
-	outf << "145 /quotesinglbase" << endl;
-	outf << "146 /trademark" << endl;
-	outf << "147 /fi" << endl;
-	outf << "148 /fl" << endl;
-	outf << "149 /Lslash" << endl;
-	outf << "150 /OE" << endl;
-	outf << "151 /Scaron" << endl;
-	outf << "152 /Ydieresis" << endl;
-	outf << "153 /Zcaron" << endl;
-	outf << "154 /dotlessi" << endl;
-	outf << "155 /lslash" << endl;
-	outf << "156 /oe" << endl;
-	outf << "157 /scaron" << endl;
-	outf << "158 /zcaron" << endl;
-	outf << "164 /currency" << endl;
-	outf << "166 /brokenbar" << endl;
-	outf << "168 /dieresis" << endl;
-	outf << "169 /copyright" << endl;
-	outf << "170 /ordfeminine" << endl;
-	outf << "172 /logicalnot" << endl;
-	outf << "174 /registered" << endl;
-	outf << "175 /macron" << endl;
-	outf << "176 /degree" << endl;
-	outf << "177 /plusminus" << endl;
-	outf << "178 /twosuperior" << endl;
-	outf << "179 /threesuperior" << endl;
-	outf << "180 /acute" << endl;
-	outf << "181 /mu" << endl;
-	outf << "183 /periodcentered" << endl;
-	outf << "184 /cedilla" << endl;
-	outf << "185 /onesuperior" << endl;
-	outf << "186 /ordmasculine" << endl;
-	outf << "188 /onequarter" << endl;
-	outf << "189 /onehalf" << endl;
-	outf << "190 /threequarters" << endl;
-	outf << "192 /Agrave" << endl;
-	outf << "193 /Aacute" << endl;
-	outf << "194 /Acircumflex" << endl;
-	outf << "195 /Atilde" << endl;
-	outf << "196 /Adieresis" << endl;
-	outf << "197 /Aring" << endl;
-	outf << "198 /AE" << endl;
-	outf << "199 /Ccedilla" << endl;
-	outf << "200 /Egrave" << endl;
-	outf << "201 /Eacute" << endl;
-	outf << "202 /Ecircumflex" << endl;
-	outf << "203 /Edieresis" << endl;
-	outf << "204 /Igrave" << endl;
-	outf << "205 /Iacute" << endl;
-	outf << "206 /Icircumflex" << endl;
-	outf << "207 /Idieresis" << endl;
-	outf << "208 /Eth" << endl;
-	outf << "209 /Ntilde" << endl;
-	outf << "210 /Ograve" << endl;
-	outf << "211 /Oacute" << endl;
-	outf << "212 /Ocircumflex" << endl;
-	outf << "213 /Otilde" << endl;
-	outf << "214 /Odieresis" << endl;
-	outf << "215 /multiply" << endl;
-	outf << "216 /Oslash" << endl;
-	outf << "217 /Ugrave" << endl;
-	outf << "218 /Uacute" << endl;
-	outf << "219 /Ucircumflex" << endl;
-	outf << "220 /Udieresis" << endl;
-	outf << "221 /Yacute" << endl;
-	outf << "222 /Thorn" << endl;
-	outf << "223 /germandbls" << endl;
-	outf << "224 /agrave" << endl;
-	outf << "225 /aacute" << endl;
-	outf << "226 /acircumflex" << endl;
-	outf << "227 /atilde" << endl;
-	outf << "228 /adieresis" << endl;
-	outf << "229 /aring" << endl;
-	outf << "230 /ae" << endl;
-	outf << "231 /ccedilla" << endl;
-	outf << "232 /egrave" << endl;
-	outf << "233 /eacute" << endl;
-	outf << "234 /ecircumflex" << endl;
-	outf << "235 /edieresis" << endl;
-	outf << "236 /igrave" << endl;
-	outf << "237 /iacute" << endl;
-	outf << "238 /icircumflex" << endl;
-	outf << "239 /idieresis" << endl;
-	outf << "240 /eth" << endl;
-	outf << "241 /ntilde" << endl;
-	outf << "242 /ograve" << endl;
-	outf << "243 /oacute" << endl;
-	outf << "244 /ocircumflex" << endl;
-	outf << "245 /otilde" << endl;
-	outf << "246 /odieresis" << endl;
-	outf << "247 /divide" << endl;
-	outf << "248 /oslash" << endl;
-	outf << "249 /ugrave" << endl;
-	outf << "250 /uacute" << endl;
-	outf << "251 /ucircumflex" << endl;
-	outf << "252 /udieresis" << endl;
-	outf << "253 /yacute" << endl;
-	outf << "254 /thorn" << endl;
-	outf << "255 /ydieresis" << endl;
-	outf << "]" << endl;
-	outf << ">>" << endl;
+	out << "/Differences [" << endl;
+	out << "24 /breve" << endl;
+	out << "25 /caron" << endl;
+	out << "26 /circumflex" << endl;
+	out << "27 /dotaccent" << endl;
+	out << "28 /hungarumlaut" << endl;
+	out << "29 /ogonek" << endl;
+	out << "30 /ring" << endl;
+	out << "31 /tilde" << endl;
+	out << "39 /quotesingle" << endl;
+	out << "96 /grave" << endl;
+	out << "128 /bullet" << endl;
+	out << "129 /dagger" << endl;
+	out << "130 /daggerdbl" << endl;
+	out << "131 /ellipsis" << endl;
+	out << "132 /emdash" << endl;
+	out << "133 /endash" << endl;
+	out << "134 /florin" << endl;
+	out << "135 /fraction" << endl;
+	out << "136 /guilsinglleft" << endl;
+	out << "137 /guilsinglright" << endl;
+	out << "138 /minus" << endl;
+	out << "139 /perthousand" << endl;
+	out << "140 /quotedblbase" << endl;
+	out << "141 /quotedblleft" << endl;
+	out << "142 /quotedblright" << endl;
+	out << "143 /quoteleft" << endl;
+	out << "144 /quoteright" << endl;
+	out << "145 /quotesinglbase" << endl;
+	out << "146 /trademark" << endl;
+	out << "147 /fi" << endl;
+	out << "148 /fl" << endl;
+	out << "149 /Lslash" << endl;
+	out << "150 /OE" << endl;
+	out << "151 /Scaron" << endl;
+	out << "152 /Ydieresis" << endl;
+	out << "153 /Zcaron" << endl;
+	out << "154 /dotlessi" << endl;
+	out << "155 /lslash" << endl;
+	out << "156 /oe" << endl;
+	out << "157 /scaron" << endl;
+	out << "158 /zcaron" << endl;
+	out << "164 /currency" << endl;
+	out << "166 /brokenbar" << endl;
+	out << "168 /dieresis" << endl;
+	out << "169 /copyright" << endl;
+	out << "170 /ordfeminine" << endl;
+	out << "172 /logicalnot" << endl;
+	out << "174 /registered" << endl;
+	out << "175 /macron" << endl;
+	out << "176 /degree" << endl;
+	out << "177 /plusminus" << endl;
+	out << "178 /twosuperior" << endl;
+	out << "179 /threesuperior" << endl;
+	out << "180 /acute" << endl;
+	out << "181 /mu" << endl;
+	out << "183 /periodcentered" << endl;
+	out << "184 /cedilla" << endl;
+	out << "185 /onesuperior" << endl;
+	out << "186 /ordmasculine" << endl;
+	out << "188 /onequarter" << endl;
+	out << "189 /onehalf" << endl;
+	out << "190 /threequarters" << endl;
+	out << "192 /Agrave" << endl;
+	out << "193 /Aacute" << endl;
+	out << "194 /Acircumflex" << endl;
+	out << "195 /Atilde" << endl;
+	out << "196 /Adieresis" << endl;
+	out << "197 /Aring" << endl;
+	out << "198 /AE" << endl;
+	out << "199 /Ccedilla" << endl;
+	out << "200 /Egrave" << endl;
+	out << "201 /Eacute" << endl;
+	out << "202 /Ecircumflex" << endl;
+	out << "203 /Edieresis" << endl;
+	out << "204 /Igrave" << endl;
+	out << "205 /Iacute" << endl;
+	out << "206 /Icircumflex" << endl;
+	out << "207 /Idieresis" << endl;
+	out << "208 /Eth" << endl;
+	out << "209 /Ntilde" << endl;
+	out << "210 /Ograve" << endl;
+	out << "211 /Oacute" << endl;
+	out << "212 /Ocircumflex" << endl;
+	out << "213 /Otilde" << endl;
+	out << "214 /Odieresis" << endl;
+	out << "215 /multiply" << endl;
+	out << "216 /Oslash" << endl;
+	out << "217 /Ugrave" << endl;
+	out << "218 /Uacute" << endl;
+	out << "219 /Ucircumflex" << endl;
+	out << "220 /Udieresis" << endl;
+	out << "221 /Yacute" << endl;
+	out << "222 /Thorn" << endl;
+	out << "223 /germandbls" << endl;
+	out << "224 /agrave" << endl;
+	out << "225 /aacute" << endl;
+	out << "226 /acircumflex" << endl;
+	out << "227 /atilde" << endl;
+	out << "228 /adieresis" << endl;
+	out << "229 /aring" << endl;
+	out << "230 /ae" << endl;
+	out << "231 /ccedilla" << endl;
+	out << "232 /egrave" << endl;
+	out << "233 /eacute" << endl;
+	out << "234 /ecircumflex" << endl;
+	out << "235 /edieresis" << endl;
+	out << "236 /igrave" << endl;
+	out << "237 /iacute" << endl;
+	out << "238 /icircumflex" << endl;
+	out << "239 /idieresis" << endl;
+	out << "240 /eth" << endl;
+	out << "241 /ntilde" << endl;
+	out << "242 /ograve" << endl;
+	out << "243 /oacute" << endl;
+	out << "244 /ocircumflex" << endl;
+	out << "245 /otilde" << endl;
+	out << "246 /odieresis" << endl;
+	out << "247 /divide" << endl;
+	out << "248 /oslash" << endl;
+	out << "249 /ugrave" << endl;
+	out << "250 /uacute" << endl;
+	out << "251 /ucircumflex" << endl;
+	out << "252 /udieresis" << endl;
+	out << "253 /yacute" << endl;
+	out << "254 /thorn" << endl;
+	out << "255 /ydieresis" << endl;
+	out << "]" << endl;
+	out << ">>" << endl;
 	endobject();
 
 
@@ -341,69 +524,69 @@ drvPDF::~drvPDF()
 	for (unsigned int f = 0; f < numberOfFonts; f++) {
 		unsigned int font = newobject();
 		unused(&font);
-		outf << "<<" << endl;
-		outf << "/Type /Font" << endl;
-		outf << "/Subtype /Type1" << endl;
-		outf << "/Name /F" << f << endl;
-		outf << "/BaseFont /" << PDFFonts[f] << endl;
+		out << "<<" << endl;
+		out << "/Type /Font" << endl;
+		out << "/Subtype /Type1" << endl;
+		out << "/Name /F" << f << endl;
+		out << "/BaseFont /" << PDFFonts[f] << endl;
 		if ((f == 8) || (f == 13)) {
 			// the special fonts symbol and ZapfDingbats
 
 			// commented out based on a suggestion from Derek Noonburg
-			// outf << "/Encoding /" << encodingName << "Encoding" << endl;
+			// out << "/Encoding /" << encodingName << "Encoding" << endl;
 		} else {
-			outf << "/Encoding " << encoding << " 0 R" << endl;
+			out << "/Encoding " << encoding << " 0 R" << endl;
 		}
-		outf << ">>" << endl;
+		out << ">>" << endl;
 		endobject();
 	}
 
 	unsigned int catalog = newobject();
 	unsigned int pages = currentobject + 2;	// will be next after resources;
-	outf << "<<" << endl;
-	outf << "/Type /Catalog" << endl;
-	outf << "/Pages " << pages << " 0 R" << endl;
-	outf << "/Outlines " << outlines << " 0 R" << endl;
-	outf << ">>" << endl;
+	out << "<<" << endl;
+	out << "/Type /Catalog" << endl;
+	out << "/Pages " << pages << " 0 R" << endl;
+	out << "/Outlines " << outlines << " 0 R" << endl;
+	out << ">>" << endl;
 	endobject();
 
 	unsigned int nrOfPages = pagenr;
 
 	const unsigned int resources = newobject();
-	outf << "<<" << endl;
-	outf << "/ProcSet [ /PDF /Text ]" << endl;
-	outf << "/Font <<" << endl;
+	out << "<<" << endl;
+	out << "/ProcSet [ /PDF /Text ]" << endl;
+	out << "/Font <<" << endl;
 	for (unsigned int f2 = 0; f2 < numberOfFonts; f2++) {
-		outf << "/F" << f2 << " " << f2 + firstFontObject << " 0 R" << endl;
+		out << "/F" << f2 << " " << f2 + firstFontObject << " 0 R" << endl;
 	}
-	outf << ">>" << endl;		// closing /Font
-	outf << ">>" << endl;		// closing /Resources dictionary
+	out << ">>" << endl;		// closing /Font
+	out << ">>" << endl;		// closing /Resources dictionary
 	endobject();
 
 	pages = newobject();
-	outf << "<<" << endl;
-	outf << "/Type /Pages" << endl;
-	outf << "/Count " << nrOfPages << endl;
-	outf << "/Kids [ ";
+	out << "<<" << endl;
+	out << "/Type /Pages" << endl;
+	out << "/Count " << nrOfPages << endl;
+	out << "/Kids [ ";
 	for (unsigned int i = 1; i <= nrOfPages; i++) {
-		outf << i + pages << " 0 R ";
+		out << i + pages << " 0 R ";
 	}
-	outf << " ] " << endl;
-	outf << "/MediaBox [0 0 " << (int) (currentDeviceWidth +
+	out << " ] " << endl;
+	out << "/MediaBox [0 0 " << (int) (currentDeviceWidth +
 										0.5) << ' ' <<
 		(int) (currentDeviceHeight + 0.5) << "]" << endl;
 #if 0
 	const int width = bb_urx - bb_llx;
 	const int height = bb_ury - bb_lly;
 	// heuristically increase shown area by 20% in each direction
-	outf << "/MediaBox ["
+	out << "/MediaBox ["
 		<< bb_llx - 0.2 * width << ' '
 		<< bb_lly - 0.2 * height << ' '
 		<< bb_urx + 0.2 * width << ' ' << bb_ury + 0.2 * height << " ]" << endl;
 #endif
-	outf << "/Resources ";
-	outf << resources << " 0 R" << endl;
-	outf << ">>" << endl;
+	out << "/Resources ";
+	out << resources << " 0 R" << endl;
+	out << ">>" << endl;
 	endobject();
 
 
@@ -411,57 +594,37 @@ drvPDF::~drvPDF()
 	for (unsigned int j = 1; j <= nrOfPages; j++) {
 		unsigned int pageobject = newobject();
 		unused(&pageobject);
-		outf << "<<" << endl;
-		outf << "/Type /Page" << endl;
-		outf << "/Parent " << pages << " 0 R" << endl;
-		outf << "/Contents " << j << " 0 R" << endl;
-		outf << "/Resources " << resources << " 0 R" << endl;
-		outf << ">>" << endl;
+		out << "<<" << endl;
+		out << "/Type /Page" << endl;
+		out << "/Parent " << pages << " 0 R" << endl;
+		out << "/Contents " << j << " 0 R" << endl;
+		out << "/Resources " << resources << " 0 R" << endl;
+		out << ">>" << endl;
 		endobject();
 	}
 
 	unsigned int infoobject = newobject();
-	outf << "<<" << endl;
+	out << "<<" << endl;
 	time_t t = time(0);
 	struct tm *localt = localtime(&t);
-	outf << "/CreationDate (D:"
+	out << "/CreationDate (D:"
 		<< setw(4) << localt->tm_year + 1900
 		<< setw(2) << setfill('0') << localt->tm_mon + 1
 		<< setw(2) << setfill('0') << localt->tm_mday
 		<< setw(2) << setfill('0') << localt->tm_hour
 		<< setw(2) << setfill('0') << localt->tm_min
 		<< setw(2) << setfill('0') << localt->tm_sec << ")" << endl;
-	outf << "/Producer (pstoedit by wglunz35_AT_pstoedit.net)" << endl;
-	outf << ">>" << endl;
+	out << "/Producer (pstoedit by wglunz35_AT_pstoedit.net)" << endl;
+	out << ">>" << endl;
 	endobject();
 
-	streampos xrefbegin = outf.tellp();
-	outf << "xref" << endl;
-	outf << "0 " << currentobject + 1 << endl;
-	outf << "0000000000 65535 f";
-	if ((long) newlinebytes == 1L) {
-		outf << " ";
+	if (collectObjects) {
+		collectObjects = false;
+		writeObjectStreams();
+		writeXRefStream(catalog, infoobject);
+	} else {
+		writeXRefTable(catalog, infoobject);
 	}
-	outf << endl;
-
-	for (unsigned int x = 1; x <= currentobject; x++) {
-		outf.width(10);
-		outf.fill('0');
-		outf << startPosition[x] << " 00000 n";
-		if ((long) newlinebytes == 1L) {
-			outf << " ";
-		}
-		outf << endl;
-	}
-	outf << "trailer" << endl;
-	outf << "<<" << endl;
-	outf << "/Size " << currentobject + 1 << endl;
-	outf << "/Info " << infoobject << " 0 R" << endl;
-	outf << "/Root " << catalog << " 0 R" << endl;
-	outf << ">>" << endl;
-	outf << "startxref" << endl;
-	outf << xrefbegin << endl;
-	outf << "%%EOF" << endl;
 	options=0;
 	encodingName=0;
 }
@@ -527,16 +690,8 @@ void drvPDF::close_page()
 
 	streampos endpos = buffer.tellp();
 	outf << "<<" << endl;
-	outf << "/Length " << endpos << endl;
-	outf << ">>" << endl;
-	outf << "stream" << endl;
-	ifstream & instream = tempFile.asInput();
-	copy_file(instream, outf);
-//  int ret = 0;
-//  while ( (ret = instream.get()) != EOF ) {
-//      outf << (char) ret ;
-//  }
-	outf << "endstream" << endl;
+	istream & instream = tempFile.asInput();
+	writeStream(instream, endpos);
 
 	endobject();
 }
@@ -713,6 +868,6 @@ static DriverDescriptionT < drvPDF > D_pdf("pdf", "Adobe's Portable Document For
 										   false,	// if backend supports elements with fill and edges
 										   true,	// if backend supports text, else 0
 										   DriverDescription::memoryeps,	// no support for PNG file images
-										   DriverDescription::normalopen, true,	// if format supports multiple pages in one file
+										   DriverDescription::binaryopen, true,	// if format supports multiple pages in one file
 										   false  /*clipping */
 										   );
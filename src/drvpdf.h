@@ -23,8 +23,8 @@
 
 */
 #include "drvbase.h"
-
-const  unsigned int maxobjects = 1000;
+#include <vector>
+#include <sstream>
 
 class drvPDF : public drvbase {
 
@@ -34,24 +34,50 @@ public:
 	~drvPDF(); // Destructor
 	class DriverOptions : public ProgramOptions {
 	public:
-		DriverOptions() 
+		OptionT < bool, BoolTrueExtractor > flate ;
+		OptionT < bool, BoolTrueExtractor > objectstreams ;
+		DriverOptions() :
+			flate(true,"-flate",0,0,"compress the page content streams with zlib (FlateDecode, PDF 1.2)",0,false),
+			objectstreams(true,"-objectstreams",0,0,"write fonts, pages and the other non stream objects into object streams and use a cross-reference stream (PDF 1.5, compressed with -flate)",0,false)
 		{
+			ADD(flate);
+			ADD(objectstreams);
 		}
+		// the /Length of a compressed stream is filled in afterwards (writeStream)
+		bool repositionsOutput() const { return flate; }
 	}*options;
 	virtual const char * const *    knownFontNames() const ;
 private:
 	unsigned int newobject();
 	void endobject();
+	void writeStream(istream & data, streampos length);
+	void writeObjectStreams();
+	void writeXRefTable(unsigned int catalog, unsigned int info);
+	void writeXRefStream(unsigned int catalog, unsigned int info);
 	void starttext();
 	void endtext();
 	void adjustbbox(float x, float y);
-	streampos startPosition[maxobjects];
+	// where to find an object - at a byte offset in the file (type 1) or as the
+	// index-th object of an object stream (type 2, see -objectstreams)
+	struct XRefEntry {
+		XRefEntry(unsigned int type_p = 0, long offset_p = 0, unsigned int index_p = 0) :
+			type(type_p), offset(offset_p), index(index_p) {}
+		unsigned int type;
+		long offset;			// byte offset (type 1) or number of the object stream (type 2)
+		unsigned int index;		// index within the object stream (type 2)
+	};
+	std::vector<XRefEntry> xref;	// indexed by object number
 	unsigned int currentobject;
+	bool	compressStreams;		// -flate and zlib available
+	bool	collectObjects;			// newobject() writes to objectStreamData
+	std::ostringstream objectStreamData;
+	std::vector<long> streamedObjectOffsets;	// start of each collected object in objectStreamData
+	unsigned int firstStreamedObject;
 	unsigned int pagenr;
 	bool 	inTextMode;
 	const char * encodingName;
 	TempFile      tempFile;
-	ofstream     &buffer;
+	ostream      &buffer;
 	int	bb_llx,bb_lly,bb_urx,bb_ury;
 
 #include "drvfuncs.h"
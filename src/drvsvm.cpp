@@ -798,26 +798,6 @@ void drvSVM::show_image(const PSImage& image)
 	unsigned char* const output = new unsigned char[scanlineLen * height];
 	unsigned char* const outputMask = new unsigned char[maskScanlineLen * height];
 
-	// setup inverse transformation matrix
-	const float matrixScale(image.normalizedImageCurrentMatrix[0] *
-							image.normalizedImageCurrentMatrix[3] -
-							image.normalizedImageCurrentMatrix[2] *
-							image.normalizedImageCurrentMatrix[1]);
-	const float inverseMatrix[] = {
-		image.normalizedImageCurrentMatrix[3] / matrixScale,
-		-image.normalizedImageCurrentMatrix[1] / matrixScale,
-		-image.normalizedImageCurrentMatrix[2] / matrixScale,
-		image.normalizedImageCurrentMatrix[0] / matrixScale,
-		(image.normalizedImageCurrentMatrix[2] *
-		 image.normalizedImageCurrentMatrix[5] -
-		 image.normalizedImageCurrentMatrix[4] *
-		 image.normalizedImageCurrentMatrix[3]) / matrixScale,
-		(image.normalizedImageCurrentMatrix[4] *
-		 image.normalizedImageCurrentMatrix[1] -
-		 image.normalizedImageCurrentMatrix[0] *
-		 image.normalizedImageCurrentMatrix[5]) / matrixScale
-	};
-
     if (Verbose()) 
         errf << "Image matrix: " 
              << "0: " << image.normalizedImageCurrentMatrix[0] << " "
@@ -832,89 +812,12 @@ void drvSVM::show_image(const PSImage& image)
     // TODO(P3): avoid transformation _at all_ if scale and transform suffices
     // TODO(P3): avoid mask for the obvious cases
 
-	// now transform image
-	for (long int y=0; y < height; y++) {
-		unsigned char* currOutput = &output[scanlineLen * y];
-		unsigned char* currMaskOutput = &outputMask[maskScanlineLen * y] - 1;
-
-		for (long int x=0; x < width; x++) {
-			// now transform from device coordinate space to image space
-			const Point& currPoint( Point(x + lowerLeft.x_,
-										  y + lowerLeft.y_).transform(inverseMatrix) );
-
-			// round to integers
-			const long int sourceX = (long int) (currPoint.x_ + .5);
-			const long int sourceY = (long int) (currPoint.y_ + .5);
-
-			// is the pixel within source bitmap bounds?
-			if (sourceX >= 0L && (unsigned long) sourceX < image.width &&
-				sourceY >= 0L && (unsigned long) sourceY < image.height) {
-				// okay, fetch source pixel value into 
-				// RGB triplet
-
-				unsigned char r(255), g(255), b(255), c, m, y, k;
-
-				// how many components?
-				switch (image.ncomp) {
-				case 1:
-					r = g = b = image.getComponent(sourceX, sourceY, 0);
-					break;
-
-				case 3:
-					r = image.getComponent(sourceX, sourceY, 0);
-					g = image.getComponent(sourceX, sourceY, 1);
-					b = image.getComponent(sourceX, sourceY, 2);
-					break;
-
-				case 4:
-					c = image.getComponent(sourceX, sourceY, 0);
-					m = image.getComponent(sourceX, sourceY, 1);
-					y = image.getComponent(sourceX, sourceY, 2);
-					k = image.getComponent(sourceX, sourceY, 3);
-
-					// account for key
-					c += k;
-					m += k;
-					y += k;
-
-					// convert color
-					r = 255 - c;
-					g = 255 - m;
-					b = 255 - y;
-					break;
-
-                    default: 
-                        assert (0 && "Unexpected bitmap format");
-                        break;
-				}
-
-				// set color triple
-				*currOutput++ = b;
-				*currOutput++ = g;
-				*currOutput++ = r;
-
-                if( (x & 7L) == 0 )
-                    ++currMaskOutput;
-
-                // set mask to opaque
-                *currMaskOutput &= ~(1L << (7L - (x & 7L)));
-			}
-            else
-            {
-                // pixel outside source bitmap bounds - set to
-                // white/transparent
-				*currOutput++ = 255;
-				*currOutput++ = 255;
-				*currOutput++ = 255;
-
-                if( (x & 7L) == 0 )
-                    ++currMaskOutput;
-
-                // set mask to transparent
-                *currMaskOutput |= 1L << (7L - (x & 7L));
-            }
-		}
-	}
+	// now transform image - pixels outside of the source bitmap stay
+	// white and get transparent in the mask
+	for (long int i=0; i < scanlineLen * height; i++)
+		output[i] = 255;
+	image.resample(output, scanlineLen, width, height, lowerLeft, 1.0f,
+				   outputMask, maskScanlineLen);
 
     // write BitmapEx action
     writePod(outf, 
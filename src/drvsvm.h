@@ -52,6 +52,8 @@ public:
 			ADD(mapToArial);
 			ADD(emulateNarrowFonts);
 		}
+		// the header is written again in the destructor
+		bool repositionsOutput() const { return true; }
 	
 	} * options;
 
@@ -79,8 +79,7 @@ drvTGIF::~drvTGIF()
 	outf << "unit(\"1 pixel/pixel\")." << endl;
 	outf << "generated_by(\"pstoedit\",0,\"" << version << "\")." << endl;
 	// now we can copy the buffer the output
-	ifstream & inbuffer = tempFile.asInput();
-	copy_file(inbuffer, outf);
+	tempFile.copyTo(outf);
 	options=0;
 }
 
@@ -50,7 +50,7 @@ public:
 private:
 	void print_coords();
 	TempFile      tempFile;
-	ofstream     &buffer;
+	ostream      &buffer;
 	int           objectId;
 
 };
@@ -927,8 +927,7 @@ drvTK::~drvTK()
 		buffer << "set Global(CurrentPageId) $Global(LoadPageId)" << endl
 			<< "newCanvas .can c$Global(CurrentPageId)" << endl;
 	}
-	ifstream & inbuffer = tempFile.asInput();
-	copy_file(inbuffer, outf);
+	tempFile.copyTo(outf);
 	options=0;
 	paperinfo=0;
 }
@@ -64,7 +64,7 @@ public:
 private:
 	void print_coords();
 	TempFile		tempFile;
-	ofstream		&buffer;
+	ostream		&buffer;
 	int			objectId;
 	const struct PaperInfo * paperinfo;
 
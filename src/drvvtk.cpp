@@ -45,21 +45,18 @@ drvVTK::~drvVTK()
 {
 	// now we can copy the points the output
 	outf << "POINTS " << pointsCount << " float" << endl;
-	ifstream & inbuffer_p = pointFile.asInput();
-	copy_file(inbuffer_p, outf);
+	pointFile.copyTo(outf);
 
 	outf << "LINES " << lineCount << " " << linepoints + lineCount  << endl;
 	// now we can copy the polylines the output
-	ifstream & inbuffer_l = polyFile.asInput();
-	copy_file(inbuffer_l, outf);
+	polyFile.copyTo(outf);
 	outf << endl; 
 
 	outf << "CELL_DATA " << lineCount << endl;
 	outf << "COLOR_SCALARS colors " << 4 << endl;
 	// to see the correct colors, uncheck the "map scalars" in the Display tab of ParaView
 	// now we can copy the polylines the output
-	ifstream & inbuffer_c = colorFile.asInput();
-	copy_file(inbuffer_c, outf);
+	colorFile.copyTo(outf);
 
 	options=0;
 }
@@ -58,11 +58,11 @@ private:
 	int lineCount;
 	int linepoints; 
 	TempFile      pointFile;
-	ofstream     &pointStream;
+	ostream      &pointStream;
 	TempFile     polyFile;
-	ofstream     &polyStream;
+	ostream      &polyStream;
 	TempFile     colorFile;
-	ofstream     &colorStream;
+	ostream      &colorStream;
 };
 
 #endif
@@ -1279,94 +1279,8 @@ void drvWMF::show_image(const PSImage & image)
 		errf << "ERROR: Cannot allocate memory for image" << endl;
 		return;
 	}
-	// setup inverse transformation matrix (scaled, too!)
-	const float matrixScale(image.normalizedImageCurrentMatrix[0] *
-							image.normalizedImageCurrentMatrix[3] -
-							image.normalizedImageCurrentMatrix[2] *
-							image.normalizedImageCurrentMatrix[1]);
-	const float inverseMatrix[] = {
-		image.normalizedImageCurrentMatrix[3] / matrixScale / getScale(),
-		-image.normalizedImageCurrentMatrix[1] / matrixScale / getScale(),
-		-image.normalizedImageCurrentMatrix[2] / matrixScale / getScale(),
-		image.normalizedImageCurrentMatrix[0] / matrixScale / getScale(),
-		(image.normalizedImageCurrentMatrix[2] *
-		 image.normalizedImageCurrentMatrix[5] -
-		 image.normalizedImageCurrentMatrix[4] *
-		 image.normalizedImageCurrentMatrix[3]) / matrixScale,
-		(image.normalizedImageCurrentMatrix[4] *
-		 image.normalizedImageCurrentMatrix[1] -
-		 image.normalizedImageCurrentMatrix[0] *
-		 image.normalizedImageCurrentMatrix[5]) / matrixScale
-	};
-
 	// now transform image
-	for (long y = 0; y < height; y++) {
-		// buffer current output scanline (saves us some multiplications)
-		unsigned char *const currOutput = &output[scanlineLen * y];
-
-		for (long x = 0; x < width; x++) {
-			// now transform from device coordinate space to image space
-
-			// apply transformation
-			const Point currPoint = Point(x + lowerLeft.x_,
-										  y + lowerLeft.y_).transform(inverseMatrix);
-
-			// round to integers
-			const long sourceX = (long) (currPoint.x_ + .5);
-			const long sourceY = (long) (currPoint.y_ + .5);
-
-			// is the pixel out of bounds? If yes, no further processing necessary
-			if (sourceX >= 0L && (unsigned long) sourceX < image.width &&
-				sourceY >= 0L && (unsigned long) sourceY < image.height) {
-				// okay, fetch source pixel value into 
-				// RGB triplet
-
-				unsigned char r(255), g(255), b(255), C, M, Y, K;
-
-				// how many components?
-				switch (image.ncomp) {
-				case 1:
-					r = g = b = image.getComponent(sourceX, sourceY, 0);
-					break;
-
-				case 3:
-					r = image.getComponent(sourceX, sourceY, 0);
-					g = image.getComponent(sourceX, sourceY, 1);
-					b = image.getComponent(sourceX, sourceY, 2);
-					break;
-
-				case 4:
-					C = image.getComponent(sourceX, sourceY, 0);
-					M = image.getComponent(sourceX, sourceY, 1);
-					Y = image.getComponent(sourceX, sourceY, 2);
-					K = image.getComponent(sourceX, sourceY, 3);
-
-					// account for key
-					C += K;
-					M += K;
-					Y += K;
-
-					// convert color
-					r = 255 - C;
-					g = 255 - M;
-					b = 255 - Y;
-					break;
-
-				default:
-					errf << "\t\tFatal: unexpected case in drvwmf (line "
-						<< __LINE__ << ")" << endl;
-					delete [] output; // to make FlexeLint happier
-					abort();
-					return;
-				}
-
-				// set color triple
-				currOutput[3 * x] = b;
-				currOutput[3 * x + 1] = g;
-				currOutput[3 * x + 2] = r;
-			}
-		}
-	}
+	image.resample(output, scanlineLen, width, height, lowerLeft, getScale());
 
 	// draw Windows DI bitmap
 	BITMAPINFO bmi;
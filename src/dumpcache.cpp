@@ -0,0 +1,408 @@
+/*
+   dumpcache.cpp : This file is part of pstoedit
+   Cache of the interpreter output (option -dumpcache)
+
+   Copyright (C) 1993 - 2012 Wolfgang Glunz, wglunz35_AT_pstoedit.net
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+#include "dumpcache.h"
+#include "drvbase.h"
+
+#include I_fstream
+#include I_stdio
+#include I_stdlib
+#include I_string_h
+#include <iomanip>
+#include <map>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <direct.h>
+#include <process.h>
+#include <sys/utime.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#include <dirent.h>
+#include <utime.h>
+#endif
+
+// the key has 128 bits from two 64 bit hashes of the same data: FNV-1a and
+// a variant with another multiplier
+class KeyHash {
+public:
+	KeyHash() : fnv(14695981039346656037ULL), other(0x6c62272e07bb0142ULL) {}
+	void add(const char * data, size_t length) {
+		for (size_t i = 0; i < length; i++) {
+			const unsigned char c = (unsigned char) data[i];
+			fnv = (fnv ^ c) * 1099511628211ULL;
+			other = (other ^ c) * 0x9e3779b97f4a7c15ULL;
+		}
+	}
+	void add(const char * text) { add(text, strlen(text)); }
+	void add(unsigned long long number) {
+		char buf[30];
+		sprintf_s(TARGETWITHLEN(buf, sizeof(buf)), "%llu\n", number);
+		add(buf);
+	}
+	RSString value() const {
+		char buf[40];
+		sprintf_s(TARGETWITHLEN(buf, sizeof(buf)), "%016llx%016llx", fnv, other);
+		return RSString(buf);
+	}
+	enum { length = 32 };	// of value
+private:
+	unsigned long long fnv;
+	unsigned long long other;
+};
+
+// lines of the file given to the interpreter that name temporary files or
+// the input file (which is represented by its content)
+static const char * const ignoredLines[] = {
+	"/pstoedit.outputfilename (",
+	"/pstoedit.inputfilename  (",
+	"/pstoedit.targetoutputfile (",
+	0
+};
+static const char outputNameLine[] = "/pstoedit.nameOfOutputFilewithoutpercentD (";
+static const char fileImageLine[] = "%fileimage:filename ";
+static const char indexHeader[] = "pstoedit dump cache 1";
+
+static bool copyFile(const char * from, const char * to)
+{
+	FILE * in = fopen(from, "rb");
+	if (!in) return false;
+	FILE * out = fopen(to, "wb");
+	if (!out) {
+		(void) fclose(in);
+		return false;
+	}
+	bool ok = true;
+	char buffer[64 * 1024];
+	size_t n;
+	while (ok && ((n = fread(buffer, 1, sizeof(buffer), in)) > 0)) {
+		ok = (fwrite(buffer, 1, n, out) == n);
+	}
+	ok = ok && !ferror(in);
+	(void) fclose(in);
+	return (fclose(out) == 0) && ok;
+}
+
+static bool moveFile(const char * from, const char * to)
+{
+	(void) remove(to);			// rename does not replace files everywhere
+	return rename(from, to) == 0;
+}
+
+static void listDirectory(const char * dir, std::vector<std::string> & names)
+{
+#if defined(_WIN32)
+	const std::string pattern = std::string(dir) + "\\*";
+	WIN32_FIND_DATA finddata;
+	HANDLE findHandle = FindFirstFile(pattern.c_str(), &finddata);
+	if (findHandle == INVALID_HANDLE_VALUE) return;
+	do {
+		names.push_back(finddata.cFileName);
+	} while (FindNextFile(findHandle, &finddata));
+	(void) FindClose(findHandle);
+#else
+	DIR * dirp = opendir(dir);
+	if (!dirp) return;
+	const struct dirent * direntp;
+	while ((direntp = readdir(dirp)) != NIL) {
+		names.push_back(direntp->d_name);
+	}
+	(void) closedir(dirp);
+#endif
+}
+
+DumpCache::DumpCache(const char * directory_p, unsigned long maxMegabytes, ostream & errstream_p, bool verbose_p) :
+	directory(directory_p ? directory_p : ""),
+	maxBytes((unsigned long long) maxMegabytes * 1024ULL * 1024ULL),
+	errstream(errstream_p),
+	verbose(verbose_p),
+	key(""),
+	hit(false),
+	withPages(false),
+	pageCount(0),
+	pageBoxes(0)
+{
+}
+
+DumpCache::~DumpCache()
+{
+	delete[] pageBoxes;
+	pageBoxes = 0;
+}
+
+RSString DumpCache::entryName(const char * suffix) const
+{
+	RSString name(directory);
+	name += "/";
+	name += key;
+	name += ".";
+	name += suffix;
+	return name;
+}
+
+bool DumpCache::computeKey(const char * inputFileName, const char * psinName, const Argv & commandline,
+						   bool withFileImages)
+{
+	key = "";
+	if (!enabled()) return false;
+	FILE * input = fopen(inputFileName, "rb");
+	if (!input) return false;
+
+	KeyHash hash;
+	hash.add(indexHeader);
+	for (unsigned int i = 0; i < commandline.argc; i++) {
+		if (strstr(commandline.argv[i], psinName)) continue;
+		hash.add(commandline.argv[i]);
+		hash.add("\n");
+		struct stat st;
+		if ((i == 0) && (stat(commandline.argv[i], &st) == 0)) {
+			// a new version of the interpreter under the same name
+			hash.add((unsigned long long) st.st_size);
+			hash.add((unsigned long long) st.st_mtime);
+		}
+	}
+
+	ifstream psin(psinName);
+	std::string line;
+	while (getline(psin, line)) {
+		bool ignore = !withFileImages && (line.compare(0, strlen(outputNameLine), outputNameLine) == 0);
+		for (const char * const * prefix = ignoredLines; *prefix && !ignore; prefix++) {
+			ignore = (line.compare(0, strlen(*prefix), *prefix) == 0);
+		}
+		if (ignore) continue;
+		hash.add(line.c_str(), line.length());
+		hash.add("\n");
+	}
+
+	hash.add("input\n");
+	char buffer[64 * 1024];
+	size_t n;
+	while ((n = fread(buffer, 1, sizeof(buffer), input)) > 0) {
+		hash.add(buffer, n);
+	}
+	const bool readError = ferror(input) != 0;
+	(void) fclose(input);
+	if (readError) return false;
+	key = hash.value();
+	if (verbose) {
+		errstream << "dump cache key is " << key << endl;
+	}
+	return true;
+}
+
+bool DumpCache::fetch(const char * dumpName)
+{
+	hit = false;
+	withPages = false;
+	if (!key.length()) return false;
+	const RSString indexName = entryName("idx");
+	ifstream index(indexName.value());
+	std::string line;
+	if (!index || !getline(index, line) || (line != indexHeader)) {
+		if (verbose) errstream << "no entry in the dump cache" << endl;
+		return false;
+	}
+	unsigned int images = 0;
+	index >> line >> images;
+	(void) getline(index, line);
+	std::vector<std::string> imageNames;
+	for (unsigned int i = 0; (i < images) && getline(index, line); i++) {
+		imageNames.push_back(line);
+	}
+	if (!index || !copyFile(entryName("dump").value(), dumpName)) {
+		errstream << "could not read the entry " << key << " of the dump cache" << endl;
+		return false;
+	}
+	for (unsigned int i = 0; i < imageNames.size(); i++) {
+		char suffix[30];
+		sprintf_s(TARGETWITHLEN(suffix, sizeof(suffix)), "%u.img", i);
+		if (!copyFile(entryName(suffix).value(), imageNames[i].c_str())) {
+			errstream << "could not restore " << imageNames[i].c_str() << " from the dump cache" << endl;
+			return false;
+		}
+	}
+	// the page index is optional
+	if ((index >> line >> pageCount) && (line == "pages") && (pageCount <= maxPages)) {
+		delete[] pageBoxes;
+		pageBoxes = new BBox[pageCount ? pageCount : 1];
+		unsigned int p = 0;
+		for (; p < pageCount; p++) {
+			if (!(index >> pageBoxes[p].ll.x_ >> pageBoxes[p].ll.y_ >> pageBoxes[p].ur.x_ >> pageBoxes[p].ur.y_)) break;
+		}
+		withPages = (p == pageCount);
+	}
+	index.close();
+	(void) utime(indexName.value(), 0);	// for the LRU order
+	hit = true;
+	if (verbose) {
+		errstream << "using the interpreter output from the dump cache" << (withPages ? " incl. page index" : "") << endl;
+	}
+	return true;
+}
+
+bool DumpCache::pageIndex(unsigned int & pages, BBox * bboxes) const
+{
+	if (!hit || !withPages) return false;
+	for (unsigned int p = 0; p < pageCount; p++) bboxes[p] = pageBoxes[p];
+	pages = pageCount;
+	return true;
+}
+
+void DumpCache::store(const char * dumpName, const BBox * bboxes, unsigned int pages)
+{
+	if (!key.length() || hit) return;
+	struct stat st;
+	if (stat(directory.value(), &st) != 0) {
+#if defined(_WIN32)
+		(void) _mkdir(directory.value());
+#else
+		(void) mkdir(directory.value(), 0777);
+#endif
+	}
+	// the image files the backend reads
+	std::vector<std::string> imageNames;
+	{
+		ifstream dump(dumpName);
+		std::string line;
+		while (getline(dump, line)) {
+			if (line.compare(0, strlen(fileImageLine), fileImageLine) == 0) {
+				imageNames.push_back(line.substr(strlen(fileImageLine)));
+			}
+		}
+	}
+	// everything is written under a name of its own and renamed when complete,
+	// so that another pstoedit does not see a partial entry
+	char tempSuffix[30];
+	sprintf_s(TARGETWITHLEN(tempSuffix, sizeof(tempSuffix)), ".%d", (int) getpid());
+	std::vector<RSString> written;	// removed again if the entry cannot be completed
+	const RSString entryDump = entryName("dump");
+	const RSString tempDump = entryDump + tempSuffix;
+	written.push_back(tempDump);
+	written.push_back(entryDump);
+	bool ok = copyFile(dumpName, tempDump.value()) && moveFile(tempDump.value(), entryDump.value());
+	for (unsigned int i = 0; ok && (i < imageNames.size()); i++) {
+		char suffix[30];
+		sprintf_s(TARGETWITHLEN(suffix, sizeof(suffix)), "%u.img", i);
+		const RSString entryImage = entryName(suffix);
+		const RSString tempImage = entryImage + tempSuffix;
+		written.push_back(tempImage);
+		written.push_back(entryImage);
+		ok = copyFile(imageNames[i].c_str(), tempImage.value()) && moveFile(tempImage.value(), entryImage.value());
+	}
+	const RSString indexName = entryName("idx");
+	const RSString tempIndex = indexName + tempSuffix;
+	written.push_back(tempIndex);
+	if (ok) {
+		ofstream index(tempIndex.value());
+		index << indexHeader << endl;
+		index << "images " << imageNames.size() << endl;
+		for (unsigned int i = 0; i < imageNames.size(); i++) {
+			index << imageNames[i].c_str() << endl;
+		}
+		if (bboxes) {
+			index << "pages " << pages << endl << setprecision(9);
+			for (unsigned int p = 0; p < pages; p++) {
+				index << bboxes[p].ll.x_ << " " << bboxes[p].ll.y_ << " " << bboxes[p].ur.x_ << " " << bboxes[p].ur.y_ << endl;
+			}
+		}
+		index.close();
+		ok = !index.fail() && moveFile(tempIndex.value(), indexName.value());
+	}
+	if (!ok) {
+		errstream << "could not add the interpreter output to the dump cache in " << directory << endl;
+		for (size_t f = 0; f < written.size(); f++) {
+			(void) remove(written[f].value());
+		}
+		return;
+	}
+	if (verbose) {
+		errstream << "added the interpreter output to the dump cache" << endl;
+	}
+	evict();
+}
+
+struct CacheEntry {
+	CacheEntry() : bytes(0), lastUse(0), complete(false) {}
+	unsigned long long bytes;
+	time_t lastUse;
+	bool complete;
+	std::vector<std::string> files;
+};
+
+typedef std::map<std::string, CacheEntry> CacheEntries;
+
+static bool usedEarlier(const CacheEntries::value_type * a, const CacheEntries::value_type * b)
+{
+	return a->second.lastUse < b->second.lastUse;
+}
+
+void DumpCache::evict()
+{
+	std::vector<std::string> names;
+	listDirectory(directory.value(), names);
+	CacheEntries entries;
+	unsigned long long total = 0;
+	for (size_t i = 0; i < names.size(); i++) {
+		const std::string & name = names[i];
+		if ((name.length() <= (size_t) KeyHash::length) || (name[KeyHash::length] != '.')) continue;
+		if (name.find_first_not_of("0123456789abcdef") < (size_t) KeyHash::length) continue;
+		const std::string path = std::string(directory.value()) + "/" + name;
+		struct stat st;
+		if (stat(path.c_str(), &st) != 0) continue;
+		CacheEntry & entry = entries[name.substr(0, KeyHash::length)];
+		entry.bytes += (unsigned long long) st.st_size;
+		entry.files.push_back(path);
+		total += (unsigned long long) st.st_size;
+		const bool isIndex = (name.compare(KeyHash::length, std::string::npos, ".idx") == 0);
+		// complete entries are ordered by their index, the others by their newest file
+		if (isIndex) {
+			entry.lastUse = st.st_mtime;
+			entry.complete = true;
+		} else if (!entry.complete && (st.st_mtime > entry.lastUse)) {
+			entry.lastUse = st.st_mtime;
+		}
+	}
+	if (total <= maxBytes) return;
+
+	std::vector<const CacheEntries::value_type *> order;
+	for (CacheEntries::const_iterator it = entries.begin(); it != entries.end(); ++it) {
+		order.push_back(&(*it));
+	}
+	std::sort(order.begin(), order.end(), usedEarlier);
+	for (size_t e = 0; (e < order.size()) && (total > maxBytes); e++) {
+		if (order[e]->first == key.value()) continue;	// the entry just added
+		if (verbose) {
+			errstream << "removing entry " << order[e]->first.c_str() << " from the dump cache" << endl;
+		}
+		for (size_t f = 0; f < order[e]->second.files.size(); f++) {
+			(void) remove(order[e]->second.files[f].c_str());
+		}
+		total -= order[e]->second.bytes;
+	}
+}
@@ -0,0 +1,88 @@
+#ifndef DUMPCACHE_H
+#define DUMPCACHE_H
+/*
+   dumpcache.h : This file is part of pstoedit
+   Cache of the interpreter output (option -dumpcache)
+
+   Copyright (C) 1993 - 2012 Wolfgang Glunz, wglunz35_AT_pstoedit.net
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+#ifndef cppcomp_h
+#include "cppcomp.h"
+#endif
+
+#include I_iostream
+USESTD
+
+#include "miscutil.h"
+
+struct BBox;
+
+// A directory with the outputs of earlier interpreter runs. An entry is found
+// by a hash over the content of the input file, the file passed to the
+// interpreter (the settings and the prolog, without the names of temporary
+// files) and the interpreter command line incl. size and date of the
+// interpreter program. It consists of files named <key>.<suffix>:
+//   dump    the interpreter output
+//   <n>.img the image files the output refers to (%fileimage:filename)
+//   idx     written last, marks the entry as complete. It lists the image
+//           files and, if known, the number of pages and their bounding boxes.
+// The date of the idx file is the time of the last use. When the directory
+// grows beyond its limit, the least recently used entries are removed.
+class DLLEXPORT DumpCache {
+public:
+	DumpCache(const char * directory_p, unsigned long maxMegabytes, ostream & errstream_p, bool verbose_p);
+	~DumpCache();
+
+	bool enabled() const { return directory.length() > 0; }
+
+	// determines the key of this interpreter run; psinName is the file given
+	// to the interpreter, the argument with its name is left out of the key.
+	// The name of the output file matters only if the backend gets images as
+	// files, their names are derived from it.
+	bool computeKey(const char * inputFileName, const char * psinName, const Argv & commandline,
+					bool withFileImages);
+
+	// on a hit the cached output is copied to dumpName and its image files
+	// are restored
+	bool fetch(const char * dumpName);
+	// the page index of the entry found by fetch, false if it has none
+	bool pageIndex(unsigned int & pages, BBox * bboxes) const;
+
+	// adds the output of the interpreter after a miss, bboxes may be 0 if
+	// the bounding boxes were not read from it
+	void store(const char * dumpName, const BBox * bboxes, unsigned int pages);
+
+private:
+	RSString entryName(const char * suffix) const;
+	void evict();
+
+	const RSString directory;
+	const unsigned long long maxBytes;
+	ostream & errstream;
+	const bool verbose;
+	RSString key;		// empty until computeKey succeeded
+	bool hit;
+	bool withPages;
+	unsigned int pageCount;
+	BBox * pageBoxes;	// of a hit
+
+	NOCOPYANDASSIGN(DumpCache)
+};
+
+#endif
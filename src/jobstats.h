@@ -0,0 +1,166 @@
+#ifndef __jobstats_h
+#define __jobstats_h
+/*
+   jobstats.h : This file is part of pstoedit
+   Path statistics and machine time estimate for the cutter/plotter backends
+   (drvlaos, drvgcode)
+
+   Copyright (C) 1993 - 2012 Wolfgang Glunz, wglunz35_AT_pstoedit.net
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+#ifndef cppcomp_h
+#include "cppcomp.h"
+#endif
+
+#include I_iostream
+#include I_fstream
+#include <iomanip>
+#include <vector>
+#include "miscutil.h"
+
+USESTD
+
+// Accumulates what a job will do on the machine, per page and for the
+// whole job. The drivers pass lengths in mm together with the speed in mm/s
+// they are done with, so the totals are a few additions per emitted segment.
+class JobStatistics {
+public:
+	struct Counters {
+		Counters() : pageNumber(0), cutLength(0.0), markLength(0.0), engraveLength(0.0),
+			travelLength(0.0), engravingRows(0), engravingBytes(0), piercePoints(0), time(0.0) {}
+		unsigned int pageNumber;	// 0 for the job totals
+		double cutLength;		// mm
+		double markLength;		// mm
+		double engraveLength;	// mm
+		double travelLength;	// mm, rapid moves
+		unsigned long engravingRows;
+		unsigned long engravingBytes;
+		unsigned long piercePoints;	// number of times the tool is switched on / plunged
+		double time;			// estimated machine time in seconds
+	};
+
+	JobStatistics() : inPage(false) {}
+
+	void beginPage(unsigned int pageNumber) {
+		pages.push_back(Counters());
+		pages.back().pageNumber = pageNumber;
+		inPage = true;
+	}
+	void endPage() { inPage = false; }
+
+	// speed in mm/s, 0 if unknown (then the length is not part of the time estimate)
+	void addCut(double length, double speed)		{ add(&Counters::cutLength, length, speed); }
+	void addMark(double length, double speed)		{ add(&Counters::markLength, length, speed); }
+	void addEngrave(double length, double speed)	{ add(&Counters::engraveLength, length, speed); }
+	void addTravel(double length, double speed)		{ add(&Counters::travelLength, length, speed); }
+	void addPierce(double seconds) {
+		job.piercePoints++; job.time += seconds;
+		if (inPage) { pages.back().piercePoints++; pages.back().time += seconds; }
+	}
+	void addEngravingRow(unsigned long bytes) {
+		job.engravingRows++; job.engravingBytes += bytes;
+		if (inPage) { pages.back().engravingRows++; pages.back().engravingBytes += bytes; }
+	}
+
+	const Counters & total() const { return job; }
+
+	// human readable summary, one line per page and one for the job
+	void print(ostream & out) const {
+		for (size_t i = 0; i < pages.size(); i++) {
+			out << "page " << pages[i].pageNumber << ": ";
+			print(out, pages[i]);
+		}
+		out << "job: ";
+		print(out, job);
+	}
+
+	void writeJSON(ostream & out) const {
+		out << "{" << endl << "  \"pages\": [";
+		for (size_t i = 0; i < pages.size(); i++) {
+			out << (i ? "," : "") << endl << "    ";
+			writeJSON(out, pages[i]);
+		}
+		out << endl << "  ]," << endl << "  \"job\": ";
+		writeJSON(out, job);
+		out << endl << "}" << endl;
+	}
+
+	// print the summary to errstream and, if json is set, also write it
+	// to <outputFileName>.jobstats.json (or errstream if there is no output file)
+	void report(ostream & errstream, const char * outputFileName, bool json) const {
+		print(errstream);
+		if (!json) return;
+		if (outputFileName && *outputFileName) {
+			RSString jsonName(outputFileName);
+			jsonName += ".jobstats.json";
+			ofstream jsonFile(jsonName.value());
+			if (jsonFile.is_open()) {
+				writeJSON(jsonFile);
+			} else {
+				errstream << "could not open " << jsonName.value() << " for writing statistics" << endl;
+			}
+		} else {
+			writeJSON(errstream);
+		}
+	}
+
+private:
+	void add(double Counters::* what, double length, double speed) {
+		const double t = (speed > 0.0) ? length / speed : 0.0;
+		job.*what += length; job.time += t;
+		if (inPage) { pages.back().*what += length; pages.back().time += t; }
+	}
+
+	static void print(ostream & out, const Counters & c) {
+		const ios::fmtflags oldflags = out.flags();
+		const streamsize oldprecision = out.precision();
+		const unsigned long seconds = (unsigned long) (c.time + 0.5);
+		out << setiosflags(ios::fixed) << setprecision(1)
+			<< "cut " << c.cutLength << " mm, mark " << c.markLength
+			<< " mm, engrave " << c.engraveLength << " mm, travel " << c.travelLength << " mm, "
+			<< c.engravingRows << " engraving rows (" << c.engravingBytes << " bytes), "
+			<< c.piercePoints << " pierce points, estimated time "
+			<< seconds / 3600 << ":" << setfill('0') << setw(2) << (seconds / 60) % 60
+			<< ":" << setw(2) << seconds % 60 << setfill(' ') << endl;
+		out.flags(oldflags);
+		out.precision(oldprecision);
+	}
+
+	static void writeJSON(ostream & out, const Counters & c) {
+		const ios::fmtflags oldflags = out.flags();
+		const streamsize oldprecision = out.precision();
+		out << setiosflags(ios::fixed) << setprecision(3) << "{ ";
+		if (c.pageNumber) out << "\"page\": " << c.pageNumber << ", ";
+		out << "\"cut_length_mm\": " << c.cutLength
+			<< ", \"mark_length_mm\": " << c.markLength
+			<< ", \"engrave_length_mm\": " << c.engraveLength
+			<< ", \"travel_length_mm\": " << c.travelLength
+			<< ", \"engraving_rows\": " << c.engravingRows
+			<< ", \"engraving_bytes\": " << c.engravingBytes
+			<< ", \"pierce_points\": " << c.piercePoints
+			<< ", \"estimated_time_s\": " << c.time << " }";
+		out.flags(oldflags);
+		out.precision(oldprecision);
+	}
+
+	Counters job;
+	std::vector<Counters> pages;
+	bool inPage;
+};
+
+#endif
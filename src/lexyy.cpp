@@ -1544,6 +1544,8 @@ USESTD
 
 #include "psfront.h"
 #include "miscutil.h"
+#include "compressedoutput.h"
+#include "runstats.h"
 
 static float  origx, origy;
 static char   *start_of_text;
@@ -1558,7 +1560,11 @@ static void checkforlinefeed(const char * currenttext) {
 	while(currenttext && (*currenttext)) { if (*currenttext == '\n') secondlineno++; currenttext++;}
 }
 
-#define YY_USER_ACTION checkforlinefeed(yytext);
+// for -stats, cheaper to count always than to test whether they are enabled
+static unsigned long scannedTokens = 0;
+static unsigned long scannedBytes = 0;
+
+#define YY_USER_ACTION checkforlinefeed(yytext); scannedTokens++; scannedBytes += yyleng;
 
 static void cleanyytext() {
 	// replaces \r or \n from the end with \0
@@ -1951,7 +1957,8 @@ YY_RULE_SETUP
 						// not needed here since done in main program convertBackSlashes(nameOfOutputFile);
 						if (driverDesc->backendFileOpenType != DriverDescription::noopen ){ 
 							outputFilePtr->close();
-							if (driverDesc->backendFileOpenType == DriverDescription::binaryopen ) { 
+							if ((driverDesc->backendFileOpenType == DriverDescription::binaryopen ) ||
+								CompressedOutput::requested(globaloptions.compressOutput.value.value(), newname)) { 
 // old if (defined(unix) || defined() || defined(_unix) || defined(__unix) || defined(__EMX__) || defined (NetBSD) ) && !defined(DJGPP)
 #if defined(PSTOEDIT_UNIXLIKE)
 // binary is not available on UNIX, only on PC
@@ -2420,15 +2427,14 @@ YY_RULE_SETUP
 //cerr << "handling DC " << DC++ << endl;
 //cerr << "handling " << yytext ;
 //cerr << "strlen " << strlen(yytext) << endl ;
-				unsigned int size = backend->imageInfo.height * ((backend->imageInfo.ncomp * backend->imageInfo.width  * backend->imageInfo.bits + 7 ) / 8);
+				unsigned int size = backend->imageInfo.dataSize();
 				if (backend->imageInfo.data == 0) {
 // cerr << " allocating " << size << " for image data " << endl;
-					backend->imageInfo.data = new unsigned char[size];
+					backend->imageInfo.allocateData();
 					if (backend->imageInfo.data==0) {
 						cerr << "out of memory for image data" << endl;
 						return(1);
 					}
-					backend->imageInfo.nextfreedataitem = 0;
 					// init
 //					for (unsigned int i = 0 ; i < size; i++) {
 //						backend->imageInfo.data[i] = 0;
@@ -2933,6 +2939,7 @@ case 68:
 YY_RULE_SETUP
 { 
 					lineNumber++;
+				 const StatisticsSpan span(RunStatistics::clip_save_restore);
 				 backend->Save();
                        	};
 	YY_BREAK
@@ -2941,6 +2948,7 @@ case 69:
 YY_RULE_SETUP
 { 
 					lineNumber++;
+				 const StatisticsSpan span(RunStatistics::clip_save_restore);
 				 backend->Save();
                        	};
 	YY_BREAK
@@ -2949,6 +2957,7 @@ case 70:
 YY_RULE_SETUP
 { 
 					lineNumber++;
+				 const StatisticsSpan span(RunStatistics::clip_save_restore);
 				 backend->Restore();
                        	};
 	YY_BREAK
@@ -2957,6 +2966,7 @@ case 71:
 YY_RULE_SETUP
 { 
 					lineNumber++;
+				 const StatisticsSpan span(RunStatistics::clip_save_restore);
 				 backend->Restore();
                        	};
 	YY_BREAK
@@ -4000,12 +4010,16 @@ void PSFrontEnd::run(bool mergelines)
 	yy_init_globals();
 	yyin= yyinsave;
 	BEGIN(INITIAL);
+	scannedTokens = 0;
+	scannedBytes = 0;
 	backend->startup(mergelines);
 	if (!yylex()) {
 		// yylex returns 0 on normal EOF
 		// 1 in case of errors
 		backend->finalize();
 	}
+	RunStatistics::count(RunStatistics::tokens, scannedTokens);
+	RunStatistics::count(RunStatistics::dumpBytes, scannedBytes);
 	delete backend;
 	backend = 0;
 }
@@ -4052,6 +4066,7 @@ PSFrontEnd::PSFrontEnd(ostream& outfile_p,
 	  bboxes_ptr(0)
 {
     numbers = new float[maxPoints]; // The number stack
+    MemoryStatistics::allocate(MemoryStatistics::pathArrays, maxPoints * sizeof(float));
     if ((numbers == 0)){
 		errf << "new failed in PSFrontEnd::PSFrontEnd " << endl;
 		exit(1);
@@ -4064,6 +4079,7 @@ PSFrontEnd::~PSFrontEnd() {
 #endif
 	delete [] numbers;
 	numbers = 0;
+	MemoryStatistics::release(MemoryStatistics::pathArrays, maxPoints * sizeof(float));
 	
 	yylexcleanup();
 
@@ -20,8 +20,10 @@
 
 */
 #include "miscutil.h"
+#include "runstats.h"
 
 #include I_stdio
+#include <vector>
 
 // #ifdef _MSC_VER
 // for getcwd ( at least for Visual C++)
@@ -420,58 +422,638 @@ ostream & operator << (ostream & out, const Argv & a)
 }
 
 
-TempFile::TempFile()
+// Storage of a TempFile: a list of chunks in memory, or - above the memory limit -
+// an anonymous file from tmpfile(), which the system removes when it is closed.
+// The put area is the last chunk (or fileBuffer), the get area the current chunk.
+class TempFileBuffer : public streambuf {
+public:
+	TempFileBuffer() : lastChunkFill(0), readChunk(0), completeBytes(0), spillFile(0), fileBuffer(0) {}
+	~TempFileBuffer() { clear(); }
+	void startWriting();
+	void startReading();
+	void copyTo(ostream & outfile);
+	static unsigned long memoryLimit;
+protected:
+	int_type overflow(int_type ch);
+	int_type underflow();
+	pos_type seekoff(off_type off, ios_base::seekdir dir, ios_base::openmode which);
+	pos_type seekpos(pos_type pos, ios_base::openmode which);
+private:
+	enum { chunkSize = 64 * 1024 };
+	void clear();
+	void finishWriting();
+	bool writeToFile(const char * data, size_t length);
+	size_t chunkFill(size_t chunk) const { return (chunk + 1 == chunks.size()) ? lastChunkFill : (size_t) chunkSize; }
+	std::vector<char *> chunks;
+	size_t lastChunkFill;		// valid after finishWriting
+	size_t readChunk;
+	unsigned long completeBytes;	// bytes written before the current put area
+	FILE * spillFile;
+	char * fileBuffer;			// put or get area while spilled
+
+	TempFileBuffer(const TempFileBuffer &); // not defined
+	const TempFileBuffer & operator = (const TempFileBuffer &); // not defined
+};
+
+unsigned long TempFileBuffer::memoryLimit = 32UL * 1024UL * 1024UL;
+
+void TempFileBuffer::clear()
+{
+	for (size_t i = 0; i < chunks.size(); i++) {
+		delete[] chunks[i];
+	}
+	MemoryStatistics::release(MemoryStatistics::tempFiles, chunks.size() * chunkSize);
+	chunks.clear();
+	if (spillFile) {
+		(void) fclose(spillFile);
+		spillFile = 0;
+	}
+	if (fileBuffer) MemoryStatistics::release(MemoryStatistics::tempFiles, chunkSize);
+	delete[] fileBuffer;
+	fileBuffer = 0;
+	lastChunkFill = 0;
+	readChunk = 0;
+	completeBytes = 0;
+	setp(0, 0);
+	setg(0, 0, 0);
+}
+
+bool TempFileBuffer::writeToFile(const char * data, size_t length)
+{
+	if (length && (fwrite(data, 1, length, spillFile) != length)) {
+		cerr << "writing to temporary file failed" << endl;
+		return false;
+	}
+	return true;
+}
+
+void TempFileBuffer::startWriting()
+{
+	clear();
+}
+
+TempFileBuffer::int_type TempFileBuffer::overflow(int_type ch)
+{
+	if (spillFile) {
+		const size_t n = pptr() - pbase();
+		if (!writeToFile(pbase(), n)) {
+			return traits_type::eof();
+		}
+		completeBytes += n;
+	} else {
+		if (pbase()) {
+			completeBytes += chunkSize;		// the current chunk is full
+		}
+		if (completeBytes >= memoryLimit) {
+			// move everything to disk and continue there
+			spillFile = tmpfile();
+			if (!spillFile) {
+				cerr << "could not create a temporary file - keeping the data in memory" << endl;
+				memoryLimit = (unsigned long) -1;
+			} else {
+				for (size_t i = 0; i < chunks.size(); i++) {
+					if (!writeToFile(chunks[i], chunkSize)) {
+						return traits_type::eof();
+					}
+					delete[] chunks[i];
+				}
+				MemoryStatistics::release(MemoryStatistics::tempFiles, chunks.size() * chunkSize);
+				chunks.clear();
+				fileBuffer = new char[chunkSize];
+				MemoryStatistics::allocate(MemoryStatistics::tempFiles, chunkSize);
+			}
+		}
+		if (!spillFile) {
+			chunks.push_back(new char[chunkSize]);
+			MemoryStatistics::allocate(MemoryStatistics::tempFiles, chunkSize);
+		}
+	}
+	char * const area = spillFile ? fileBuffer : chunks.back();
+	setp(area, area + chunkSize);
+	if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+		*pptr() = traits_type::to_char_type(ch);
+		pbump(1);
+	}
+	return traits_type::not_eof(ch);
+}
+
+void TempFileBuffer::finishWriting()
+{
+	if (!pbase()) {
+		return;	// not writing
+	}
+	const size_t n = pptr() - pbase();
+	if (spillFile) {
+		(void) writeToFile(pbase(), n);
+		(void) fflush(spillFile);
+	} else {
+		lastChunkFill = n;
+	}
+	completeBytes += n;
+	setp(0, 0);
+}
+
+void TempFileBuffer::startReading()
+{
+	finishWriting();
+	readChunk = 0;
+	if (spillFile) {
+		rewind(spillFile);
+		setg(fileBuffer, fileBuffer, fileBuffer);
+	} else if (chunks.empty()) {
+		setg(0, 0, 0);
+	} else {
+		setg(chunks[0], chunks[0], chunks[0] + chunkFill(0));
+	}
+}
+
+TempFileBuffer::int_type TempFileBuffer::underflow()
+{
+	if (gptr() < egptr()) {
+		return traits_type::to_int_type(*gptr());
+	}
+	if (spillFile) {
+		const size_t n = fread(fileBuffer, 1, chunkSize, spillFile);
+		setg(fileBuffer, fileBuffer, fileBuffer + n);
+		if (n == 0) {
+			return traits_type::eof();
+		}
+	} else {
+		if (readChunk + 1 >= chunks.size()) {
+			return traits_type::eof();
+		}
+		readChunk++;
+		setg(chunks[readChunk], chunks[readChunk], chunks[readChunk] + chunkFill(readChunk));
+		if (gptr() == egptr()) {
+			return traits_type::eof();
+		}
+	}
+	return traits_type::to_int_type(*gptr());
+}
+
+// only what the drivers need: tellp and rewinding the input with seekg(0).
+// Before the first write there is no put area yet, the position is completeBytes then.
+TempFileBuffer::pos_type TempFileBuffer::seekoff(off_type off, ios_base::seekdir dir, ios_base::openmode which)
+{
+	if ((which & ios_base::out) && (off == 0) && (dir == ios_base::cur)) {
+		return pos_type(off_type(completeBytes + (pptr() - pbase())));
+	}
+	if ((which & ios_base::in) && (off == 0) && (dir == ios_base::beg)) {
+		startReading();
+		return pos_type(off_type(0));
+	}
+	return pos_type(off_type(-1));
+}
+
+TempFileBuffer::pos_type TempFileBuffer::seekpos(pos_type pos, ios_base::openmode which)
+{
+	return seekoff(off_type(pos), ios_base::beg, which);
+}
+
+void TempFileBuffer::copyTo(ostream & outfile)
+{
+	finishWriting();
+	if (spillFile) {
+		rewind(spillFile);
+		size_t n;
+		while ((n = fread(fileBuffer, 1, chunkSize, spillFile)) > 0) {
+			(void) outfile.write(fileBuffer, n);
+		}
+	} else {
+		for (size_t i = 0; i < chunks.size(); i++) {
+			(void) outfile.write(chunks[i], chunkFill(i));
+		}
+	}
+	setg(0, 0, 0);
+}
+
+TempFile::TempFile() :
+	buffer(new TempFileBuffer),
+	outStream(buffer),
+	inStream(buffer)
 {
-	tempFileName = TEMPNAM(0, "pstmp");
-	// cout << "constructed " << tempFileName << endl; 
 }
 
 TempFile::~TempFile()
 {
-	// cout << "detructed " << tempFileName << endl; 
-	close();
-	(void) remove(tempFileName);
-	free(tempFileName);
+	delete buffer;
+	buffer = 0;
 }
 
-ofstream & TempFile::asOutput()
+ostream & TempFile::asOutput()
 {
-	close();
-	outFileStream.open(tempFileName);
-	if (outFileStream.fail())
-		cerr << "openening " << tempFileName << "failed " << endl;
-	return outFileStream; //lint !e1536 //exposing low access member
+	buffer->startWriting();
+	outStream.clear();
+	return outStream; //lint !e1536 //exposing low access member
 }
 
-ifstream & TempFile::asInput()
+istream & TempFile::asInput()
 {
-	close();
-	inFileStream.open(tempFileName);
-	if (outFileStream.fail()) {
-		cerr << "openening " << tempFileName << "failed " << endl;
+	buffer->startReading();
+	inStream.clear();
+	return inStream; //lint !e1536 //exposing low access member
+}
+
+void TempFile::copyTo(ostream & outfile)
+{
+	buffer->copyTo(outfile);
+}
+
+void TempFile::setMemoryLimit(unsigned long bytes)
+{
+	TempFileBuffer::memoryLimit = bytes;
+}
+
+BufferedOutput::BufferedOutput(ostream & stream_p, size_t size_p) :
+	stream(stream_p),
+	target(stream_p.rdbuf()),
+	buffer(new char[size_p]),
+	size(size_p)
+{
+	setp(buffer, buffer + size);
+	(void) stream.rdbuf(this);
+}
+
+BufferedOutput::~BufferedOutput()
+{
+	flush();
+	(void) stream.rdbuf(target);
+	delete[] buffer;
+}
+
+bool BufferedOutput::writeBuffer()
+{
+	const streamsize n = pptr() - pbase();
+	setp(buffer, buffer + size);
+	return (n == 0) || (target && (target->sputn(buffer, n) == n));
+}
+
+void BufferedOutput::flush()
+{
+	if (writeBuffer() && target) {
+		(void) target->pubsync();
 	}
-	return inFileStream; //lint !e1536 //exposing low access member
 }
 
-void TempFile::close()
+BufferedOutput::int_type BufferedOutput::overflow(int_type ch)
 {
-//#ifdef HAVE_IS_OPEN
-//#define IS_OPEN(file) file.is_open()
-//#else
-//#define IS_OPEN(file) file
-//#endif
-// commented, since it also works portably if we call clear()
+	if (!writeBuffer()) {
+		return traits_type::eof();
+	}
+	if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+		*pptr() = traits_type::to_char_type(ch);
+		pbump(1);
+	}
+	return traits_type::not_eof(ch);
+}
+
+streamsize BufferedOutput::xsputn(const char * s, streamsize n)
+{
+	if (n <= epptr() - pptr()) {
+		memcpy(pptr(), s, (size_t) n);
+		pbump((int) n);
+		return n;
+	}
+	// large blocks (e.g. image data) go directly to the target
+	if (!writeBuffer()) {
+		return 0;
+	}
+	if ((size_t) n < size) {
+		memcpy(pptr(), s, (size_t) n);
+		pbump((int) n);
+		return n;
+	}
+	return target ? target->sputn(s, n) : 0;
+}
 
-//  if (IS_OPEN(inFileStream))  {
-	inFileStream.close();
-//      if (inFileStream.fail()) cerr << "closing inFileStream failed " << endl;
-//  }
-	inFileStream.clear();
-//  if (IS_OPEN(outFileStream))  {
-	outFileStream.close();
-//      if (outFileStream.fail()) cerr << "closing outFileStream  failed " << endl;
-//  }
-	outFileStream.clear();
+// tellp is answered without writing the buffer, everything else is passed on to the target
+BufferedOutput::pos_type BufferedOutput::seekoff(off_type off, ios_base::seekdir dir, ios_base::openmode which)
+{
+	if (!target || !(which & ios_base::out)) {
+		return pos_type(off_type(-1));
+	}
+	if ((off == 0) && (dir == ios_base::cur)) {
+		const pos_type targetPos = target->pubseekoff(0, ios_base::cur, ios_base::out);
+		if (targetPos == pos_type(off_type(-1))) {
+			return targetPos;
+		}
+		return targetPos + off_type(pptr() - pbase());
+	}
+	if (!writeBuffer()) {
+		return pos_type(off_type(-1));
+	}
+	return target->pubseekoff(off, dir, ios_base::out);
+}
+
+BufferedOutput::pos_type BufferedOutput::seekpos(pos_type pos, ios_base::openmode which)
+{
+	if (!target || !(which & ios_base::out) || !writeBuffer()) {
+		return pos_type(off_type(-1));
+	}
+	return target->pubseekpos(pos, ios_base::out);
+}
+
+// all exactly representable as double
+static const double powersOf10[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static bool signBitSet(double value)
+{
+	// also for -0.0
+	unsigned long long bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return (bits >> 63) != 0;
+}
+
+static unsigned int writeUnsigned(char * buf, unsigned long long n)
+{
+	char tmp[24];
+	unsigned int len = 0;
+	do {
+		tmp[len++] = (char) ('0' + (n % 10));
+		n /= 10;
+	} while (n);
+	unsigned int pos = 0;
+	while (len > 0) buf[pos++] = tmp[--len];
+	buf[pos] = 0;
+	return pos;
+}
+
+// Used where the fast paths below cannot give the exact printf result (values
+// close to a tie, very large or small values, nan, inf). The decimal point of
+// the current C locale is replaced by '.'.
+static unsigned int formatWithPrintf(char * buf, unsigned int bufsize, const char * format, int precision, double value)
+{
+	char tmp[400];
+	const int n = sprintf_s(TARGETWITHLEN(tmp, sizeof(tmp)), format, precision, value);
+	if ((n < 0) || ((unsigned int) n >= bufsize)) {
+		return 0;
+	}
+	unsigned int len = 0;
+	bool pointDone = false;
+	for (const char * p = tmp; *p; p++) {
+		const char c = *p;
+		if (((c >= '0') && (c <= '9')) || ((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')) || (c == '-') || (c == '+')) {
+			buf[len++] = c;
+		} else if (!pointDone) {
+			buf[len++] = '.';
+			pointDone = true;
+		}
+	}
+	buf[len] = 0;
+	return len;
+}
+
+// Rounds value (> 0, finite) to "precision" significant digits, i.e.
+// value ~ digits * 10^(exponent - precision + 1) with 10^(precision-1) <= digits < 10^precision.
+// Returns false if that cannot be done exactly with double arithmetic - if the value is
+// (nearly) in the middle between two results or out of the range of powersOf10.
+static bool roundToSignificant(double value, int precision, unsigned long long & digits, int & exponent)
+{
+	int e = (int) floor(log10(value));
+	for (int attempt = 0; attempt < 3; attempt++) {
+		const int shift = precision - 1 - e;
+		if ((shift > 22) || (shift < -22)) {
+			return false;
+		}
+		// a single rounding - the relative error is at most 2^-53
+		const double scaled = (shift >= 0) ? value * powersOf10[shift] : value / powersOf10[-shift];
+		if (scaled < powersOf10[precision - 1]) {
+			e--;		// log10 was rounded up
+			continue;
+		}
+		if (scaled >= powersOf10[precision]) {
+			e++;
+			continue;
+		}
+		const double intpart = floor(scaled);
+		const double fraction = scaled - intpart;
+		// scaled < 10^9, so its absolute error is below 1.2e-7
+		if (fabs(fraction - 0.5) < 1e-6) {
+			return false;
+		}
+		unsigned long long n = (unsigned long long) intpart + ((fraction > 0.5) ? 1 : 0);
+		if (n == (unsigned long long) powersOf10[precision]) {
+			n /= 10;
+			e++;
+		}
+		digits = n;
+		exponent = e;
+		return true;
+	}
+	return false;
+}
+
+// digits with the decimal point placed before the last "decimals" digits (leading
+// zeros are added as needed), trailing zeros of the fraction removed if trimZeros is set
+static unsigned int writeDecimal(char * buf, unsigned long long n, int decimals, bool trimZeros)
+{
+	if (trimZeros) {
+		while (decimals && n && (n % 10 == 0)) {
+			n /= 10;
+			decimals--;
+		}
+		if (!n) decimals = 0;
+	}
+	// collect the digits from right to left
+	char tmp[48];
+	int len = 0;
+	do {
+		tmp[len++] = (char) ('0' + (n % 10));
+		n /= 10;
+		if (len == decimals) tmp[len++] = '.';
+	} while (n || (decimals && (len <= decimals + 1)));
+
+	unsigned int pos = 0;
+	while (len > 0) buf[pos++] = tmp[--len];
+	buf[pos] = 0;
+	return pos;
+}
+
+// mantissa digits as d.ddd (without trailing zeros) followed by e+XX
+static unsigned int writeExponential(char * buf, unsigned long long digits, int precision, int exponent)
+{
+	unsigned int pos = writeDecimal(buf, digits, precision - 1, true);
+	buf[pos++] = 'e';
+	if (exponent < 0) {
+		buf[pos++] = '-';
+		exponent = -exponent;
+	} else {
+		buf[pos++] = '+';
+	}
+	if (exponent < 10) buf[pos++] = '0';
+	return pos + writeUnsigned(buf + pos, (unsigned long long) exponent);
+}
+
+unsigned int formatInteger(char * buf, long value)
+{
+	if (value < 0) {
+		buf[0] = '-';
+		return 1 + writeUnsigned(buf + 1, 0 - (unsigned long long) value);
+	}
+	return writeUnsigned(buf, (unsigned long long) value);
+}
+
+unsigned int formatGeneral(char * buf, double value, int precision)
+{
+	if (precision <= 0) precision = 1;
+	if (precision > 17) precision = 17;
+	const bool negative = signBitSet(value);
+	unsigned int pos = 0;
+	if (value == 0.0) {
+		if (negative) buf[pos++] = '-';
+		buf[pos++] = '0';
+		buf[pos] = 0;
+		return pos;
+	}
+	unsigned long long digits;
+	int exponent;
+	const double magnitude = fabs(value);
+	if ((precision > 9) || (value != value) || (magnitude > 1.0e308) || !roundToSignificant(magnitude, precision, digits, exponent)) {
+		// nan is != nan
+		return formatWithPrintf(buf, numberBufferSize, "%.*g", precision, value);
+	}
+	if (negative) buf[pos++] = '-';
+	if ((exponent < -4) || (exponent >= precision)) {
+		return pos + writeExponential(buf + pos, digits, precision, exponent);
+	}
+	return pos + writeDecimal(buf + pos, digits, precision - 1 - exponent, true);
+}
+
+unsigned int formatFixed(char * buf, double value, int digits)
+{
+	if (digits < 0) digits = 0;
+	if (digits > 17) digits = 17;
+	const double magnitude = fabs(value);
+	const double scaled = (digits <= 9) ? magnitude * powersOf10[digits] : 1e300;
+	if (scaled < 1e15) {
+		const double intpart = floor(scaled);
+		const double fraction = scaled - intpart;
+		// the only rounding error is that of the multiplication
+		if (fabs(fraction - 0.5) > scaled * 4.5e-16) {
+			unsigned int pos = 0;
+			if (signBitSet(value)) buf[pos++] = '-';
+			return pos + writeDecimal(buf + pos, (unsigned long long) intpart + ((fraction > 0.5) ? 1 : 0), digits, false);
+		}
+	}
+	const unsigned int len = formatWithPrintf(buf, numberBufferSize, "%.*f", digits, value);
+	return len ? len : formatGeneral(buf, value, 17);
+}
+
+// whether the decimal number digits * 10^exponent reads back as value
+static bool readsBackAs(unsigned long long digits, int exponent, float value)
+{
+	const double magnitude = fabs((double) value);
+	if ((exponent >= -22) && (exponent <= 22) && (magnitude > 1e-37)) {
+		// digits < 10^9 and 10^|exponent| are exact, so candidate is correctly rounded
+		const double candidate = (exponent < 0) ? digits / powersOf10[-exponent] : digits * powersOf10[exponent];
+		// converting this to float could round differently than the decimal number itself
+		// only if candidate is (nearly) in the middle between two floats
+		int e;
+		const double mantissa = ldexp(frexp(candidate, &e), 24);
+		const double fraction = mantissa - floor(mantissa);
+		if (fabs(fraction - 0.5) > 1.0 / (1 << 20)) {
+			return (float) candidate == (float) magnitude;
+		}
+	}
+	// no decimal point, so strtof is not affected by the locale
+	char text[numberBufferSize];
+	unsigned int len = writeUnsigned(text, digits);
+	text[len++] = 'e';
+	(void) formatInteger(text + len, exponent);
+	return strtof(text, 0) == (float) magnitude;
+}
+
+unsigned int formatShortest(char * buf, float value)
+{
+	const double magnitude = fabs((double) value);
+	if ((value != value) || (magnitude > 3.5e38)) {
+		return formatWithPrintf(buf, numberBufferSize, "%.*g", 9, value);	// nan, inf
+	}
+	unsigned int pos = 0;
+	if (signBitSet(value)) buf[pos++] = '-';
+	if (value == 0.0f) {
+		buf[pos++] = '0';
+		buf[pos] = 0;
+		return pos;
+	}
+	unsigned long long digits = 0;
+	int exponent = 0;
+	// Two different decimals with 6 (FLT_DIG) digits never read back as the same normal float.
+	// So if the value rounded to 6 digits reads back correctly, that without its trailing
+	// zeros is the shortest text, otherwise 7 to 9 digits are needed.
+	int precision = (magnitude >= 1.17549435e-38) ? 6 : 1;
+	for (; precision <= 9; precision++) {
+		if (!roundToSignificant(magnitude, precision, digits, exponent)) {
+			// get the digits from printf (d.ddddde+XX)
+			char text[numberBufferSize];
+			(void) formatWithPrintf(text, numberBufferSize, "%.*e", precision - 1, magnitude);
+			digits = 0;
+			const char * p = text;
+			for (; *p && (*p != 'e'); p++) {
+				if ((*p >= '0') && (*p <= '9')) digits = digits * 10 + (unsigned long long) (*p - '0');
+			}
+			exponent = *p ? atoi(p + 1) : 0;
+		}
+		// 9 digits are always enough for a float
+		if ((precision == 9) || readsBackAs(digits, exponent - precision + 1, value)) {
+			break;
+		}
+	}
+	while ((precision > 1) && (digits % 10 == 0)) {
+		digits /= 10;
+		precision--;
+	}
+	if ((exponent < -4) || (exponent >= 9)) {
+		return pos + writeExponential(buf + pos, digits, precision, exponent);
+	}
+	// 9 digits before the decimal point are possible here, so use digits * 10^k for integral results
+	if (exponent >= precision) {
+		for (int i = precision; i <= exponent; i++) {
+			digits *= 10;
+		}
+		return pos + writeUnsigned(buf + pos, digits);
+	}
+	return pos + writeDecimal(buf + pos, digits, precision - 1 - exponent, true);
+}
+
+long long quantizeDecimal(double value, int digits)
+{
+	if (digits < 0) digits = 0;
+	if (digits > 9) digits = 9;
+	double v = value * powersOf10[digits];
+	if (v > 9.0e18) v = 9.0e18; // stay within the range of long long
+	if (v < -9.0e18) v = -9.0e18;
+	const double magnitude = fabs(v);
+	const double intpart = floor(magnitude);
+	const double fraction = magnitude - intpart;
+	// as in formatFixed: close to a tie the rounding error of the multiplication
+	// matters, printf rounds the exact binary value (halves to even)
+	if ((magnitude >= 1e15) || (fabs(fraction - 0.5) > magnitude * 4.5e-16)) {
+		const long long n = (long long) intpart + ((fraction > 0.5) ? 1 : 0);
+		return (v < 0.0) ? -n : n;
+	}
+	char buf[numberBufferSize];
+	const unsigned int len = formatWithPrintf(buf, numberBufferSize, "%.*f", digits, value);
+	long long n = 0;
+	for (unsigned int i = 0; i < len; i++) {
+		if ((buf[i] >= '0') && (buf[i] <= '9')) {
+			n = n * 10 + (buf[i] - '0');
+		}
+	}
+	return (v < 0.0) ? -n : n;
+}
+
+unsigned int formatQuantized(char * buf, long long value, int digits, bool trimZeros)
+{
+	if (digits < 0) digits = 0;
+	if (digits > 9) digits = 9;
+	unsigned int pos = 0;
+	if (value < 0) buf[pos++] = '-';
+	const unsigned long long n = (value < 0) ? 0 - (unsigned long long) value : (unsigned long long) value;
+	return pos + writeDecimal(buf + pos, n, digits, trimZeros);
 }
 
 
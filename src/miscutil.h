@@ -86,22 +86,95 @@ inline char *cppstrdup(const char * const src, const size_t addon = 0)
 // DLLEXPORT char * cppstrndup(const char * src, unsigned int length, unsigned int addon = 0);
 DLLEXPORT unsigned short hextoint(const char hexchar) ;
 
-// A temporary file, that is automatically removed after usage
+// A temporary file, that is automatically removed after usage.
+// The data are kept in memory and are moved to an anonymous file on disk only
+// if they exceed TempFile::memoryLimit bytes.
+class TempFileBuffer;
 class  TempFile  {
 public:
 	DLLEXPORT TempFile()  ;
 	DLLEXPORT ~TempFile() ;
-	DLLEXPORT ofstream & asOutput();
-	DLLEXPORT ifstream & asInput();
+	DLLEXPORT ostream & asOutput();	// discards the previous contents
+	DLLEXPORT istream & asInput();	// reads from the beginning
+	DLLEXPORT void copyTo(ostream & outfile);	// like copy_file(asInput(), outfile) but without rereading data from memory
+	static DLLEXPORT void setMemoryLimit(unsigned long bytes);
 private:
-	void close() ;
-	char * tempFileName;
-	ofstream outFileStream;
-	ifstream inFileStream;
+	TempFileBuffer * buffer;
+	ostream outStream;
+	istream inStream;
 
 	NOCOPYANDASSIGN(TempFile)
 };
 
+// A large output buffer that is put in front of the streambuf of an existing ostream
+// for its lifetime. Unlike the buffer of a filebuf it ignores sync requests, so endl
+// and flush on the stream just write a newline (resp. nothing) instead of causing one
+// write call per line. The data are passed on when the buffer is full, on flush()
+// and in the destructor, which also gives the stream its original streambuf back.
+class DLLEXPORT BufferedOutput : public streambuf {
+public:
+	explicit BufferedOutput(ostream & stream_p, size_t size = 256 * 1024);
+	~BufferedOutput();
+	void flush();				// pass the buffered data on and sync the target
+protected:
+	int_type overflow(int_type ch);
+	streamsize xsputn(const char * s, streamsize n);
+	int sync() { return 0; }
+	pos_type seekoff(off_type off, ios_base::seekdir dir, ios_base::openmode which);
+	pos_type seekpos(pos_type pos, ios_base::openmode which);
+private:
+	bool writeBuffer();
+	ostream & stream;
+	streambuf * target;
+	char * const buffer;
+	const size_t size;
+
+	NOCOPYANDASSIGN(BufferedOutput)
+};
+
+// Number to text conversion for the backends. The functions write into a buffer
+// given by the caller, do not allocate, always use '.' as decimal point independent
+// of any locale and return the number of characters written (the text is also 0
+// terminated). buf must hold at least numberBufferSize chars.
+const unsigned int numberBufferSize = 32;
+// like printf("%ld") resp. out << value
+DLLEXPORT unsigned int formatInteger(char * buf, long value);
+// like printf("%.*g") resp. out << setprecision(precision) << value - precision 6 is
+// the default of streams, so formatGeneral(buf, x) gives the same as out << x
+DLLEXPORT unsigned int formatGeneral(char * buf, double value, int precision = 6);
+// like printf("%.*f") resp. out << fixed << setprecision(digits) << value for
+// digits 0..17. Values whose text would not fit into numberBufferSize chars are
+// written as by formatGeneral(buf, value, 17).
+DLLEXPORT unsigned int formatFixed(char * buf, double value, int digits);
+// the shortest text that reads back as exactly the same float: plain decimal for
+// 1e-4 <= |value| < 1e9, otherwise with exponent (1.5e+12)
+DLLEXPORT unsigned int formatShortest(char * buf, float value);
+// For backends that work on a fixed grid: value * 10^digits rounded to the nearest
+// integer, clamped to the range of long long. digits 0..9. Rounds like
+// printf("%.*f", digits, value), i.e. exact halves to even (2.5 -> 2, 0.125 -> 12)
+DLLEXPORT long long quantizeDecimal(double value, int digits);
+// writes a value from quantizeDecimal with "digits" decimals, without trailing zeros if trimZeros is set
+DLLEXPORT unsigned int formatQuantized(char * buf, long long value, int digits, bool trimZeros);
+
+// formatted number for stream expressions, e.g.  outf << NumberText(p.x_) << ' ';
+// Gives the same text as outf << p.x_ with the default settings of a stream
+// (the width, precision and flags of the stream are not used), but faster.
+class NumberText {
+public:
+	NumberText(int value) : length(formatInteger(text, value)) {}
+	NumberText(long value) : length(formatInteger(text, value)) {}
+	NumberText(double value, int precision = 6) : length(formatGeneral(text, value, precision)) {}
+	const char * c_str() const { return text; }
+	unsigned int size() const { return length; }
+private:
+	char text[numberBufferSize];
+	unsigned int length;
+};
+inline ostream & operator<<(ostream & out, const NumberText & number)
+{
+	return out.write(number.c_str(), number.size());
+}
+
 #ifdef HAVEAUTOPTR 
 #include <memory>
 #else
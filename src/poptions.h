@@ -203,6 +203,9 @@ public:
 	OptionBase * const * getOptionIterator() const { return &alloptions[0]; }
 	unsigned int numberOfOptions() const { return optcount; }
 	virtual bool hideFromDoku(const OptionBase& /* opt */ ) const { return false; } // some options may be hidden, i.e. debug only options
+	// for driver options: whether the driver seeks back in its output file when
+	// run with these options - such output cannot be compressed (-compress)
+	virtual bool repositionsOutput() const { return false; }
 
 
   protected:
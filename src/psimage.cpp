@@ -27,10 +27,12 @@
 #endif
 
 #include <cmath>
+#include <vector>
 
 #include "drvbase.h"
  
 #include "version.h"
+#include "runstats.h"
  
 #include I_iomanip
 
@@ -268,6 +270,299 @@ unsigned char PSImage::getComponent(unsigned int x, unsigned int y, char numComp
 }
 
 
+// for 1, 2 and 4 bits per sample: the 8 bit values of all samples packed into one byte
+struct SampleExpansionTables {
+	SampleExpansionTables() {
+		fill(bits1, 1);
+		fill(bits2, 2);
+		fill(bits4, 4);
+	}
+	const unsigned char * forBits(short int bits) const {
+		return (bits == 1) ? bits1 : ((bits == 2) ? bits2 : bits4);
+	}
+	unsigned char bits1[256 * 8];
+	unsigned char bits2[256 * 4];
+	unsigned char bits4[256 * 2];
+private:
+	static void fill(unsigned char * table, unsigned int bits) {
+		const unsigned int samplesPerByte = 8 / bits;
+		const unsigned int maxValue = (1U << bits) - 1U;
+		for (unsigned int byte = 0; byte < 256; byte++) {
+			for (unsigned int i = 0; i < samplesPerByte; i++) {
+				const unsigned int value = (byte >> (8 - bits * (i + 1))) & maxValue;
+				table[byte * samplesPerByte + i] = (unsigned char) (value * 255U / maxValue);
+			}
+		}
+	}
+};
+// built during static initialization, so it can be used from several threads
+static const SampleExpansionTables sampleExpansionTables;
+
+// all width * ncomp samples of row y, scaled to 8 bits the same way as getComponent does
+void PSImage::unpackSamples(unsigned int y, unsigned char * samples) const
+{
+	const unsigned int count = width * ncomp;
+	const unsigned long paddedBytesPerRow = ((unsigned long) bits * count + 7) / 8;
+	const unsigned char * src = data + paddedBytesPerRow * y;
+	switch (bits) {
+	case 1:
+	case 2:
+	case 4:{
+			const unsigned int samplesPerByte = 8 / bits;
+			const unsigned char * const table = sampleExpansionTables.forBits(bits);
+			unsigned int i = 0;
+			for (; i + samplesPerByte <= count; i += samplesPerByte) {
+				memcpy(samples + i, table + samplesPerByte * (*src++), samplesPerByte);
+			}
+			if (i < count) {
+				memcpy(samples + i, table + samplesPerByte * (*src), count - i);
+			}
+		}
+		break;
+	case 8:
+		memcpy(samples, src, count);
+		break;
+	case 12:
+		// most significant 8 bits - an even sample starts at a byte boundary,
+		// an odd one in the middle of a byte
+		for (unsigned int i = 0; i < count; i++) {
+			const unsigned int bytePos = (3 * i) / 2;
+			samples[i] = (i & 1) ? (unsigned char) ((src[bytePos] << 4) | (src[bytePos + 1] >> 4)) : src[bytePos];
+		}
+		break;
+	case 16:
+		for (unsigned int i = 0; i < count; i++) {
+			samples[i] = src[2 * i];
+		}
+		break;
+	default:
+		for (unsigned int i = 0; i < count; i++) {
+			samples[i] = getComponent(i / ncomp, y, (char) (i % ncomp));
+		}
+		break;
+	}
+}
+
+void PSImage::unpackRow(unsigned int y, unsigned char * dest, unsigned char * scratch, bool toGray) const
+{
+	if (isFileImage) {
+		cerr << "Image::unpackRow not yet supported for PNG File Image objects" << endl;
+		return;
+	}
+
+	assert(data != 0);
+	if ((ncomp == 1 && toGray) || (ncomp == 3 && !toGray)) {
+		unpackSamples(y, dest);
+		return;
+	}
+
+	unpackSamples(y, scratch);
+	const unsigned char * s = scratch;
+	for (unsigned int x = 0; x < width; x++) {
+		unsigned int r, g, b;
+		switch (ncomp) {
+		case 1:
+			r = g = b = *s++;
+			break;
+		case 3:
+			r = s[0];
+			g = s[1];
+			b = s[2];
+			s += 3;
+			break;
+		case 4:{
+				// account for key - see pslrm page 307
+				const unsigned int k = s[3];
+				r = 255 - min(255U, s[0] + k);
+				g = 255 - min(255U, s[1] + k);
+				b = 255 - min(255U, s[2] + k);
+				s += 4;
+			}
+			break;
+		default:
+			cerr << "\t\tFatal: unexpected case in image (line " << __LINE__ << ")" << endl;
+			abort();
+			return;
+		}
+		if (toGray) {
+			// ITU-R BT.601 weights, scaled by 256
+			*dest++ = (unsigned char) ((77 * r + 150 * g + 29 * b) >> 8);
+		} else {
+			*dest++ = (unsigned char) r;
+			*dest++ = (unsigned char) g;
+			*dest++ = (unsigned char) b;
+		}
+	}
+}
+
+// narrows [first, last) to the x for which lo <= start + x * step < hi
+static void clipSpan(double start, double step, double lo, double hi, long & first, long & last)
+{
+	if (step == 0.0) {
+		if (start < lo || start >= hi) {
+			last = first;
+		}
+		return;
+	}
+	double xFrom, xTo;
+	if (step > 0.0) {
+		xFrom = ceil((lo - start) / step);
+		xTo = ceil((hi - start) / step);
+	} else {
+		xFrom = floor((hi - start) / step) + 1.0;
+		xTo = floor((lo - start) / step) + 1.0;
+	}
+	if (xFrom > first) {
+		first = (xFrom < last) ? (long) xFrom : last;
+	}
+	if (xTo < last) {
+		last = (xTo > first) ? (long) xTo : first;
+	}
+}
+
+// sets the bits of the pixels [from, to) in a 1 bit per pixel row (msb first)
+static void setMaskBits(unsigned char * maskRow, long from, long to)
+{
+	for (long x = from; x < to; x++) {
+		maskRow[x >> 3] |= (unsigned char) (0x80 >> (x & 7));
+	}
+}
+
+void PSImage::resample(unsigned char * dest, long destScanlineLen, long destWidth, long destHeight,
+					   const Point & origin, float scale,
+					   unsigned char * mask, long maskScanlineLen) const
+{
+	if (isFileImage) {
+		cerr << "Image::resample not yet supported for PNG File Image objects" << endl;
+		return;
+	}
+
+	const float * const m = normalizedImageCurrentMatrix;
+	const double det = (double) m[0] * m[3] - (double) m[2] * m[1];
+	if ((det == 0.0) || (width == 0) || (height == 0)) {
+		return;
+	}
+	// inverse of normalizedImageCurrentMatrix - the linear part also undoes scale
+	const double inverse[] = {
+		m[3] / det / scale,
+		-m[1] / det / scale,
+		-m[2] / det / scale,
+		m[0] / det / scale,
+		((double) m[2] * m[5] - (double) m[4] * m[3]) / det,
+		((double) m[4] * m[1] - (double) m[0] * m[5]) / det
+	};
+	// source pixel i covers [i - 0.5, i + 0.5)
+	const double lowX = -0.5;
+	const double highX = width - 0.5;
+	const double lowY = -0.5;
+	const double highY = height - 0.5;
+
+	// 8 bit RGB rows are used as they are. Other rows are unpacked - all at once
+	// if the image is rotated or skewed, because then almost every destination
+	// pixel needs another source row, else when needed.
+	const unsigned long rowBytes = 3UL * width;
+	const bool directRows = (bits == 8) && (ncomp == 3);
+#ifdef _OPENMP
+	// small images are not worth starting threads for
+	const bool parallel = ((double) destWidth * destHeight >= 65536.0);
+#endif
+	std::vector<unsigned char> unpacked;
+	if (!directRows && (inverse[1] != 0.0)) {
+		unpacked.resize(rowBytes * height);
+#ifdef _OPENMP
+#pragma omp parallel if (parallel)
+#endif
+		{
+			std::vector<unsigned char> scratch(scratchSize());
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+			for (long y = 0; y < (long) height; y++) {
+				unpackRow((unsigned int) y, &unpacked[y * rowBytes], &scratch[0]);
+			}
+		}
+	}
+
+	// The destination rows are independent. With OpenMP each thread gets a
+	// contiguous block of them (schedule static) and has its own source row
+	// cache, so nothing is shared but the read only image and the output rows.
+#ifdef _OPENMP
+#pragma omp parallel if (parallel)
+#endif
+	{
+		std::vector<unsigned char> sourceRow(unpacked.empty() ? rowBytes : 0);
+		std::vector<unsigned char> scratch(unpacked.empty() ? scratchSize() : 0);
+		const unsigned char * row = 0;
+		long sourceRowNumber = -1;
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+		for (long y = 0; y < destHeight; y++) {
+			// source position of destination pixel (0, y) - it moves by
+			// inverse[0], inverse[1] per destination pixel
+			const double rowX = inverse[0] * origin.x_ + inverse[2] * (origin.y_ + y) + inverse[4];
+			const double rowY = inverse[1] * origin.x_ + inverse[3] * (origin.y_ + y) + inverse[5];
+			long first = 0;
+			long last = destWidth;
+			clipSpan(rowX, inverse[0], lowX, highX, first, last);
+			clipSpan(rowY, inverse[1], lowY, highY, first, last);
+
+			if (mask) {
+				unsigned char * const maskRow = mask + y * maskScanlineLen;
+				memset(maskRow, 0, maskScanlineLen);
+				setMaskBits(maskRow, 0, first);
+				setMaskBits(maskRow, last, destWidth);
+			}
+
+			double sourceX = rowX + first * inverse[0];
+			double sourceY = rowY + first * inverse[1];
+			unsigned char * out = dest + y * destScanlineLen + 3 * first;
+			for (long x = first; x < last; x++) {
+				// round to the nearest source pixel; clamping only catches
+				// rounding errors at the span ends
+				long ix = (long) (sourceX + 0.5);
+				long iy = (long) (sourceY + 0.5);
+				ix = (ix < 0) ? 0 : ((ix >= (long) width) ? (long) width - 1 : ix);
+				iy = (iy < 0) ? 0 : ((iy >= (long) height) ? (long) height - 1 : iy);
+				if (iy != sourceRowNumber) {
+					if (directRows) {
+						row = data + iy * rowBytes;
+					} else if (!unpacked.empty()) {
+						row = &unpacked[iy * rowBytes];
+					} else {
+						unpackRow((unsigned int) iy, &sourceRow[0], &scratch[0]);
+						row = &sourceRow[0];
+					}
+					sourceRowNumber = iy;
+				}
+				const unsigned char *const rgb = row + 3 * ix;
+				*out++ = rgb[2];
+				*out++ = rgb[1];
+				*out++ = rgb[0];
+				sourceX += inverse[0];
+				sourceY += inverse[1];
+			}
+		}
+	}
+}
+
+void PSImage::allocateData()
+{
+	allocatedBytes = dataSize();
+	data = new unsigned char[allocatedBytes];
+	nextfreedataitem = 0;
+	MemoryStatistics::allocate(MemoryStatistics::images, allocatedBytes);
+}
+
+void PSImage::freeData()
+{
+	if (data) MemoryStatistics::release(MemoryStatistics::images, allocatedBytes);
+	delete[] data;
+	data = 0;
+	allocatedBytes = 0;
+	nextfreedataitem = 0;
+}
+
 void PSImage::calculateBoundingBox()
 {
 //  if (isFileImage) { 
@@ -45,12 +45,19 @@ public:
 	RSString FileName; // for PNG file images
 
 	PSImage(): type(colorimage),height(0),width(0),bits(0),ncomp(0),
-		polarity(true),data(0),nextfreedataitem(0),isFileImage(false),FileName("") 
+		polarity(true),data(0),nextfreedataitem(0),isFileImage(false),FileName(""),allocatedBytes(0) 
 		{ 
 			for (int i = 0; i < 6 ; i++) 
 				imageMatrix[i] = normalizedImageCurrentMatrix[i] = 0.0f;
 		}
-	~PSImage() { delete [] data; data = 0; nextfreedataitem = 0;}
+	~PSImage() { freeData(); }
+	// data for height rows of width samples, accounted to MemoryStatistics::images
+	void allocateData();
+	void freeData();
+	unsigned int dataSize() const { return height * ((ncomp * width * bits + 7) / 8); }
+private:
+	unsigned int allocatedBytes;	// of data
+public:
 	void writeEPSImage(ostream & outi) const;
 	void writeIdrawImage(ostream & outi, float scalefactor) const;
 //obsolete	void writePNGImage(const char * pngFileName, const char * source, const char * title, const char * generator) const;
@@ -62,7 +69,24 @@ public:
 						unsigned int x,
 						unsigned int y,
 						char	numComponent) const;
+	// unpacks a whole row at once - much faster than calling getComponent for each sample.
+	// dest gets 3 bytes (R G B) per pixel, or 1 byte (gray level) per pixel if toGray is set.
+	// CMYK is converted to RGB as r = 1 - min(1, c + k) (see PLRM).
+	// scratch is a buffer of scratchSize() bytes for the conversion, so that the
+	// caller can allocate it once for all rows.
+	void unpackRow(unsigned int y, unsigned char * dest, unsigned char * scratch, bool toGray = false) const;
+	unsigned long scratchSize() const { return (unsigned long) width * ncomp; }
+	// nearest neighbour resampling into a device space raster with 3 bytes (B G R) per pixel.
+	// Pixel (x, y) of dest shows the image at the device space point (origin + (x, y)) / scale.
+	// Pixels outside of the image are left unchanged and - if mask is given - get their bit
+	// (1 bit per pixel, msb first) set in mask, all other mask bits are cleared.
+	// When compiled with OpenMP the rows are filled by several threads.
+	void resample(unsigned char * dest, long destScanlineLen, long destWidth, long destHeight,
+				  const Point & origin, float scale,
+				  unsigned char * mask = 0, long maskScanlineLen = 0) const;
 private:
+	void unpackSamples(unsigned int y, unsigned char * samples) const;
+
 	// Bounding Box
 	Point ll;
 	Point ur;
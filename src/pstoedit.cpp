@@ -41,6 +41,9 @@
 #include "version.h"
 
 #include "drvbase.h"
+#include "compressedoutput.h"
+#include "runstats.h"
+#include "dumpcache.h"
 
 #ifndef UPPVERSION
 #include "dynload.h"
@@ -224,6 +227,7 @@ public:
 	~Closer() {
 		if (fromgui) {
 			cerr << "Program finished, please press CR to close window\n";
+			(void) cerr.flush();
 			(void) cin.get();
 		}
 	}
@@ -386,6 +390,8 @@ extern "C" DLLEXPORT
 	closerObject.fromgui = (bool) options.fromgui;
 	if (options.ptioption) options.precisiontext = 1;
 	if (options.ptaoption) options.precisiontext = 2;
+	TempFile::setMemoryLimit(options.tempMemory < 0 ? 0UL : (unsigned long) options.tempMemory * 1024UL * 1024UL);
+	RunStatistics::enable(options.stats || (options.statsFile.value.length() > 0));
 
 	switch (remaining) {
 	case 0: { // use stdin and stdout
@@ -764,7 +770,8 @@ To get the pre 8.00 behaviour, either use -dNOEPS or run the file with (filename
 				nameOfOutputFilewithoutpercentD = cppstrdup(options.nameOfOutputFile, 20);	// reserve 20 chars for page number
 				sprintf_s(TARGETWITHLEN(nameOfOutputFilewithoutpercentD, strlen(options.nameOfOutputFile)+ 20) , options.nameOfOutputFile, 1);	//first page is page 1
 				if (currentDriverDesc->backendFileOpenType != DriverDescription::noopen) {
-					if (currentDriverDesc->backendFileOpenType == DriverDescription::binaryopen) {
+					if ((currentDriverDesc->backendFileOpenType == DriverDescription::binaryopen) ||
+						CompressedOutput::requested(options.compressOutput.value.value(), nameOfOutputFilewithoutpercentD)) {
 #if (defined(unix) || defined(__unix__) || defined(_unix) || defined(__unix) || defined(__EMX__) || defined (NetBSD)  ) && !defined(DJGPP)
 // binary is not available on UNIX, only on PC
 						outFile.open(nameOfOutputFilewithoutpercentD, ios::out);
@@ -865,6 +872,9 @@ To get the pre 8.00 behaviour, either use -dNOEPS or run the file with (filename
 			RSString gsoutName;
 			RSString gsout;
 			int gsresult = 0;
+			DumpCache dumpCache(options.dumpCacheDir.value.value(),
+								options.dumpCacheSize < 0 ? 0UL : (unsigned long) options.dumpCacheSize,
+								errstream, options.verbose);
 			if (options.backendonly) {
 				if ( outputdriver && !outputdriver->withbackend() ) {
 					errstream << "the -bo option cannot be used with this non native pstoedit driver" << endl;
@@ -1187,13 +1197,31 @@ To get the pre 8.00 behaviour, either use -dNOEPS or run the file with (filename
 				} else {
 					commandline.addarg(gsinfilename.value());
 				}
-				if (options.verbose)
-					errstream << "now calling the interpreter via: " << commandline << endl;
-				// gsresult = system(commandline);
-				gsresult = call_PI(commandline.argc, commandline.argv);
-				if (gsresult != 0) {
-					errstream << "PostScript/PDF Interpreter finished. Return status " << gsresult 
-					<< " executed command : " << commandline << endl;
+				bool cachedDump = false;
+				if (dumpCache.enabled()) {
+					if ((strcmp(options.nameOfInputFile, stdinFileName) == 0) || options.pngimage.value.value() || options.withdisplay) {
+						errstream << "the dump cache cannot be used with standard input, -pngimage or -dis" << endl;
+					} else {
+						const bool withFileImages =
+							(currentDriverDesc->backendDesiredImageFormat != DriverDescription::noimage) &&
+							(currentDriverDesc->backendDesiredImageFormat != DriverDescription::memoryeps);
+						if (dumpCache.computeKey(options.nameOfInputFile, gsin.value(), commandline, withFileImages)) {
+							cachedDump = dumpCache.fetch(gsout.value());
+						}
+					}
+				}
+				if (!cachedDump) {
+					if (options.verbose)
+						errstream << "now calling the interpreter via: " << commandline << endl;
+					// gsresult = system(commandline);
+					{
+						const StatisticsSpan span(RunStatistics::interpreter);
+						gsresult = call_PI(commandline.argc, commandline.argv);
+					}
+					if (gsresult != 0) {
+						errstream << "PostScript/PDF Interpreter finished. Return status " << gsresult 
+						<< " executed command : " << commandline << endl;
+					}
 				}
 				// ghostscript seems to return always 0, so
 				// check whether the normal end was reached by pstoedit.pro
@@ -1201,7 +1229,7 @@ To get the pre 8.00 behaviour, either use -dNOEPS or run the file with (filename
 					(void) remove(gsin.value());
 				//wogl free(gsin);
 				// if really returned !0 don't grep
-				if (!gsresult) {
+				if (!gsresult && !cachedDump) {
 					if (options.verbose)
 						errstream << "Now checking the temporary output" << endl;
 					gsresult = grep(successstring, gsout.value(), errstream);
@@ -1241,11 +1269,16 @@ To get the pre 8.00 behaviour, either use -dNOEPS or run the file with (filename
 						} else {
 							bbfilename = gsout.value();
 						}
+						// the page index of a cached dump saves the first pass
+						const bool cachedBBoxes = !options.useBBfrominput &&
+							dumpCache.pageIndex(drvbase::totalNumberOfPages(), drvbase::bboxes());
                             
-						yyin = fopen(bbfilename, "rb");	// ios::binary | ios::nocreate
-						if (!yyin) {
-								errstream << "Error opening file " << bbfilename << endl;
-								return 1;
+						if (!cachedBBoxes) {
+							yyin = fopen(bbfilename, "rb");	// ios::binary | ios::nocreate
+							if (!yyin) {
+									errstream << "Error opening file " << bbfilename << endl;
+									return 1;
+							}
 						}
 						
 						PSFrontEnd fe(outFile,
@@ -1254,11 +1287,18 @@ To get the pre 8.00 behaviour, either use -dNOEPS or run the file with (filename
 									  options.nameOfInputFile,
 									  options.nameOfOutputFile,
 									  currentDriverDesc, driveroptions, options.splitpages, outputdriver);
-						if (options.verbose)
-							errstream << "now reading BoundingBoxes from file " << bbfilename << endl;
-						/* outputdriver-> */ drvbase::totalNumberOfPages() =
-						fe.readBBoxes( /* outputdriver-> */ drvbase::bboxes());
-						fclose(yyin);
+						if (!cachedBBoxes) {
+							if (options.verbose)
+								errstream << "now reading BoundingBoxes from file " << bbfilename << endl;
+							{
+								const StatisticsSpan span(RunStatistics::readBBoxes);
+								/* outputdriver-> */ drvbase::totalNumberOfPages() =
+								fe.readBBoxes( /* outputdriver-> */ drvbase::bboxes());
+							}
+							fclose(yyin);
+							dumpCache.store(gsout.value(), options.useBBfrominput ? 0 : drvbase::bboxes(),
+											drvbase::totalNumberOfPages());
+						}
 						if (options.verbose) {
 							errstream << " got " <<	drvbase::totalNumberOfPages() << " page(s)" << endl;
 							for (unsigned int i = 0;  i < drvbase::totalNumberOfPages(); i++) {
@@ -1270,7 +1310,10 @@ To get the pre 8.00 behaviour, either use -dNOEPS or run the file with (filename
 							errstream << "now postprocessing the interpreter output" << endl;
 						
 						yyin = fopen(gsout.value(), "rb");
-						fe.run(options.mergelines);
+						{
+							const StatisticsSpan span(RunStatistics::frontend);
+							fe.run(options.mergelines);
+						}
 						// now we can close it in any case - since we took a copy
 						fclose(yyin);
 					}
@@ -1285,6 +1328,7 @@ To get the pre 8.00 behaviour, either use -dNOEPS or run the file with (filename
 				} else {
 					// outputdriver has no backend
 					// Debug or PostScript driver
+					dumpCache.store(gsout.value(), 0, 0);
 					ifstream gsoutStream(gsout.value()); 
 					if (options.verbose)
 						errstream << "now copying  '" << gsout << "' to '"
@@ -1305,6 +1349,12 @@ To get the pre 8.00 behaviour, either use -dNOEPS or run the file with (filename
 //  delete [] drivername;
 //  delete [] nameOfInputFile;
 //  delete [] nameOfOutputFile;
+	if (RunStatistics::enabled()) {
+		RunStatistics::report(errstream, options.statsFile.value.value());
+		RunStatistics::enable(false);
+	} else if (options.verbose) {
+		MemoryStatistics::print(errstream);
+	}
 	return 0;
 }
 
@@ -1446,6 +1496,29 @@ extern "C" DLLEXPORT int getPstoeditsetDLLUsage()
 
 extern void set_gs_write_callback(write_callback_type * new_cb);	// defined in callgsdllviaiapi.cpp
 
+static callbackBuffer cbBuffer(0, 0);// default /dev/null
+
+// cerr stays unit buffered: each output operation is passed to the callback
+// as one block (not character by character), so that progress messages reach
+// the caller at once and in order with the output of gs
+static void redirectCerrToCallback()
+{
+#if defined(HAVESTL) || defined(__OS2__)
+	(void)cerr.rdbuf(&cbBuffer);
+#else
+	cerr = &cbBuffer;
+#endif
+	cerr.setf(ios::unitbuf);
+}
+
+// with lent buffers the output of gs has to be copied into them as well
+static int __stdcall gsOutputToCallbackBuffer(void * /* cb_data */, const char * text, int length)
+{
+	const int written = (int) cbBuffer.sputn(text, length);
+	(void) cbBuffer.pubsync();
+	return written;
+}
+
 extern "C" DLLEXPORT void setPstoeditOutputFunction(void *cbData, write_callback_type * cbFunction)
 {
 	if (!versioncheckOK) {
@@ -1453,15 +1526,32 @@ extern "C" DLLEXPORT void setPstoeditOutputFunction(void *cbData, write_callback
 		return;
 	}
 
-	static callbackBuffer cbBuffer(0, 0);// default /dev/null
-
 	set_gs_write_callback(cbFunction);	// for the gswin.DLL
 	(void) cbBuffer.set_callback(cbData, cbFunction);
-#if defined(HAVESTL) || defined(__OS2__)
-	(void)cerr.rdbuf(&cbBuffer);
-#else
-	cerr = &cbBuffer;
-#endif
+	redirectCerrToCallback();
+}
+
+extern "C" DLLEXPORT void setPstoeditOutputBufferFunctions(void *cbData, get_buffer_callback_type * getBuffer, write_callback_type * bufferFilled)
+{
+	if (!versioncheckOK) {
+		errorMessage("wrong version of pstoedit");
+		return;
+	}
+
+	set_gs_write_callback(getBuffer ? gsOutputToCallbackBuffer : bufferFilled);	// for the gswin.DLL
+	cbBuffer.set_lending_callbacks(cbData, getBuffer, bufferFilled);
+	redirectCerrToCallback();
+}
+
+extern "C" DLLEXPORT void setPstoeditOutputChunkSize(int chunkSize)
+{
+	if (!versioncheckOK) {
+		errorMessage("wrong version of pstoedit");
+		return;
+	}
+	if (chunkSize > 0) {
+		cbBuffer.set_chunksize((unsigned int) chunkSize);
+	}
 }
 
 // END WINDOWS ONLY SECTION
@@ -127,6 +127,10 @@ void ignoreVersionCheck(void); /* not exported to the DLL interface, just used i
 #if defined(_WIN32) || defined(__OS2__)
 #include "cbstream.h"
 extern "C" DLLEXPORT void setPstoeditOutputFunction(void * cbData,write_callback_type* cbFunction);
+/* zero copy variant: getBuffer lends a buffer to pstoedit, which is handed back filled via bufferFilled */
+extern "C" DLLEXPORT void setPstoeditOutputBufferFunctions(void * cbData, get_buffer_callback_type* getBuffer, write_callback_type* bufferFilled);
+/* size of the chunks passed to the callback (default 16 KB) */
+extern "C" DLLEXPORT void setPstoeditOutputChunkSize(int chunkSize);
 
 //
 // under Windows we need to be able to switch between two modes of calling GS - 1 via DLL and 2 with EXE
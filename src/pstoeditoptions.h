@@ -200,6 +200,13 @@ public:
 
 	OptionT < Argv, ArgvExtractor > psArgs;				// Pass through arguments to PostScript interpreter
 	OptionT < int, IntValueExtractor > psLanguageLevel; 
+	OptionT < int, IntValueExtractor > tempMemory; // MB of temporary data that backends keep in memory
+	OptionT < RSString, RSStringValueExtractor > compressOutput; // gzip, zstd, none or "" (by suffix)
+	OptionT < int, IntValueExtractor > compressionLevel;
+	OptionT < bool, BoolTrueExtractor > stats;
+	OptionT < RSString, RSStringValueExtractor > statsFile; // JSON output of -stats
+	OptionT < RSString, RSStringValueExtractor > dumpCacheDir; // cache of interpreter outputs, "" for none
+	OptionT < int, IntValueExtractor > dumpCacheSize; // MB
 	OptionT < RSString, RSStringValueExtractor> drivername ;//= 0; // cannot be const char * because it is changed in pstoedit.cpp
 	OptionT < RSString, RSStringValueExtractor > gsregbase;
 	
@@ -355,7 +362,7 @@ public:
 		false),
 	verbose				(true, "-v",noArgument,b_t,"turns on verbose mode", 
 		"Switch on verbose mode. Some additional information is shown "
-		"during processing. ",
+		"during processing. At the end the peak memory use is shown as with -stats. ",
 		false),
 	useBBfrominput		(true, "-usebbfrominput",noArgument,g_t,"extract BoundingBox from input file rather than determining it during processing", 
 		"If specified, pstoedit uses the BoundingBox as is (hopefully) found in the input file instead of one that is calculated by its own. ",
@@ -556,6 +563,60 @@ public:
 		UseDefaultDoku,
 		3),
 
+	tempMemory			(true, "-tempmemory","megabytes", g_t, 
+		"size of temporary data (in MB) that backends keep in memory before moving it to a temporary file",
+		"Several backends collect parts of their output in a temporary buffer before writing it "
+		"to the output file. Up to the given size (default 32 MB) this buffer is kept in memory, "
+		"beyond that it is moved to an anonymous temporary file. \\Opt{-tempmemory 0} "
+		"always uses a temporary file.",
+		32),
+
+	compressOutput		(true, "-compress","method (gzip, zstd or none)", g_t, 
+		"compress the output file (default: by suffix of the output file name - .gz or .zst)",
+		"Compresses the output while it is written. By default this is done if the name of the "
+		"output file ends with .gz (gzip) or .zst (zstd). The backends themselves are not aware "
+		"of the compression. Backends that reposition in their output file (svm and pdf with "
+		"\\Opt{-flate}) or that write the output file themselves write it uncompressed.",
+		(const char *)""),
+
+	compressionLevel	(true, "-compresslevel","number", g_t, 
+		"compression level for -compress (gzip: 1-9, default 6; zstd: 1-19, default 3)",
+		UseDefaultDoku,
+		-1),
+
+	stats				(true, "-stats",noArgument,g_t,"print the time spent in the conversion stages and counters of the processed elements",
+		"Prints the time spent in the PostScript interpreter, in the two passes over its output, "
+		"in the path processing of pstoedit and in the functions of the backend (show\\_path, "
+		"show\\_text, ...) together with the number of processed bytes, tokens, paths, path elements, "
+		"merged paths, images, image bytes, text pieces and pages. The times are measured with a "
+		"monotonic clock and contain each other as shown by the indentation. The peak memory of the heap "
+		"and of the larger buffers of pstoedit (path elements, path arrays, image data, temporary files "
+		"and driver buffers) is shown as well, for the whole run and for each page. The heap is counted "
+		"only where the C library can tell the size of a block.",
+		false),
+
+	statsFile			(true, "-statsjson","file", g_t, 
+		"write the statistics of -stats as JSON to the given file (- for standard error)",
+		UseDefaultDoku,
+		(const char *)""),
+
+	dumpCacheDir		(true, "-dumpcache","directory", g_t, 
+		"keep the output of the PostScript interpreter in the given directory and reuse it",
+		"Keeps the output of the PostScript interpreter (incl. the image files created for the backend "
+		"and the page bounding boxes) in the given directory. A later conversion of the same input "
+		"with the same settings of the interpreter - these depend on the general options and on the "
+		"capabilities of the format, not on the options of the format - uses it instead of running "
+		"the interpreter again. The entries are found by a hash of the content of the input file, "
+		"the settings, the version of pstoedit and the interpreter program. The least recently used "
+		"entries are removed when the directory grows beyond \\Opt{-dumpcachesize}. The input cannot "
+		"be read from standard input and \\Opt{-pngimage} and \\Opt{-dis} are not supported.",
+		(const char *)""),
+
+	dumpCacheSize		(true, "-dumpcachesize","megabytes", g_t, 
+		"size limit (in MB) of the directory given by -dumpcache (default 512)",
+		UseDefaultDoku,
+		512),
+
 	drivername			(false,"-f","\"format[:options]\"",g_t,"target format identifier" , 
 		"target output format recognized by "
 		"\\Prog{pstoedit}.  Since other format drivers can be loaded dynamically, "
@@ -649,6 +710,13 @@ public:
 	ADD(backendonly);	
 	ADD(psArgs);	
 	ADD(psLanguageLevel);
+	ADD(tempMemory);
+	ADD(compressOutput);
+	ADD(compressionLevel);
+	ADD(stats);
+	ADD(statsFile);
+	ADD(dumpCacheDir);
+	ADD(dumpCacheSize);
 
 	ADD(drivername);
 	ADD(gsregbase);
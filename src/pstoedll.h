@@ -56,11 +56,15 @@ typedef void (clearPstoeditDriverInfo_plainC_func)(struct DriverDescription_S *
 
 #if defined(_WIN32) || defined(__OS2__)
 typedef int  (__stdcall write_callback_func) (void * cb_data, const char* text, int length);
+typedef char * (__stdcall get_buffer_callback_func) (void * cb_data, int * length);
 #else
 typedef int  (write_callback_func) (void * cb_data, const char* text, int length);
+typedef char * (get_buffer_callback_func) (void * cb_data, int * length);
 #endif
 
 typedef void (setPstoeditOutputFunction_func)(void * cbData, write_callback_func* cbFunction);
+typedef void (setPstoeditOutputBufferFunctions_func)(void * cbData, get_buffer_callback_func* getBuffer, write_callback_func* bufferFilled);
+typedef void (setPstoeditOutputChunkSize_func)(int chunkSize);
 typedef void (useCoutForDiag_func)(int flag); /* cannot use bool in C interfaces */
 
 #endif
@@ -0,0 +1,236 @@
+/*
+   runstats.cpp : This file is part of pstoedit
+   Timing, counters and memory use of the conversion stages (option -stats)
+
+   Copyright (C) 1993 - 2012 Wolfgang Glunz, wglunz35_AT_pstoedit.net
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+#include "runstats.h"
+
+#include I_fstream
+#include I_string_h
+#include <iomanip>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#include <sys/time.h>
+#endif
+
+bool RunStatistics::active = false;
+unsigned long long RunStatistics::counters[RunStatistics::numberOfCounters];
+unsigned long long RunStatistics::spanTime[RunStatistics::numberOfSpans];
+unsigned long long RunStatistics::spanCalls[RunStatistics::numberOfSpans];
+
+// names as printed, the indentation shows which span contains which
+static const char * const spanNames[RunStatistics::numberOfSpans] = {
+	"interpreter", "readBBoxes", "frontend", "  dumpPath", "    show_path", "  show_text",
+	"  show_image", "  clip_save_restore", "  open_page", "  close_page"
+};
+
+static const char * const counterNames[RunStatistics::numberOfCounters] = {
+	"dump_bytes", "tokens", "paths", "elements", "merged_paths", "images", "image_bytes",
+	"text_pieces", "pages"
+};
+
+void RunStatistics::enable(bool on)
+{
+	active = on;
+	MemoryStatistics::resetPeaks();
+	for (unsigned int c = 0; c < numberOfCounters; c++) counters[c] = 0;
+	for (unsigned int s = 0; s < numberOfSpans; s++) {
+		spanTime[s] = 0;
+		spanCalls[s] = 0;
+	}
+}
+
+unsigned long long RunStatistics::now()
+{
+#if defined(_WIN32)
+	static LARGE_INTEGER frequency = { 0 };
+	if (frequency.QuadPart == 0) (void) QueryPerformanceFrequency(&frequency);
+	LARGE_INTEGER counter;
+	(void) QueryPerformanceCounter(&counter);
+	const unsigned long long ticks = (unsigned long long) counter.QuadPart;
+	const unsigned long long perSecond = (unsigned long long) frequency.QuadPart;
+	return ticks / perSecond * 1000000000ULL + ticks % perSecond * 1000000000ULL / perSecond;
+#elif defined(CLOCK_MONOTONIC)
+	struct timespec ts;
+	(void) clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long) ts.tv_sec * 1000000000ULL + (unsigned long long) ts.tv_nsec;
+#else
+	// not monotonic, but the best there is
+	struct timeval tv;
+	(void) gettimeofday(&tv, 0);
+	return (unsigned long long) tv.tv_sec * 1000000000ULL + (unsigned long long) tv.tv_usec * 1000ULL;
+#endif
+}
+
+static double seconds(unsigned long long nanoseconds)
+{
+	return (double) nanoseconds / 1e9;
+}
+
+void RunStatistics::print(ostream & out)
+{
+	const ios::fmtflags oldflags = out.flags();
+	const streamsize oldprecision = out.precision();
+	out << "pstoedit statistics" << endl;
+	out << setiosflags(ios::fixed) << setprecision(6);
+	for (unsigned int s = 0; s < numberOfSpans; s++) {
+		if (!spanCalls[s]) continue;
+		out << "  " << setiosflags(ios::left) << setw(22) << spanNames[s] << resetiosflags(ios::left)
+			<< setw(12) << seconds(spanTime[s]) << " s " << setw(10) << spanCalls[s] << " calls" << endl;
+	}
+	const unsigned long long frontendTime = spanTime[frontend];
+	for (unsigned int c = 0; c < numberOfCounters; c++) {
+		out << "  " << setiosflags(ios::left) << setw(22) << counterNames[c] << resetiosflags(ios::left)
+			<< setw(12) << counters[c];
+		if ((c == paths) && frontendTime) {
+			out << "  (" << setprecision(0) << counters[c] / seconds(frontendTime) << " per second)" << setprecision(6);
+		} else if ((c == dumpBytes) && frontendTime) {
+			out << "  (" << setprecision(2) << counters[c] / 1e6 / seconds(frontendTime) << " MB per second)" << setprecision(6);
+		}
+		out << endl;
+	}
+	out.flags(oldflags);
+	out.precision(oldprecision);
+	MemoryStatistics::print(out);
+}
+
+void RunStatistics::writeJSON(ostream & out)
+{
+	const ios::fmtflags oldflags = out.flags();
+	const streamsize oldprecision = out.precision();
+	out << setiosflags(ios::fixed) << setprecision(6);
+	out << "{" << endl << "  \"spans\": {";
+	bool first = true;
+	for (unsigned int s = 0; s < numberOfSpans; s++) {
+		if (!spanCalls[s]) continue;
+		const char * name = spanNames[s];
+		while (*name == ' ') name++;
+		out << (first ? "" : ",") << endl << "    \"" << name << "\": { \"seconds\": " << seconds(spanTime[s])
+			<< ", \"calls\": " << spanCalls[s] << " }";
+		first = false;
+	}
+	out << endl << "  }," << endl << "  \"counters\": {";
+	for (unsigned int c = 0; c < numberOfCounters; c++) {
+		out << (c ? "," : "") << endl << "    \"" << counterNames[c] << "\": " << counters[c];
+	}
+	out << endl << "  }," << endl << "  \"memory\": ";
+	MemoryStatistics::writeJSON(out);
+	out << endl << "}" << endl;
+	out.flags(oldflags);
+	out.precision(oldprecision);
+}
+
+void RunStatistics::report(ostream & errstream, const char * jsonFileName)
+{
+	print(errstream);
+	if (!jsonFileName || !*jsonFileName) return;
+	if (strcmp(jsonFileName, "-") == 0) {
+		writeJSON(errstream);
+		return;
+	}
+	ofstream jsonFile(jsonFileName);
+	if (jsonFile.is_open()) {
+		writeJSON(jsonFile);
+	} else {
+		errstream << "could not open " << jsonFileName << " for writing statistics" << endl;
+	}
+}
+
+size_t MemoryStatistics::current[MemoryStatistics::numberOfSubsystems];
+size_t MemoryStatistics::peak[MemoryStatistics::numberOfSubsystems];
+size_t MemoryStatistics::pagePeak[MemoryStatistics::numberOfSubsystems];
+
+static const char * const subsystemNames[MemoryStatistics::numberOfSubsystems] = {
+	"heap", "path_elements", "path_arrays", "images", "temp_files", "driver"
+};
+
+struct PageMemory {
+	unsigned int pageNumber;
+	size_t peak[MemoryStatistics::numberOfSubsystems];
+};
+
+// a function local static, so that it exists whenever a page is closed
+static std::vector<PageMemory> & pageMemory()
+{
+	static std::vector<PageMemory> pages;
+	return pages;
+}
+
+void MemoryStatistics::beginPage()
+{
+	for (unsigned int s = 0; s < numberOfSubsystems; s++) pagePeak[s] = current[s];
+}
+
+void MemoryStatistics::endPage(unsigned int pageNumber)
+{
+	PageMemory page;
+	page.pageNumber = pageNumber;
+	for (unsigned int s = 0; s < numberOfSubsystems; s++) page.peak[s] = pagePeak[s];
+	pageMemory().push_back(page);
+}
+
+void MemoryStatistics::resetPeaks()
+{
+	for (unsigned int s = 0; s < numberOfSubsystems; s++) peak[s] = pagePeak[s] = current[s];
+	pageMemory().clear();
+}
+
+void MemoryStatistics::print(ostream & out)
+{
+	const ios::fmtflags oldflags = out.flags();
+	out << "peak memory (bytes)" << endl;
+	for (unsigned int s = 0; s < numberOfSubsystems; s++) {
+		out << "  " << setiosflags(ios::left) << setw(22) << subsystemNames[s] << resetiosflags(ios::left)
+			<< setw(12) << peak[s];
+		if ((s == heap) && !peak[s]) out << "  (not counted in this program)";
+		out << endl;
+	}
+	const std::vector<PageMemory> & pages = pageMemory();
+	for (size_t p = 0; p < pages.size(); p++) {
+		out << "  page " << setiosflags(ios::left) << setw(17) << pages[p].pageNumber << resetiosflags(ios::left);
+		for (unsigned int s = 0; s < numberOfSubsystems; s++) {
+			out << " " << subsystemNames[s] << "=" << pages[p].peak[s];
+		}
+		out << endl;
+	}
+	out.flags(oldflags);
+}
+
+void MemoryStatistics::writeJSON(ostream & out)
+{
+	out << "{" << endl << "    \"peak\": {";
+	for (unsigned int s = 0; s < numberOfSubsystems; s++) {
+		out << (s ? "," : "") << endl << "      \"" << subsystemNames[s] << "\": " << peak[s];
+	}
+	out << endl << "    }," << endl << "    \"pages\": [";
+	const std::vector<PageMemory> & pages = pageMemory();
+	for (size_t p = 0; p < pages.size(); p++) {
+		out << (p ? "," : "") << endl << "      { \"page\": " << pages[p].pageNumber;
+		for (unsigned int s = 0; s < numberOfSubsystems; s++) {
+			out << ", \"" << subsystemNames[s] << "\": " << pages[p].peak[s];
+		}
+		out << " }";
+	}
+	out << endl << "    ]" << endl << "  }";
+}
@@ -0,0 +1,150 @@
+#ifndef RUNSTATS_H
+#define RUNSTATS_H
+/*
+   runstats.h : This file is part of pstoedit
+   Timing, counters and memory use of the conversion stages (option -stats)
+
+   Copyright (C) 1993 - 2012 Wolfgang Glunz, wglunz35_AT_pstoedit.net
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+#ifndef cppcomp_h
+#include "cppcomp.h"
+#endif
+
+#include I_iostream
+USESTD
+
+#include <stddef.h>
+
+// Collects where the time of a conversion goes. Spans are measured with a
+// monotonic clock and nest: frontend contains the lexing and everything the
+// backend does, dumpPath contains the show_path/show_rectangle calls of the
+// driver. While the statistics are disabled (the default) spans and counters
+// cost only the test of a flag.
+class DLLEXPORT RunStatistics {
+public:
+	enum Span {
+		interpreter,	// call_PI - Ghostscript incl. the prolog
+		readBBoxes,		// first pass over the dump
+		frontend,		// PSFrontEnd::run - second pass incl. the backend
+		dumpPath,		// drvbase path processing (merge, rearrange) incl. show_path
+		show_path,		// also show_rectangle
+		show_text,
+		show_image,
+		clip_save_restore,	// ClipPath, Save and Restore
+		open_page,
+		close_page,
+		numberOfSpans
+	};
+	enum Counter {
+		dumpBytes,		// bytes of the dump scanned by the lexer
+		tokens,			// lexer tokens
+		paths,			// paths passed to the driver
+		elements,		// elements of these paths
+		mergedPaths,	// pairs of fill and stroke merged into one (-mergelines)
+		images,
+		imageBytes,
+		textPieces,		// text pieces passed to the driver
+		pages,
+		numberOfCounters
+	};
+
+	// enabling also resets all spans and counters
+	static void enable(bool on);
+	static bool enabled() { return active; }
+
+	static void count(Counter c, unsigned long n = 1) { if (active) counters[c] += n; }
+	static unsigned long long value(Counter c) { return counters[c]; }
+	static void addSpan(Span s, unsigned long long nanoseconds) { spanTime[s] += nanoseconds; spanCalls[s]++; }
+	// monotonic clock in nanoseconds, only differences are meaningful
+	static unsigned long long now();
+
+	// human readable table
+	static void print(ostream & out);
+	static void writeJSON(ostream & out);
+	// print the table to errstream and, if jsonFileName is given, write the
+	// JSON to that file ("-" for errstream)
+	static void report(ostream & errstream, const char * jsonFileName);
+
+private:
+	static bool active;
+	static unsigned long long counters[numberOfCounters];
+	static unsigned long long spanTime[numberOfSpans];
+	static unsigned long long spanCalls[numberOfSpans];
+};
+
+// measures the lifetime of the object as one call of the span
+class StatisticsSpan {
+public:
+	explicit StatisticsSpan(RunStatistics::Span span_p) :
+		span(span_p), measure(RunStatistics::enabled()), start(measure ? RunStatistics::now() : 0) {}
+	~StatisticsSpan() {
+		if (measure) RunStatistics::addSpan(span, RunStatistics::now() - start);
+	}
+private:
+	const RunStatistics::Span span;
+	const bool measure;
+	const unsigned long long start;
+
+	StatisticsSpan(const StatisticsSpan &); // not defined
+	const StatisticsSpan & operator = (const StatisticsSpan &); // not defined
+};
+
+// Bytes held by the larger allocations of a conversion, by subsystem, with
+// their peaks over the run and over each page. The subsystems account their
+// buffers themselves; the heap as a whole is counted by the global operator
+// new of the pstoedit program (cmdmain.cpp) where the platform can tell the
+// size of a block. Accounting is always on (a few additions per allocation),
+// it is reported with -stats and -v.
+class DLLEXPORT MemoryStatistics {
+public:
+	enum Subsystem {
+		heap,			// everything allocated by operator new
+		pathElements,	// moveto, lineto, ... created by the lexer
+		pathArrays,		// the fixed element arrays of the PathInfos and the number stack
+		images,			// PSImage::data
+		tempFiles,		// TempFile chunks kept in memory
+		driver,			// buffers of the drivers, e.g. the PNG rows of the laos driver
+		numberOfSubsystems
+	};
+
+	static void allocate(Subsystem s, size_t bytes) {
+		current[s] += bytes;
+		if (current[s] > peak[s]) peak[s] = current[s];
+		if (current[s] > pagePeak[s]) pagePeak[s] = current[s];
+	}
+	static void release(Subsystem s, size_t bytes) { current[s] -= bytes; }
+	static size_t peakBytes(Subsystem s) { return peak[s]; }
+
+	// called by drvbase when a page is opened and closed
+	static void beginPage();
+	static void endPage(unsigned int pageNumber);
+	// peaks start again from what is allocated now, the page peaks are dropped
+	static void resetPeaks();
+
+	static void print(ostream & out);
+	// a JSON object, indented to be part of the RunStatistics JSON
+	static void writeJSON(ostream & out);
+
+private:
+	static size_t current[numberOfSubsystems];
+	static size_t peak[numberOfSubsystems];
+	static size_t pagePeak[numberOfSubsystems];
+};
+
+#endif